@@ -0,0 +1,135 @@
+#include "BlockRing.hpp"
+
+#include <algorithm>
+
+
+
+BlockRing::BlockRing(std::size_t slots, std::size_t slot_size)
+	: m_buffers(slots)
+	, m_slotSize(slot_size)
+	, m_slots(slots)
+{
+	m_free.reserve(slots);
+	m_filled.reserve(slots);
+	for (std::size_t i = 0; i < slots; ++i)
+	{
+		m_slots[i] = {nullptr, 0, 0, 0, 0, false, false};
+		m_free.push_back(&m_slots[i]);
+	}
+}
+
+
+
+BlockRing::Slot*
+BlockRing::AcquireFree()
+{
+	Slot* slot = nullptr;
+	{
+		std::unique_lock lock{m_lock};
+		m_freeCv.wait(lock, [this]{ return m_isClosed or not m_free.empty(); });
+		if (m_isClosed) { return nullptr; }
+
+		slot = m_free.back();
+		m_free.pop_back();
+	}
+	//NOTE: the released slots are taken first (m_free is a stack), so the
+	// buffers are allocated only when the reader is ahead of the Workers.
+	// They aren't zero-filled: the reader overwrites them.
+	if (not slot->data)
+	{
+		std::unique_ptr<uint8_t[]>& buffer = m_buffers[static_cast<std::size_t>(slot - m_slots.data())];
+		buffer.reset(new uint8_t[m_slotSize]);
+		slot->data = buffer.get();
+	}
+	return slot;
+}
+
+
+
+void
+BlockRing::Publish(Slot& slot)
+{
+	{
+		std::lock_guard lock{m_lock};
+		m_filled.push_back(&slot);
+	}
+	//NOTE: the Workers wait for the different slots (see AcquireNext)
+	m_filledCv.notify_all();
+}
+
+
+
+void
+BlockRing::Finish()
+{
+	{
+		std::lock_guard lock{m_lock};
+		m_isFinished = true;
+	}
+	m_filledCv.notify_all();
+}
+
+
+
+template <typename Pred>
+BlockRing::Slot*
+BlockRing::TakeFilled(Pred pred)
+{
+	std::unique_lock lock{m_lock};
+	auto it = m_filled.end();
+	m_filledCv.wait(lock, [&]
+	{
+		it = std::find_if(m_filled.begin(), m_filled.end(), pred);
+		return m_isClosed or m_isFinished or it != m_filled.end();
+	});
+	if (m_isClosed or it == m_filled.end()) { return nullptr; }
+
+	Slot* const slot = *it;
+	m_filled.erase(it);
+	return slot;
+}
+
+
+
+BlockRing::Slot*
+BlockRing::AcquireFilled()
+{
+	return TakeFilled([](Slot const* slot) { return slot->offset == 0; });
+}
+
+
+
+BlockRing::Slot*
+BlockRing::AcquireNext(std::uint64_t block_num, std::size_t offset)
+{
+	return TakeFilled([=](Slot const* slot)
+	{
+		return slot->first_block == block_num and slot->offset == offset;
+	});
+}
+
+
+
+void
+BlockRing::Release(Slot& slot)
+{
+	{
+		std::lock_guard lock{m_lock};
+		m_free.push_back(&slot);
+	}
+	m_freeCv.notify_one();
+}
+
+
+
+void
+BlockRing::Close() noexcept
+{
+	{
+		std::lock_guard lock{m_lock};
+		m_isClosed = true;
+	}
+	m_freeCv.notify_all();
+	m_filledCv.notify_all();
+}
+
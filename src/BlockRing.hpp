@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+// The bounded ring of the block buffers between the reader of the input file
+// and the hashing Workers (see Config::IsPipeline). The buffer of a slot is
+// allocated when the slot is taken first: the reader takes a free slot, fills
+// it by the next blocks and publishes it; a Worker takes the oldest filled
+// slot, hashes it and releases it back. The reader waits while all slots are in use (the
+// backpressure), the Workers wait while there is nothing to hash.
+//
+// A block which is larger than a slot is read by pieces: the Worker which
+// takes the first piece of the block takes its next pieces (AcquireNext).
+class BlockRing
+{
+public:
+	// The slot is bounded by it, the larger blocks are split into pieces
+	static constexpr std::size_t MAX_SLOT_SIZE = 1024 * 1024;
+
+	struct Slot
+	{
+		uint8_t*      data;
+		std::uint64_t first_block;
+		std::size_t   count;   // the blocks in `data`
+		std::size_t   offset;  // the offset of the piece in the block
+		std::size_t   size;    // the bytes of the piece
+		bool          is_last; // the last piece of the block
+		bool          is_hole; // `data` isn't read: the blocks are zeros
+	};
+
+	BlockRing(BlockRing&&)                  = delete;
+	BlockRing(BlockRing const&)             = delete;
+	BlockRing& operator= (BlockRing&&)      = delete;
+	BlockRing& operator= (BlockRing const&) = delete;
+
+	BlockRing(std::size_t slots, std::size_t slot_size);
+	~BlockRing() = default;
+
+	std::size_t GetSlotSize() const noexcept { return m_slotSize; }
+
+	// The reader: returns nullptr when the ring is closed
+	Slot* AcquireFree();
+	void Publish(Slot&);
+	// No more slots will be published: the Workers stop when the ring is empty
+	void Finish();
+
+	// The Workers: returns the oldest filled slot which begins a block.
+	// Returns nullptr when the ring is finished and there are no such slots
+	// or when it is closed.
+	Slot* AcquireFilled();
+	// Returns the piece of the block `block_num` at `offset`. Returns nullptr
+	// when the ring is closed or finished without the piece.
+	Slot* AcquireNext(std::uint64_t block_num, std::size_t offset);
+	void Release(Slot&);
+
+	// Aborts the ring: the waiting threads are woken up
+	void Close() noexcept;
+
+private:
+	template <typename Pred>
+	Slot* TakeFilled(Pred);
+
+	std::vector<std::unique_ptr<uint8_t[]>> m_buffers; // of the slots, allocated lazily
+	std::size_t             m_slotSize;
+	std::vector<Slot>       m_slots;
+	std::vector<Slot*>      m_free;
+	std::vector<Slot*>      m_filled; // in the order of publishing
+	bool                    m_isFinished  = false;
+	bool                    m_isClosed    = false;
+
+	std::mutex              m_lock;
+	std::condition_variable m_freeCv;
+	std::condition_variable m_filledCv;
+};
+
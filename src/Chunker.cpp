@@ -0,0 +1,96 @@
+#include "Chunker.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "common/Logger.hpp"
+
+
+
+namespace {
+
+// The Gear table is 256 random 64-bit numbers (splitmix64), it is fixed
+// because the boundaries of the chunks are a part of the signature
+constexpr std::array<uint64_t, 256>
+MakeGearTable()
+{
+	std::array<uint64_t, 256> table {};
+	uint64_t seed = 0x5EED5EED5EED5EEDull;
+	for (uint64_t& v : table)
+	{
+		uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		v = z ^ (z >> 31);
+	}
+	return table;
+}
+
+alignas(64) constexpr std::array<uint64_t, 256> GEAR = MakeGearTable();
+
+
+
+// Returns the first position in [from, to) whose hash has the `mask` bits
+// equal to zero or `to`
+//NOTE: the gather-based AVX2/AVX-512 variants (a lane per position or per
+// region) are not faster than this loop: the Gear values are loaded by the
+// gathers, which cost more than the scalar loads and the shift-add chain.
+std::size_t
+Scan(uint8_t const* data, std::size_t from, std::size_t to, uint64_t mask)
+{
+	uint64_t h = 0;
+	for (std::size_t i = (from > Chunker::WINDOW_SIZE) ? from - Chunker::WINDOW_SIZE : 0; i < from; ++i)
+	{
+		h = (h << 1) + GEAR[data[i]];
+	}
+	for (std::size_t p = from; p < to; ++p)
+	{
+		h = (h << 1) + GEAR[data[p]];
+		if ((h & mask) == 0) { return p; }
+	}
+	return to;
+}
+
+
+
+// The mask of the `bits` highest bits: they depend on all bytes of the window
+constexpr uint64_t
+HighBits(unsigned bits)
+{
+	return ~uint64_t{0} << (64 - bits);
+}
+
+} // namespace
+
+
+
+Chunker::Chunker(std::size_t min, std::size_t avg, std::size_t max)
+	: m_min(min)
+	, m_avg(avg)
+	, m_max(max)
+{
+	if (not (MIN_SIZE <= m_min and m_min <= m_avg and m_avg <= m_max))
+	{
+		THROW_ERROR("%s: invalid chunk sizes: min=%zu avg=%zu max=%zu (expected %zu <= min <= avg <= max)",
+			__FUNCTION__, m_min, m_avg, m_max, MIN_SIZE);
+	}
+	// the average size is rounded down to a power of two
+	unsigned const bits = 63 - static_cast<unsigned>(__builtin_clzll(m_avg));
+	m_maskHard = HighBits(bits + 1);
+	m_maskEasy = HighBits(bits - 1);
+}
+
+
+
+std::size_t
+Chunker::FindCut(uint8_t const* data, std::size_t size) const noexcept
+{
+	if (size <= m_min) { return size; }
+	std::size_t const end = std::min(size, m_max);
+	std::size_t const avg = std::min(end, m_avg);
+
+	// a cut after the position `p` makes the chunk of `p + 1` bytes
+	std::size_t const p = Scan(data, m_min - 1, avg - 1, m_maskHard);
+	if (p < avg - 1) { return p + 1; }
+	return Scan(data, avg - 1, end - 1, m_maskEasy) + 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+// Content-defined chunking (FastCDC with the normalized chunking): a cut is
+// made after the byte whose Gear hash has the masked bits equal to zero. The
+// harder mask (`bits + 1` bits) is used before the average size and the
+// easier one (`bits - 1` bits) after it, so the sizes gather around the
+// average; the chunks are never shorter than `min` and longer than `max`.
+//
+// The Gear hash of a position is a function of the last 64 bytes only
+// (h = (h << 1) + GEAR[byte] shifts the older bytes out), so a boundary
+// depends on the content and the previous boundary only: two chunkings which
+// share one boundary share all the next ones. It is used to resynchronize the
+// chunkings of the file segments at their seams.
+class Chunker
+{
+public:
+	static constexpr std::size_t WINDOW_SIZE = 64;
+	static constexpr std::size_t MIN_SIZE    = WINDOW_SIZE;
+
+	Chunker(Chunker&&)                  = delete;
+	Chunker(Chunker const&)             = delete;
+	Chunker& operator= (Chunker&&)      = delete;
+	Chunker& operator= (Chunker const&) = delete;
+
+	Chunker(std::size_t min, std::size_t avg, std::size_t max);
+	~Chunker() = default;
+
+	std::size_t GetMin() const noexcept { return m_min; }
+	std::size_t GetAvg() const noexcept { return m_avg; }
+	std::size_t GetMax() const noexcept { return m_max; }
+
+	// Returns the length of the chunk which starts at `data`. `size` is the
+	// number of the available bytes: GetMax() or the rest of the file.
+	std::size_t FindCut(uint8_t const* data, std::size_t size) const noexcept;
+
+private:
+	std::size_t m_min;
+	std::size_t m_avg;
+	std::size_t m_max;
+	uint64_t    m_maskHard;
+	uint64_t    m_maskEasy;
+};
@@ -1,5 +1,6 @@
 #include "Config.hpp"
 
+#include <algorithm>
 #include <array>
 #include <exception>
 #include <thread>
@@ -12,8 +13,13 @@
 
 #include "common/StringFormer.hpp"
 #include "BuildVersion.hpp"
+#include "Chunker.hpp"
 #include "algo/HasherMd5.hpp"
 #include "algo/HasherCrc32.hpp"
+#include "algo/HasherCrc32c.hpp"
+#include "algo/HasherXxh3.hpp"
+#include "algo/HasherBlake3.hpp"
+#include "algo/HasherSha256.hpp"
 
 
 
@@ -33,7 +39,9 @@ Config::PrintUsage() noexcept
 {
 	fprintf(stderr,
 "Usage:\n"
-"    " APP_NAME " [KEYS]... <INPUT_FILE> <OUTPUT_FILE>\n");
+"    " APP_NAME " [KEYS]... <INPUT_FILE> <OUTPUT_FILE>\n"
+"    " APP_NAME " [KEYS]... delta <OLD_SIGNATURE> <NEW_FILE> <PATCH_FILE>\n"
+"    " APP_NAME " [KEYS]... compare <SIGNATURE_A> <SIGNATURE_B> [<OUTPUT_FILE>]\n");
 }
 
 
@@ -46,7 +54,20 @@ Config::PrintHelp() noexcept
 "\nDESCRIPTION\n"
 "    " APP_DESCRIPTION "\n\n"
 
-R"(KEYS
+R"(COMMANDS
+    delta <OLD_SIGNATURE> <NEW_FILE> <PATCH_FILE>
+        Make the patch which turns the old file into NEW_FILE (the rsync
+        algorithm). OLD_SIGNATURE must be made with `-o rolling_sum=on` and
+        the same block size and sign_algo. The patch consists of COPY (offset
+        and length in the old file) and INSERT (length and bytes) operations.
+
+    compare <SIGNATURE_A> <SIGNATURE_B> [<OUTPUT_FILE>]
+        Print the numbers of the differing blocks to OUTPUT_FILE (default:
+        stdout), a line per range: FIRST-LAST or BLOCK. The signatures must
+        be made with the same sign_algo and rolling_sum. Exit code is 0 when
+        the signatures are the same and 5 when they differ.
+
+KEYS
     -h, --help
         Show this message
 
@@ -63,18 +84,83 @@ R"(KEYS
 
     -o, --option OPTION
         Set special option:
-        * sign_algo=[crc32,md5] (default: md5)
+        * sign_algo=[blake3,crc32,crc32c,md5,sha256,xxh128,xxh3] (default: md5)
             the signature algorithm
+        * sign_impl=NAME (default: the fastest one for the CPU)
+            the implementation of the signature algorithm: portable, sse2,
+            sse4.1, sse4.2, pclmul, avx2, avx512, sha-ni or multi-buffer
+            sse2-mb (md5), avx2-mb, avx512-mb (md5, sha256)
         * threads=NUM (default: as many threads as available)
             the integer number of threads for processing (must be more then 0)
         * log_file=<file path> (default: stdout)
             the log file path
+        * merkle_file=<file path> (default: none)
+            build the Merkle tree (RFC 6962) over the block signatures and
+            save its root and the inclusion proof of every block to the file
+        * dedup=[on,off] (default: off)
+            count the duplicate blocks (chunks) by their signatures and print
+            the duplicate ratio at the end. The signatures of the unique
+            blocks are kept in memory: about 40 bytes + the signature per
+            unique block (+16 bytes per duplicate for dedup_map)
+        * dedup_max_memory=SIZE (default: 1G)
+            bounds the memory of dedup. When it is exceeded, dedup_map fails,
+            otherwise the unique blocks are counted approximately from then
+            on (HyperLogLog, the standard error is 0.81%%)
+        * dedup_map=<file path> (default: none)
+            turns dedup on and saves a record per duplicate block: block
+            number (8 bytes), the number of its first occurrence (8 bytes);
+            the chunk offsets for chunking=cdc
+        * base_signature=<file path>, dirty_ranges=<file path> (default: none)
+            sign incrementally: only the blocks touched by the dirty ranges
+            (a line `OFFSET LENGTH` in bytes per range) are hashed, the
+            records of the other blocks are copied from the base signature
+            (made with the same block size, sign_algo and rolling_sum).
+        * chunking=[fixed,cdc] (default: fixed)
+            fixed: the blocks of BLOCK_SIZE; cdc: content-defined chunks
+            (FastCDC), an inserted byte changes the signatures of the nearby
+            chunks only. A record of the cdc mode is: offset (8 bytes),
+            length (8 bytes), signature.
+        * chunk_min=SIZE, chunk_avg=SIZE, chunk_max=SIZE
+            (default: avg=BLOCK_SIZE, min=avg/4, max=avg*8)
+            the chunk sizes of the cdc mode in bytes. Supported suffixes: K,
+            M, G. The average size is rounded down to a power of two.
+        * rolling_sum=[on,off] (default: off)
+            add the weak rolling checksum of rsync to each record (see the
+            `delta` command): block number (8 bytes), checksum (4 bytes),
+            signature. The blocks are hashed one by one in this mode.
+        * io=[stream,mmap,direct,uring] (default: stream)
+            the reading of the input file. stream: the bytes are copied from
+            the page cache to the buffer of a thread; mmap: the file is mapped
+            and hashed in place (no copies), the kernel is asked to read
+            ahead. mmap is faster for the files which are in the page cache.
+            direct: O_DIRECT reads by up to 8M to an aligned buffer, the page
+            cache is bypassed (the huge cold files don't evict the cache).
+            uring: io_uring reads ahead of the blocks of a thread, up to
+            queue_depth reads are in flight (stream if io_uring is disabled).
+        * queue_depth=NUM (default: 32)
+            the reads in flight of io=uring per thread (1..4096). The buffers
+            of all threads are 256M at most (64M of them are registered).
+        * pipeline=[off,on] (default: off)
+            on: one thread reads the input file sequentially to a ring of
+            block buffers (2 per hashing thread, a block, a batch of blocks
+            or a 1M piece of a larger block each) and the other threads hash
+            them, so the file isn't read at many offsets at once (HDDs,
+            network volumes). Requires chunking=fixed, isn't supported by the
+            incremental signing.
+            INPUT_FILE `-` (stdin), a pipe or a FIFO is always signed by the
+            pipeline with io=stream: the blocks are carved as the bytes come,
+            the last one is completed at the end of the stream. merkle_file
+            isn't supported then (the number of the blocks is unknown).
 
 )"
 "EXAMPLES\n"
 "    " APP_NAME " input.dat output.dat\n"
 "    " APP_NAME " -b 32K input.dat output.dat -o threads=5\n"
 "    " APP_NAME " --block-size 32K input.dat out.dat -o sign_algo=md5 -o threads=5\n"
+"    " APP_NAME " -b 4K -o rolling_sum=on old.dat old.sig\n"
+"    " APP_NAME " -b 4K delta old.sig new.dat new.patch\n"
+"    " APP_NAME " compare replica1.sig replica2.sig\n"
+"    zstd -dc backup.tar.zst | " APP_NAME " -b 1M - backup.sig\n"
 "\n"
 	);
 }
@@ -197,6 +283,40 @@ THROW_INVALID_ARGUMENT(char const* fmt, ...)
 	throw std::invalid_argument(err_fmt.c_str());
 }
 
+
+// The size in bytes with an optional suffix: K, M, G
+uint64_t
+ParseSize(std::string_view opt_k, std::string_view opt_v)
+{
+	uint64_t size = 0;
+	auto res = std::from_chars(opt_v.begin(), opt_v.end(), size);
+	if (res.ec != std::errc())
+	{
+		THROW_INVALID_ARGUMENT(
+			"can't parse the size [%.*s] of the option [%.*s]: %s",
+			LOG_SV(opt_v), LOG_SV(opt_k), std::make_error_code(res.ec).message().c_str());
+	}
+	std::string_view const suffix {res.ptr, static_cast<std::size_t>(opt_v.end() - res.ptr)};
+	uint64_t multiplier = 1;
+	if      (suffix.empty())                   {}
+	else if (suffix == "K" or suffix == "k")   { multiplier = 1024; }
+	else if (suffix == "M" or suffix == "m")   { multiplier = 1024 * 1024; }
+	else if (suffix == "G" or suffix == "g")   { multiplier = 1024 * 1024 * 1024; }
+	else
+	{
+		THROW_INVALID_ARGUMENT(
+			"an unknown suffix [%.*s] of the option [%.*s]. Available suffixes: K, M, G.",
+			LOG_SV(suffix), LOG_SV(opt_k));
+	}
+	if (size > UINT64_MAX / multiplier)
+	{
+		THROW_INVALID_ARGUMENT(
+			"can't parse the size [%.*s] of the option [%.*s]: it is too large",
+			LOG_SV(opt_v), LOG_SV(opt_k));
+	}
+	return size * multiplier;
+}
+
 } // namespace
 
 
@@ -224,13 +344,31 @@ Config::ParseArgs(int argc, char** argv) noexcept
 			// Process with non key like arguments
 			if (not key_arg)
 			{
-				// It isn't a key. Treat it as either input or output filename.
-				if (m_inputFile.empty())
+				// It isn't a key. Treat it as either the command, the first
+				// signature (of DELTA and COMPARE), input or output filename.
+				bool const no_files = m_signatureFile.empty() and m_inputFile.empty();
+				if (no_files and m_command == command_e::SIGN and std::string_view(cur_arg) == "delta")
+				{
+					m_command = command_e::DELTA;
+				}
+				else if (no_files and m_command == command_e::SIGN and std::string_view(cur_arg) == "compare")
+				{
+					m_command = command_e::COMPARE;
+				}
+				else if (m_command != command_e::SIGN and m_signatureFile.empty())
+				{
+					m_signatureFile.assign(cur_arg);
+				}
+				else if (m_inputFile.empty())
 				{
 					using std::filesystem::file_size;
-					m_inputFile.assign(cur_arg);
+					using std::filesystem::is_regular_file;
+					m_inputFile.assign(std::string_view(cur_arg) == "-" ? FileReader::DEFAULT_NAME : cur_arg);
 					std::error_code ec;
-					m_inputFileSize = file_size(m_inputFile, ec);
+					//NOTE: the size of a stream is unknown until its end
+					m_isStreamInput = m_inputFile == FileReader::DEFAULT_NAME
+						or not is_regular_file(m_inputFile, ec);
+					m_inputFileSize = m_isStreamInput ? 0 : file_size(m_inputFile, ec);
 					if (ec)
 					{
 						THROW_INVALID_ARGUMENT(
@@ -307,6 +445,10 @@ Config::ParseArgs(int argc, char** argv) noexcept
 		FinalCheck_BlockSize();
 		FinalCheck_ThreadNums();
 		FinalCheck_Algo();
+		FinalCheck_Chunking();
+		FinalCheck_Incremental();
+		FinalCheck_StreamInput();
+		FinalCheck_Pipeline();
 	}
 	catch (std::invalid_argument const& ex)
 	{
@@ -416,16 +558,41 @@ Config::ParseOption(char const* key_v)
 		{
 			m_initAlgo = std::make_unique<algo::InitMd5HashStrategy>();
 		}
+		else if (opt_v == "blake3")
+		{
+			m_initAlgo = std::make_unique<algo::InitBlake3HashStrategy>();
+		}
 		else if (opt_v == "crc32")
 		{
 			m_initAlgo = std::make_unique<algo::InitCrc32HashStrategy>();
 		}
+		else if (opt_v == "crc32c")
+		{
+			m_initAlgo = std::make_unique<algo::InitCrc32cHashStrategy>();
+		}
+		else if (opt_v == "sha256")
+		{
+			m_initAlgo = std::make_unique<algo::InitSha256HashStrategy>();
+		}
+		else if (opt_v == "xxh3")
+		{
+			m_initAlgo = std::make_unique<algo::InitXxh3HashStrategy>();
+		}
+		else if (opt_v == "xxh128")
+		{
+			m_initAlgo = std::make_unique<algo::InitXxh128HashStrategy>();
+		}
 		else
 		{
 			THROW_INVALID_ARGUMENT("unknown signature algorithm [%.*s]", LOG_SV(opt_v));
 		}
 	}
 
+	else if (opt_k == "sign_impl")
+	{
+		m_signImpl.assign(opt_v);
+	}
+
 	else if (opt_k == "threads")
 	{
 		auto res = std::from_chars(opt_v.begin(), opt_v.end(), m_numThreads);
@@ -444,6 +611,83 @@ Config::ParseOption(char const* key_v)
 		m_logfile.assign(opt_v);
 	}
 
+	else if (opt_k == "merkle_file")
+	{
+		m_merkleFile.assign(opt_v);
+	}
+
+	else if (opt_k == "dedup")
+	{
+		if      (opt_v == "on")  { m_dedup = true; }
+		else if (opt_v == "off") { m_dedup = false; }
+		else
+		{
+			THROW_INVALID_ARGUMENT("invalid value [%.*s] of dedup", LOG_SV(opt_v));
+		}
+	}
+	else if (opt_k == "dedup_map") { m_dedupMap.assign(opt_v); }
+	else if (opt_k == "dedup_max_memory") { m_dedupMaxMemory = ParseSize(opt_k, opt_v); }
+
+	else if (opt_k == "base_signature") { m_baseSignature.assign(opt_v); }
+	else if (opt_k == "dirty_ranges")   { m_dirtyRanges.assign(opt_v); }
+
+	else if (opt_k == "chunking")
+	{
+		if      (opt_v == "fixed") { m_chunking = chunking_e::FIXED; }
+		else if (opt_v == "cdc")   { m_chunking = chunking_e::CDC; }
+		else
+		{
+			THROW_INVALID_ARGUMENT("unknown chunking [%.*s]", LOG_SV(opt_v));
+		}
+	}
+	else if (opt_k == "rolling_sum")
+	{
+		if      (opt_v == "on")  { m_rollingSum = true; }
+		else if (opt_v == "off") { m_rollingSum = false; }
+		else
+		{
+			THROW_INVALID_ARGUMENT("invalid value [%.*s] of rolling_sum", LOG_SV(opt_v));
+		}
+	}
+	else if (opt_k == "io")
+	{
+		if      (opt_v == "stream") { m_io = FileReader::io_e::STREAM; }
+		else if (opt_v == "mmap")   { m_io = FileReader::io_e::MMAP; }
+		else if (opt_v == "direct") { m_io = FileReader::io_e::DIRECT; }
+		else if (opt_v == "uring")  { m_io = FileReader::io_e::URING; }
+		else
+		{
+			THROW_INVALID_ARGUMENT("unknown io [%.*s]", LOG_SV(opt_v));
+		}
+	}
+	else if (opt_k == "queue_depth")
+	{
+		auto res = std::from_chars(opt_v.begin(), opt_v.end(), m_queueDepth);
+		if (res.ec != std::errc())
+		{
+			THROW_INVALID_ARGUMENT(
+				"can't parse the queue depth [%.*s]: %s",
+				LOG_SV(opt_v), std::make_error_code(res.ec).message().c_str());
+		}
+		if (m_queueDepth == 0 or m_queueDepth > UringFile::MAX_QUEUE_DEPTH)
+		{
+			THROW_INVALID_ARGUMENT("the queue depth %zu is out of [1, %zu]",
+				m_queueDepth, UringFile::MAX_QUEUE_DEPTH);
+		}
+	}
+	else if (opt_k == "pipeline")
+	{
+		if      (opt_v == "on")  { m_pipeline = true; }
+		else if (opt_v == "off") { m_pipeline = false; }
+		else
+		{
+			THROW_INVALID_ARGUMENT("invalid value [%.*s] of pipeline", LOG_SV(opt_v));
+		}
+	}
+	else if (opt_k == "chunk_min") { m_chunkMin = ParseSize(opt_k, opt_v); }
+	else if (opt_k == "chunk_avg") { m_chunkAvg = ParseSize(opt_k, opt_v); }
+	else if (opt_k == "chunk_max") { m_chunkMax = ParseSize(opt_k, opt_v); }
+
 	else
 	{
 		THROW_INVALID_ARGUMENT("an unexpected option [%.*s]", LOG_SV(opt_k));
@@ -462,6 +706,10 @@ Config::FinalCheck_InputOutputFiles()
 	{
 		THROW_ERROR("%s: unknown INPUT file.", __FUNCTION__);
 	}
+	if (m_outputFile.empty() and m_command == command_e::COMPARE)
+	{
+		m_outputFile.assign("stdout");
+	}
 	if (m_outputFile.empty())
 	{
 		THROW_ERROR("%s: unknown OUTPUT file.", __FUNCTION__);
@@ -474,6 +722,32 @@ Config::FinalCheck_InputOutputFiles()
 			"Detect the same names '%s'",
 			__FUNCTION__, m_inputFile.c_str());
 	}
+	if (m_command != command_e::SIGN)
+	{
+		if (m_signatureFile == m_outputFile)
+		{
+			THROW_ERROR("%s: the signature and OUTPUT files must differ '%s'",
+				__FUNCTION__, m_outputFile.c_str());
+		}
+		if (not m_merkleFile.empty() or IsDedup())
+		{
+			THROW_ERROR("%s: the Merkle tree and dedup aren't supported by the %s command",
+				__FUNCTION__, ::toString(m_command));
+		}
+	}
+	if (m_dedupMap == m_inputFile or m_dedupMap == m_outputFile
+	    or (not m_dedupMap.empty() and m_dedupMap == m_merkleFile))
+	{
+		THROW_ERROR(
+			"%s: the dedup map must differ from INPUT, OUTPUT and Merkle files '%s'",
+			__FUNCTION__, m_dedupMap.c_str());
+	}
+	if (m_merkleFile == m_inputFile or m_merkleFile == m_outputFile)
+	{
+		THROW_ERROR(
+			"%s: the Merkle file must differ from INPUT and OUTPUT files '%s'",
+			__FUNCTION__, m_merkleFile.c_str());
+	}
 	//TODO: check possibility to read the input file
 	//TODO: check possibility to create and write the output file
 }
@@ -524,13 +798,119 @@ void
 Config::FinalCheck_Algo()
 {
 	if (not m_initAlgo) { THROW_ERROR("%s: algorithm was not select.", __FUNCTION__); }
+
+	//NOTE: the CPU features are detected at runtime, so the same binary uses
+	// AVX-512 where it is present and the portable code on the old CPUs
+	m_hasherImpl = &algo::HasherFactory::SelectImpl(m_initAlgo->GetType(), m_signImpl);
+}
+
+
+void
+Config::FinalCheck_Chunking()
+{
+	if (m_chunking != chunking_e::CDC) { return; }
+	if (m_command != command_e::SIGN)
+	{
+		THROW_ERROR("%s: the %s command requires chunking=fixed", __FUNCTION__, ::toString(m_command));
+	}
+	if (m_rollingSum)
+	{
+		THROW_ERROR("%s: the rolling sum isn't supported by chunking=cdc", __FUNCTION__);
+	}
+
+	if (m_chunkAvg == 0) { m_chunkAvg = m_blockSizeKB * 1024; }
+	if (m_chunkMin == 0) { m_chunkMin = std::max<uint64_t>(m_chunkAvg / 4, Chunker::MIN_SIZE); }
+	if (m_chunkMax == 0) { m_chunkMax = std::min(m_chunkAvg * 8, Default_s::MAX_CHUNK_SIZE); }
+	if (not (Chunker::MIN_SIZE <= m_chunkMin and m_chunkMin <= m_chunkAvg
+	         and m_chunkAvg <= m_chunkMax and m_chunkMax <= Default_s::MAX_CHUNK_SIZE))
+	{
+		THROW_ERROR(
+			"%s: invalid chunk sizes min=%zu avg=%zu max=%zu: expected "
+			"%zu <= min <= avg <= max <= %zu",
+			__FUNCTION__, m_chunkMin, m_chunkAvg, m_chunkMax,
+			Chunker::MIN_SIZE, Default_s::MAX_CHUNK_SIZE);
+	}
+	//NOTE: the number of the chunks is unknown until the end
+	if (not m_merkleFile.empty())
+	{
+		THROW_ERROR("%s: the Merkle tree isn't supported by chunking=cdc", __FUNCTION__);
+	}
+}
+
+
+void
+Config::FinalCheck_Incremental()
+{
+	if (m_baseSignature.empty() and m_dirtyRanges.empty()) { return; }
+	if (m_baseSignature.empty() or m_dirtyRanges.empty())
+	{
+		THROW_ERROR("%s: base_signature and dirty_ranges must be set together", __FUNCTION__);
+	}
+	if (m_command != command_e::SIGN or m_chunking != chunking_e::FIXED)
+	{
+		THROW_ERROR("%s: the incremental signing requires chunking=fixed", __FUNCTION__);
+	}
+	//NOTE: the base is read while the output is written
+	if (m_baseSignature == m_outputFile or m_baseSignature == m_inputFile
+	    or m_dirtyRanges == m_outputFile)
+	{
+		THROW_ERROR("%s: the base signature '%s' must differ from INPUT and OUTPUT files",
+			__FUNCTION__, m_baseSignature.c_str());
+	}
+}
+
+
+void
+Config::FinalCheck_StreamInput()
+{
+	if (not m_isStreamInput or m_command == command_e::COMPARE) { return; }
+	if (m_command == command_e::DELTA)
+	{
+		THROW_ERROR("%s: the delta command can't read the new file [%s] from a stream",
+			__FUNCTION__, m_inputFile.c_str());
+	}
+	if (m_chunking != chunking_e::FIXED or IsIncremental())
+	{
+		THROW_ERROR("%s: the stream [%s] requires chunking=fixed and isn't supported by the "
+			"incremental signing", __FUNCTION__, m_inputFile.c_str());
+	}
+	if (not m_merkleFile.empty())
+	{
+		THROW_ERROR("%s: the Merkle tree isn't supported for the stream [%s]",
+			__FUNCTION__, m_inputFile.c_str());
+	}
+
+	// The stream is read by one thread (see BlockRing) without seeking
+	if (m_io != FileReader::io_e::STREAM)
+	{
+		LOG_W("%s: the stream [%s] is read by io=stream instead of io=%s",
+			__FUNCTION__, m_inputFile.c_str(), ::toString(m_io));
+		m_io = FileReader::io_e::STREAM;
+	}
+	m_pipeline = true;
+}
+
+
+void
+Config::FinalCheck_Pipeline()
+{
+	if (not m_pipeline) { return; }
+	if (m_command != command_e::SIGN or m_chunking != chunking_e::FIXED)
+	{
+		THROW_ERROR("%s: pipeline=on requires chunking=fixed", __FUNCTION__);
+	}
+	//NOTE: the dirty blocks are read at their offsets, not sequentially
+	if (IsIncremental())
+	{
+		THROW_ERROR("%s: pipeline=on isn't supported by the incremental signing", __FUNCTION__);
+	}
 }
 
 
 char const*
 Config::toString() const noexcept
 {
-	constexpr std::size_t MAX_SIZE = 368;
+	constexpr std::size_t MAX_SIZE = 2048;
 	static std::array<char, MAX_SIZE> buffer;
 
 	StringFormer str(buffer.data(), buffer.size());
@@ -538,22 +918,77 @@ Config::toString() const noexcept
 	LOG FILE        = %s
 	LOG LEVEL       = %s
 	ALGORITHM       = %s
+	IMPLEMENTATION  = %s
 	NUMBER THREADS  = %zu
+	COMMAND         = %s
+	SIGNATURE FILE  = %s
 	INPUT FILE      = %s
-	INPUT FILE SIZE = %zu
+	INPUT FILE SIZE = %zu%s
 	OUTPUT FILE     = %s
+	MERKLE FILE     = %s
+	BASE SIGNATURE  = %s (dirty ranges: %s)
+	DEDUP           = %s (map: %s, max memory: %ju)
 	BLOCK SIZE (KB) = %zu
 	LAST BLOCK NUM  = %zu
+	BLOCK LANES     = %zu
+	BLOCK BATCH     = %zu
+	BLOCK PARTS     = %zu
+	CHUNKING        = %s (min=%zu avg=%zu max=%zu)
+	ROLLING SUM     = %s
+	IO              = %s (queue depth: %zu)
+	PIPELINE        = %s
 })",
 		  m_logfile.c_str()
 		, ::toString(m_actLogLvl)
 		, ::toString(m_initAlgo->GetType())
+		, m_hasherImpl ? m_hasherImpl->name : "-"
 		, m_numThreads
+		, ::toString(m_command)
+		, m_signatureFile.empty() ? "-" : m_signatureFile.c_str()
 		, m_inputFile.c_str()
-		, m_inputFileSize
+		, m_inputFileSize, m_isStreamInput ? " (a stream)" : ""
 		, m_outputFile.c_str()
+		, m_merkleFile.empty() ? "-" : m_merkleFile.c_str()
+		, m_baseSignature.empty() ? "-" : m_baseSignature.c_str()
+		, m_dirtyRanges.empty() ? "-" : m_dirtyRanges.c_str()
+		, IsDedup() ? "on" : "off"
+		, m_dedupMap.empty() ? "-" : m_dedupMap.c_str(), m_dedupMaxMemory
 		, m_blockSizeKB
 		, m_lastBlockNum
+		, m_blockLanes
+		, m_blockBatch
+		, m_blockParts
+		, ::toString(m_chunking), m_chunkMin, m_chunkAvg, m_chunkMax
+		, m_rollingSum ? "on" : "off"
+		, ::toString(m_io), m_queueDepth
+		, m_pipeline ? "on" : "off"
 		);
 	return str.c_str();
 }
+
+
+
+char const*
+toString(Config::command_e v)
+{
+	switch (v)
+	{
+	case Config::command_e::SIGN:    return "sign";
+	case Config::command_e::DELTA:   return "delta";
+	case Config::command_e::COMPARE: return "compare";
+	}
+	return "unknown";
+}
+
+
+
+char const*
+toString(Config::chunking_e v)
+{
+	switch (v)
+	{
+	case Config::chunking_e::FIXED: return "fixed";
+	case Config::chunking_e::CDC:   return "cdc";
+	}
+	return "unknown";
+}
@@ -10,6 +10,7 @@
 
 #include "common/Singletone.hpp"
 #include "common/Logger.hpp"
+#include "common/FileReader.hpp"
 #include "algo/HasherFactory.hpp"
 
 
@@ -24,6 +25,19 @@ public:
 	using log_lvl_e     = Logger::log_level_e;
 	using init_algo_t   = std::unique_ptr<algo::InitHashStrategy>;
 
+	enum class command_e : uint8_t
+	{
+		SIGN,    // INPUT_FILE -> OUTPUT_FILE with the signatures
+		DELTA,   // see DeltaMaker
+		COMPARE, // see SignatureComparer
+	};
+
+	enum class chunking_e : uint8_t
+	{
+		FIXED, // blocks of GetBlockSizeKB()
+		CDC,   // content-defined chunks (see Chunker)
+	};
+
 	struct Default_s
 	{
 		//NOTE: AMAP = As Much As Possible
@@ -33,6 +47,8 @@ public:
 		static constexpr size_t      READ_BUF_SIZE      = 4096;
 		static constexpr uint8_t     BLOCK_FILLER_BYTE  = 0;
 		static constexpr size_t      THREAD_NUM_WHEN_HWCORE_IS_0 = 2;
+		static constexpr uint64_t    MAX_CHUNK_SIZE     = 64 * 1024 * 1024;
+		static constexpr uint64_t    DEDUP_MAX_MEMORY   = 1024 * 1024 * 1024;
 	};
 
 	struct BuildVersion_s
@@ -58,15 +74,35 @@ public:
 	start_tp_t const GetStartDateTime() const noexcept { return m_startDateTime; }
 
 	init_algo_t const& GetInitAlgo() const noexcept    { return m_initAlgo; }
+	algo::HasherImpl const* GetHasherImpl() const noexcept { return m_hasherImpl; }
 	log_lvl_e GetActualLogLevel() const noexcept       { return m_actLogLvl; }
 	std::string const& GetLogfile() const noexcept     { return m_logfile; }
+	command_e GetCommand() const noexcept              { return m_command; }
+	std::string const& GetSignatureFile() const noexcept { return m_signatureFile; }
 	std::string const& GetInputFile() const noexcept   { return m_inputFile; }
 	std::string const& GetOutputFile() const noexcept  { return m_outputFile; }
+	std::string const& GetMerkleFile() const noexcept  { return m_merkleFile; }
+	std::string const& GetBaseSignature() const noexcept { return m_baseSignature; }
+	std::string const& GetDirtyRanges() const noexcept { return m_dirtyRanges; }
+	bool IsIncremental() const noexcept                { return not m_baseSignature.empty(); }
+	bool IsDedup() const noexcept                      { return m_dedup or not m_dedupMap.empty(); }
+	std::string const& GetDedupMap() const noexcept    { return m_dedupMap; }
+	uint64_t GetDedupMaxMemory() const noexcept        { return m_dedupMaxMemory; }
 	uintmax_t GetBlockSizeKB() const noexcept          { return m_blockSizeKB; }
 	uintmax_t GetInputFileSize() const noexcept        { return m_inputFileSize; }
+	// stdin, a pipe or a FIFO: the size is unknown (0) until its end
+	bool IsStreamInput() const noexcept                { return m_isStreamInput; }
 	size_t GetThreadsNum() const noexcept              { return m_numThreads; }
 	size_t GetReadBufferSize() const noexcept          { return m_readBufSize; }
 	uint8_t GetBlockFiller() const noexcept            { return m_blockFiller; }
+	chunking_e GetChunking() const noexcept            { return m_chunking; }
+	std::uint64_t GetChunkMin() const noexcept         { return m_chunkMin; }
+	std::uint64_t GetChunkAvg() const noexcept         { return m_chunkAvg; }
+	std::uint64_t GetChunkMax() const noexcept         { return m_chunkMax; }
+	bool IsRollingSum() const noexcept                 { return m_rollingSum; }
+	FileReader::io_e GetIo() const noexcept            { return m_io; }
+	size_t GetQueueDepth() const noexcept              { return m_queueDepth; }
+	bool IsPipeline() const noexcept                   { return m_pipeline; } // see BlockRing
 
 	// NOTE: uint64_t for determinating byte size of block number which will
 	//       be recorded
@@ -79,6 +115,31 @@ public:
 	void SetFileBytesShift(std::uintmax_t v) noexcept  { m_fileBytesShift = v; }
 	std::uintmax_t GetFileBytesShift() const noexcept  { return m_fileBytesShift; }
 
+	// NOTE: number of blocks which are hashed by one Worker simultaneously
+	//       (multi-buffer hashing)
+	void SetBlockLanes(std::size_t v) noexcept         { m_blockLanes = v; }
+	std::size_t GetBlockLanes() const noexcept         { return m_blockLanes; }
+
+	// NOTE: number of consecutive blocks which are read and hashed by one
+	//       Worker at once (see IHasher::HashBatch)
+	void SetBlockBatch(std::size_t v) noexcept         { m_blockBatch = v; }
+	std::size_t GetBlockBatch() const noexcept         { return m_blockBatch; }
+
+	// NOTE: number of parts of a block which are hashed by different Workers
+	//       and their size (the last part can be shorter)
+	void SetBlockParts(std::uint64_t num, std::uintmax_t size) noexcept
+	{
+		m_blockParts    = num;
+		m_blockPartSize = size;
+	}
+	std::uint64_t GetBlockParts() const noexcept       { return m_blockParts; }
+	std::uintmax_t GetBlockPartSize() const noexcept   { return m_blockPartSize; }
+
+	// NOTE: the chunking=cdc mode splits the file on segments which are
+	//       chunked by different Workers (see WorkerManager::SaveChunkResult)
+	void SetChunkSegmentSize(std::uintmax_t v) noexcept { m_chunkSegmentSize = v; }
+	std::uintmax_t GetChunkSegmentSize() const noexcept { return m_chunkSegmentSize; }
+
 private:
 	void ParseVerbose(char const*);
 	void ParseBlockSize(char const*);
@@ -88,6 +149,10 @@ private:
 	void FinalCheck_BlockSize();
 	void FinalCheck_ThreadNums();
 	void FinalCheck_Algo();
+	void FinalCheck_Chunking();
+	void FinalCheck_Incremental();
+	void FinalCheck_StreamInput();
+	void FinalCheck_Pipeline();
 
 private:
 	static BuildVersion_s const m_buildVersion;
@@ -99,14 +164,41 @@ private:
 	uintmax_t      m_blockSizeKB     = Default_s::BLOCK_SIZE_KB;
 	size_t         m_numThreads      = Default_s::AMAP_THREAD_NUM; // AMAP = As Much As Possible
 	std::string    m_logfile         { Default_s::LOGFILE };
+	command_e      m_command         = command_e::SIGN;
+	std::string    m_signatureFile;             // the first signature of DELTA and COMPARE
 	std::string    m_outputFile;
 	std::string    m_inputFile;
+	std::string    m_merkleFile;                // empty = the tree is not built
+	std::string    m_baseSignature;             // empty = all blocks are hashed
+	std::string    m_dirtyRanges;               // the changes since m_baseSignature
+	bool           m_dedup           = false;   // see DedupTable
+	std::string    m_dedupMap;                  // empty = the map is not saved
+	uint64_t       m_dedupMaxMemory  = Default_s::DEDUP_MAX_MEMORY;
 	uintmax_t      m_inputFileSize   = 0;
+	bool           m_isStreamInput   = false;
 	init_algo_t    m_initAlgo;
+	std::string    m_signImpl;                  // empty = the fastest one
+	algo::HasherImpl const* m_hasherImpl = nullptr; // will be set by FinalCheck_Algo
 	uint64_t       m_blocksShift     = 0; // will be set by WorkerManager
 	uint64_t       m_lastBlockNum    = 0; // will be set by WorkerManager
 	uintmax_t      m_fileBytesShift  = 0; // will be set by WorkerManager
+	size_t         m_blockLanes      = 1; // will be set by WorkerManager
+	size_t         m_blockBatch      = 1; // will be set by WorkerManager
+	uint64_t       m_blockParts      = 1; // will be set by WorkerManager
+	uintmax_t      m_blockPartSize   = 0; // will be set by WorkerManager
+	chunking_e     m_chunking        = chunking_e::FIXED;
+	uint64_t       m_chunkMin        = 0; // 0 = derived from the average size
+	uint64_t       m_chunkAvg        = 0; // 0 = the block size
+	uint64_t       m_chunkMax        = 0; // 0 = derived from the average size
+	uintmax_t      m_chunkSegmentSize = 0; // will be set by WorkerManager
+	bool           m_rollingSum      = false; // see algo::Rollsum
+	FileReader::io_e m_io            = FileReader::io_e::STREAM; // the reading of INPUT_FILE
+	size_t         m_queueDepth      = UringFile::DEFAULT_QUEUE_DEPTH; // io_e::URING
+	bool           m_pipeline        = false;
 	size_t         m_readBufSize     = Default_s::READ_BUF_SIZE;     //TODO: add for configuring
 	uint8_t        m_blockFiller     = Default_s::BLOCK_FILLER_BYTE; //TODO: add for configuring
 	log_lvl_e      m_actLogLvl       = log_lvl_e::WARNING;
 };
+
+char const* toString(Config::command_e);
+char const* toString(Config::chunking_e);
@@ -0,0 +1,290 @@
+#include "DedupTable.hpp"
+
+#include <algorithm>
+
+#include <cmath>
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/FileWriter.hpp"
+
+
+
+namespace {
+
+// The bytes which `v` takes more to append `n` elements (see Reserve)
+template <typename T>
+std::size_t
+GrowthOf(std::vector<T> const& v, std::size_t n) noexcept
+{
+	if (v.size() + n <= v.capacity()) { return 0; }
+	return std::max(v.capacity(), n) * sizeof(T);
+}
+
+
+// The capacity is doubled explicitly, so it is accounted exactly
+template <typename T>
+void
+Reserve(std::vector<T>& v, std::size_t n)
+{
+	if (std::size_t const growth = GrowthOf(v, n); growth != 0)
+	{
+		v.reserve(v.capacity() + growth / sizeof(T));
+	}
+}
+
+} // namespace
+
+
+
+DedupTable::DedupTable(std::uint64_t expected_count, bool keep_map, std::uint64_t max_memory)
+	: m_shards(SHARDS)
+	, m_keepMap(keep_map)
+	, m_maxMemory(max_memory)
+{
+	// a block of the map takes the duplicate record at least
+	if (keep_map and expected_count > max_memory / sizeof(std::pair<std::uint64_t, std::uint64_t>))
+	{
+		THROW_ERROR("%s: the dedup map of %ju blocks doesn't fit into dedup_max_memory=%ju",
+			__FUNCTION__, expected_count, max_memory);
+	}
+	// the load factor is 1/2 at most (see Add); the slots are presized by
+	// a quarter of the memory at most
+	std::uint64_t const per_shard = 2 * expected_count / SHARDS;
+	std::uint64_t const max_slots = max_memory / 4 / SHARDS / sizeof(Slot);
+	std::size_t slots = MIN_SHARD_SLOTS;
+	while (slots < per_shard and 2 * slots <= max_slots) { slots *= 2; }
+	for (Shard& shard : m_shards) { shard.slots.resize(slots); }
+	m_memory = SHARDS * slots * sizeof(Slot);
+}
+
+
+
+void
+DedupTable::Add(std::uint64_t id, uint8_t const* signature, std::size_t size, std::uint64_t bytes)
+{
+	if (m_signatureSize == 0) { m_signatureSize = size; }
+	std::uint64_t const key = Fingerprint(signature, size);
+	++m_count;
+	m_bytes += bytes;
+	if (IsApproximate()) { return AddToRegisters(key); }
+	if (m_shards.empty()) { return; } // the map was refused, the run fails
+
+	Shard& shard = m_shards[key >> (64 - SHARD_BITS)];
+	Slot* slot = &Find(shard, key, signature);
+	bool const is_unique = (slot->index == EMPTY);
+	if (not Reserve(shard, is_unique))
+	{
+		if (m_keepMap)
+		{
+			std::vector<Shard>().swap(m_shards);
+			THROW_ERROR("%s: the dedup map doesn't fit into dedup_max_memory=%ju (%ju blocks)",
+				__FUNCTION__, m_maxMemory, m_count);
+		}
+		SwitchToApproximate();
+		return AddToRegisters(key);
+	}
+	if (is_unique)
+	{
+		// the slots could be moved by the growth
+		slot = &Find(shard, key, signature);
+		slot->key   = key;
+		slot->index = shard.canonicals.size();
+		shard.canonicals.push_back(id);
+		shard.signatures.insert(shard.signatures.end(), signature, signature + size);
+		return;
+	}
+
+	// the later block becomes the duplicate of the earlier one
+	m_duplicateBytes += bytes;
+	std::uint64_t& canonical = shard.canonicals[slot->index];
+	if (m_keepMap) { shard.duplicates.emplace_back(std::max(id, canonical), slot->index); }
+	canonical = std::min(id, canonical);
+}
+
+
+
+std::uint64_t
+DedupTable::GetUniqueCount() const noexcept
+{
+	if (not IsApproximate())
+	{
+		std::uint64_t unique = 0;
+		for (Shard const& shard : m_shards) { unique += shard.canonicals.size(); }
+		return unique;
+	}
+
+	// HyperLogLog (Flajolet et al.) with the linear counting of the small
+	// cardinalities; the large range correction isn't needed for 64 bits
+	double sum = 0;
+	std::size_t zeros = 0;
+	for (uint8_t reg : m_registers)
+	{
+		sum += std::ldexp(1.0, -reg);
+		if (reg == 0) { ++zeros; }
+	}
+	double constexpr m = REGISTERS;
+	double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+	if (estimate <= 2.5 * m and zeros != 0) { estimate = m * std::log(m / static_cast<double>(zeros)); }
+	return std::min(static_cast<std::uint64_t>(std::llround(estimate)), m_count);
+}
+
+
+
+std::uint64_t
+DedupTable::GetDuplicateBytes() const noexcept
+{
+	if (not IsApproximate() or m_count == 0) { return m_duplicateBytes; }
+	double const ratio = static_cast<double>(m_count - GetUniqueCount()) / static_cast<double>(m_count);
+	return static_cast<std::uint64_t>(ratio * static_cast<double>(m_bytes));
+}
+
+
+
+void
+DedupTable::SaveMap(FileWriter& out) const
+{
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> map;
+	for (Shard const& shard : m_shards)
+	{
+		for (auto const& [id, index] : shard.duplicates)
+		{
+			map.emplace_back(id, shard.canonicals[index]);
+		}
+	}
+	std::sort(map.begin(), map.end());
+	for (auto const& [id, canonical] : map)
+	{
+		out.Write(&id, sizeof(id), 1);
+		out.Write(&canonical, sizeof(canonical), 1);
+	}
+}
+
+
+
+// static
+std::uint64_t
+DedupTable::Fingerprint(uint8_t const* signature, std::size_t size) noexcept
+{
+	// The first 8 bytes (the short signatures are padded by zeros) are mixed
+	// by the bijective finalizer of splitmix64: all bits of the key depend on
+	// all bits of the signature prefix, so the shards and the slots are even
+	// for crc32 too
+	std::uint64_t z = 0;
+	std::memcpy(&z, signature, std::min(size, sizeof(z)));
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+
+
+// Returns the slot of the signature or the empty one where it should be. The
+// fingerprints of different signatures may match: the signatures are compared.
+DedupTable::Slot&
+DedupTable::Find(Shard& shard, std::uint64_t key, uint8_t const* signature) const noexcept
+{
+	std::size_t const mask = shard.slots.size() - 1;
+	for (std::size_t i = key & mask; ; i = (i + 1) & mask)
+	{
+		Slot& slot = shard.slots[i];
+		if (slot.index == EMPTY) { return slot; }
+		if (slot.key == key and 0 == std::memcmp(
+			shard.signatures.data() + slot.index * m_signatureSize, signature, m_signatureSize))
+		{
+			return slot;
+		}
+	}
+}
+
+
+
+// static
+void
+DedupTable::Grow(Shard& shard)
+{
+	std::vector<Slot> old(shard.slots.size() * 2);
+	old.swap(shard.slots);
+	//NOTE: the slots are unique, so a free one is searched only
+	std::size_t const mask = shard.slots.size() - 1;
+	for (Slot const& slot : old)
+	{
+		if (slot.index == EMPTY) { continue; }
+		std::size_t i = slot.key & mask;
+		while (shard.slots[i].index != EMPTY) { i = (i + 1) & mask; }
+		shard.slots[i] = slot;
+	}
+}
+
+
+
+// Reserves the shard for the signature. Returns false if the memory doesn't
+// suffice.
+bool
+DedupTable::Reserve(Shard& shard, bool is_unique)
+{
+	std::size_t growth = 0;
+	bool const is_full = is_unique and 2 * (shard.canonicals.size() + 1) > shard.slots.size();
+	if (is_full) { growth += shard.slots.size() * sizeof(Slot); }
+	if (is_unique)
+	{
+		growth += GrowthOf(shard.canonicals, 1) + GrowthOf(shard.signatures, m_signatureSize);
+	}
+	else if (m_keepMap)
+	{
+		growth += GrowthOf(shard.duplicates, 1);
+	}
+	if (growth == 0) { return true; }
+	if (m_memory + growth > m_maxMemory) { return false; }
+
+	m_memory += growth;
+	if (is_full) { Grow(shard); }
+	if (is_unique)
+	{
+		::Reserve(shard.canonicals, 1);
+		::Reserve(shard.signatures, m_signatureSize);
+	}
+	else if (m_keepMap)
+	{
+		::Reserve(shard.duplicates, 1);
+	}
+	return true;
+}
+
+
+
+// The fingerprints of the unique signatures are moved to the registers and
+// the shards are freed
+void
+DedupTable::SwitchToApproximate()
+{
+	std::uint64_t const unique = GetUniqueCount();
+	m_registers.assign(REGISTERS, 0);
+	for (Shard const& shard : m_shards)
+	{
+		for (Slot const& slot : shard.slots)
+		{
+			if (slot.index != EMPTY) { AddToRegisters(slot.key); }
+		}
+	}
+	LOG_W("%s: %ju unique of %ju blocks don't fit into dedup_max_memory=%ju: "
+		"the unique count is estimated from now on (the standard error is %.2f%%)",
+		__FUNCTION__, unique, m_count - 1, m_maxMemory, 100 * APPROXIMATE_ERROR);
+	std::vector<Shard>().swap(m_shards);
+	m_memory = m_registers.size();
+}
+
+
+
+void
+DedupTable::AddToRegisters(std::uint64_t key) noexcept
+{
+	// the high bits select the register, it keeps the maximal rank (the
+	// position of the first 1) of the rest
+	std::uint64_t const rest = key << REGISTER_BITS;
+	uint8_t const rank = (rest == 0)
+		? 64 - REGISTER_BITS + 1
+		: static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+	uint8_t& reg = m_registers[key >> (64 - REGISTER_BITS)];
+	reg = std::max(reg, rank);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+
+
+class FileWriter;
+
+
+
+// The duplicates among the signed blocks (or chunks): an open-addressing
+// table (linear probing) keyed by the fingerprint of the signature. A match
+// of the fingerprints is confirmed by the full signatures: the table keeps a
+// copy of every unique one. The canonical unit of a signature is its first
+// occurrence, i.e. the smallest id (the records come out of order, so it is
+// updated as they come).
+//
+// The table is split on SHARDS by the high bits of the fingerprint: a shard
+// grows (rehashes) alone, so the pause of a growth is bounded by the shard
+// size; the duplicates always meet in the same shard, so the shards are
+// merged just by summing up.
+//
+// The memory is bounded by `max_memory`: about 32 bytes of the slots (over
+// the load factor 1/2) + 8 bytes + the signature per unique signature, + 16
+// bytes per duplicate for the map. When the table doesn't fit into it, the map
+// is refused (Add throws), otherwise the table is dropped to a HyperLogLog of
+// the fingerprints: the unique count becomes an estimate with the standard
+// error APPROXIMATE_ERROR (the count and the bytes stay exact).
+class DedupTable
+{
+public:
+	// The map file (see SaveMap) is a record per duplicate, ascending by id:
+	//   id (u64), canonical id (u64)
+	// where id is the block number (or the chunk offset of chunking=cdc).
+	static constexpr std::size_t SHARD_BITS = 6;
+	static constexpr std::size_t SHARDS     = std::size_t{1} << SHARD_BITS;
+	// The HyperLogLog registers: the standard error is 1.04 / sqrt(REGISTERS)
+	static constexpr std::size_t REGISTER_BITS = 14;
+	static constexpr std::size_t REGISTERS     = std::size_t{1} << REGISTER_BITS;
+	static constexpr double      APPROXIMATE_ERROR = 1.04 / 128;
+
+	DedupTable(DedupTable&&)                  = delete;
+	DedupTable(DedupTable const&)             = delete;
+	DedupTable& operator= (DedupTable&&)      = delete;
+	DedupTable& operator= (DedupTable const&) = delete;
+
+	// `expected_count` presizes the shards, `keep_map` keeps the duplicates
+	// for SaveMap. Throws if the map of `expected_count` can't fit into
+	// `max_memory`.
+	DedupTable(std::uint64_t expected_count, bool keep_map, std::uint64_t max_memory);
+	~DedupTable() = default;
+
+	void Add(std::uint64_t id, uint8_t const* signature, std::size_t size, std::uint64_t bytes);
+
+	std::uint64_t GetCount() const noexcept          { return m_count; }
+	std::uint64_t GetUniqueCount() const noexcept;
+	std::uint64_t GetBytes() const noexcept          { return m_bytes; }
+	// Estimated by the ratio of the duplicates when IsApproximate
+	std::uint64_t GetDuplicateBytes() const noexcept;
+	// The memory didn't suffice: the unique count is estimated
+	bool IsApproximate() const noexcept              { return not m_registers.empty(); }
+
+	void SaveMap(FileWriter&) const;
+
+private:
+	static constexpr std::uint64_t EMPTY = UINT64_MAX; // Slot::index
+	static constexpr std::size_t   MIN_SHARD_SLOTS = 64;
+
+	struct Slot
+	{
+		std::uint64_t key   = 0;
+		std::uint64_t index = EMPTY; // of the unique signature in the shard
+	};
+
+	struct Shard
+	{
+		std::vector<Slot>          slots;      // the size is a power of two
+		std::vector<std::uint64_t> canonicals; // per unique signature
+		std::vector<uint8_t>       signatures; // per unique signature
+		std::vector<std::pair<std::uint64_t, std::uint64_t>> duplicates; // id, index
+	};
+
+	static std::uint64_t Fingerprint(uint8_t const* signature, std::size_t size) noexcept;
+	Slot& Find(Shard&, std::uint64_t key, uint8_t const* signature) const noexcept;
+	static void Grow(Shard&);
+	bool Reserve(Shard&, bool is_unique);
+	void SwitchToApproximate();
+	void AddToRegisters(std::uint64_t key) noexcept;
+
+private:
+	std::vector<Shard> m_shards;
+	std::vector<uint8_t> m_registers;    // of HyperLogLog, empty while exact
+	bool               m_keepMap;
+	std::uint64_t      m_maxMemory;
+	std::uint64_t      m_memory         = 0; // the capacities of the shards
+	std::size_t        m_signatureSize  = 0; // the same for all signatures
+	std::uint64_t      m_count          = 0;
+	std::uint64_t      m_bytes          = 0;
+	std::uint64_t      m_duplicateBytes = 0;
+};
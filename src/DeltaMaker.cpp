@@ -0,0 +1,383 @@
+#include "DeltaMaker.hpp"
+
+#include <algorithm>
+#include <future>
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/FileReader.hpp"
+#include "common/FileWriter.hpp"
+#include "algo/IHasher.hpp"
+#include "algo/Rollsum.hpp"
+
+
+
+namespace {
+
+constexpr std::size_t READ_SIZE = 1024 * 1024;
+
+
+
+// Reads the file followed by the infinite filler bytes. The buffer keeps
+// the bytes [m_begin, m_end) of it.
+class PaddedReader
+{
+public:
+	PaddedReader(char const* name, std::uint64_t file_size, uint8_t filler,
+	             std::size_t capacity, std::uint64_t offset)
+		: m_in(name)
+		, m_fileSize(file_size)
+		, m_filler(filler)
+		, m_buffer(capacity)
+		, m_begin(offset)
+		, m_end(offset)
+	{
+		m_in.SetPosition(offset);
+	}
+
+	// Returns the bytes [from, to), the bytes before `from` are dropped.
+	// `from` is not decreased between the calls, `to - from` fits the buffer.
+	uint8_t const*
+	Get(std::uint64_t from, std::uint64_t to)
+	{
+		if (to > m_end)
+		{
+			std::size_t const kept = m_end - from;
+			std::memmove(m_buffer.data(), m_buffer.data() + (from - m_begin), kept);
+			m_begin = from;
+			if (m_end < m_fileSize)
+			{
+				auto const want = static_cast<std::size_t>(
+					std::min<std::uint64_t>(m_buffer.size() - kept, m_fileSize - m_end));
+				if (m_in.Read(m_buffer.data() + kept, want) != want)
+				{
+					THROW_ERROR("%s: unexpected end of the file [%s]", __FUNCTION__, m_in.GetName());
+				}
+				m_end += want;
+			}
+			if (to > m_end)
+			{
+				std::memset(m_buffer.data() + (m_end - m_begin), m_filler, to - m_end);
+				m_end = to;
+			}
+		}
+		return m_buffer.data() + (from - m_begin);
+	}
+
+private:
+	FileReader           m_in;
+	std::uint64_t        m_fileSize;
+	uint8_t              m_filler;
+	std::vector<uint8_t> m_buffer;
+	std::uint64_t        m_begin;
+	std::uint64_t        m_end;
+};
+
+} // namespace
+
+
+
+DeltaMaker::DeltaMaker(Config const& cfg)
+	: m_cfg(cfg)
+	, m_blockSize(cfg.GetBlockSizeKB() * 1024)
+	, m_digestSize(algo::HasherFactory::Create(*cfg.GetInitAlgo())->ResultSize())
+{}
+
+
+
+bool
+DeltaMaker::Run() noexcept
+{
+	try
+	{
+		LoadSignature();
+
+		std::uint64_t const file_size = m_cfg.GetInputFileSize();
+		std::uint64_t const workers   = std::max<std::size_t>(m_cfg.GetThreadsNum(), 2) - 1;
+		std::uint64_t const seg_size  = std::max(MIN_SEGMENT_SIZE, (file_size + workers - 1) / workers);
+		std::vector<ops_t> ops((file_size + seg_size - 1) / seg_size);
+
+		std::vector<std::future<void>> results;
+		for (std::size_t i = 0; i < ops.size(); ++i)
+		{
+			std::uint64_t const begin = i * seg_size;
+			std::uint64_t const end   = std::min(file_size, begin + seg_size);
+			results.push_back(std::async(std::launch::async,
+				&DeltaMaker::ScanSegment, this, begin, end, std::ref(ops[i])));
+		}
+		for (auto& res : results) { res.get(); }
+
+		WritePatch(ops);
+		LOG_I("Delta: %zu segments, copied %ju bytes, inserted %ju bytes",
+			ops.size(), m_copied, m_literal);
+		return true;
+	}
+	catch (std::exception const& ex)
+	{
+		LOG_E("Delta failed: %s", ex.what());
+	}
+	return false;
+}
+
+
+
+void
+DeltaMaker::LoadSignature()
+{
+	std::string const& name = m_cfg.GetSignatureFile();
+	std::size_t const record_size = sizeof(std::uint64_t) + sizeof(uint32_t) + m_digestSize;
+
+	std::vector<uint8_t> records;
+	{
+		FileReader in(name.c_str());
+		std::vector<uint8_t> buffer(READ_SIZE);
+		while (std::size_t const read_bytes = in.Read(buffer.data(), buffer.size()))
+		{
+			records.insert(records.end(), buffer.data(), buffer.data() + read_bytes);
+		}
+	}
+	if (records.size() % record_size != 0)
+	{
+		THROW_ERROR("%s: the size of [%s] is not a multiple of %zu bytes (block u64, rolling sum u32, signature): "
+			"the signature must be made with -o rolling_sum=on and the same algorithm",
+			__FUNCTION__, name.c_str(), record_size);
+	}
+
+	std::uint64_t const count = records.size() / record_size;
+	std::vector<bool> seen(count, false);
+	m_digests.resize(count * m_digestSize);
+	m_rollingSums.resize(count);
+	m_entries.resize(count);
+	for (std::uint64_t i = 0; i < count; ++i)
+	{
+		uint8_t const* const rec = records.data() + i * record_size;
+		Entry& entry = m_entries[i];
+		std::memcpy(&entry.block, rec, sizeof(entry.block));
+		std::memcpy(&entry.rolling_sum, rec + sizeof(entry.block), sizeof(entry.rolling_sum));
+		if (entry.block >= count or seen[entry.block])
+		{
+			THROW_ERROR("%s: unexpected block #%ju in [%s] (blocks count %ju)",
+				__FUNCTION__, entry.block, name.c_str(), count);
+		}
+		seen[entry.block] = true;
+		m_rollingSums[entry.block] = entry.rolling_sum;
+		std::memcpy(&m_digests[entry.block * m_digestSize], rec + record_size - m_digestSize, m_digestSize);
+	}
+
+	// A bucket per block on average (the rolling sum is 32 bits)
+	while (m_bucketsBits < 32 and (std::uint64_t{1} << m_bucketsBits) < count) { ++m_bucketsBits; }
+
+	// The blocks with the same content (e.g. the zero blocks) are indexed
+	// once: by the first of them. The entries of a bucket are ascending by
+	// the rolling sum.
+	auto const digest_of = [this](Entry const& e) { return &m_digests[e.block * m_digestSize]; };
+	std::sort(m_entries.begin(), m_entries.end(), [&](Entry const& l, Entry const& r)
+	{
+		std::size_t const lb = Bucket(l.rolling_sum);
+		std::size_t const rb = Bucket(r.rolling_sum);
+		if (lb != rb) { return lb < rb; }
+		if (l.rolling_sum != r.rolling_sum) { return l.rolling_sum < r.rolling_sum; }
+		int const cmp = std::memcmp(digest_of(l), digest_of(r), m_digestSize);
+		return (cmp != 0) ? cmp < 0 : l.block < r.block;
+	});
+	m_entries.erase(std::unique(m_entries.begin(), m_entries.end(), [&](Entry const& l, Entry const& r)
+	{
+		return l.rolling_sum == r.rolling_sum
+			and 0 == std::memcmp(digest_of(l), digest_of(r), m_digestSize);
+	}), m_entries.end());
+	m_entries.shrink_to_fit();
+
+	m_buckets.assign((std::size_t{1} << m_bucketsBits) + 1, 0);
+	for (Entry const& entry : m_entries) { ++m_buckets[Bucket(entry.rolling_sum) + 1]; }
+	for (std::size_t i = 1; i < m_buckets.size(); ++i) { m_buckets[i] += m_buckets[i - 1]; }
+	LOG_I("Loaded %ju blocks (%zu unique) of %ju bytes from [%s]",
+		count, m_entries.size(), m_blockSize, name.c_str());
+}
+
+
+
+// Slides the rolling sum over [begin, end): a matched block is skipped
+// entirely, so the last copy can pass `end` (the next segment starts from a
+// different position and the overlap is dropped by WritePatch)
+void
+DeltaMaker::ScanSegment(std::uint64_t begin, std::uint64_t end, ops_t& ops) const
+{
+	std::uint64_t const file_size = m_cfg.GetInputFileSize();
+	auto const bs = static_cast<std::size_t>(m_blockSize);
+	auto hasher = algo::HasherFactory::Create(*m_cfg.GetInitAlgo());
+	std::vector<uint8_t> digest(m_digestSize);
+	PaddedReader reader(m_cfg.GetInputFile().c_str(), file_size, m_cfg.GetBlockFiller(),
+		std::max(4 * bs, READ_SIZE), begin);
+
+	algo::Rollsum weak;
+	std::uint64_t pos       = begin;
+	std::uint64_t literal   = begin; // the start of the pending literal
+	std::uint64_t preferred = LITERAL;
+	bool fresh = true;
+	while (pos < end)
+	{
+		// the window and the byte which enters it on the next roll
+		uint8_t const* const window = reader.Get(pos, pos + bs + 1);
+		if (fresh)
+		{
+			weak.Reset();
+			weak.Update(window, bs);
+			fresh = false;
+		}
+
+		std::uint64_t const block = FindBlock(*hasher, weak.Digest(), window, preferred, digest);
+		if (block == LITERAL)
+		{
+			weak.Roll(window[0], window[bs]);
+			++pos;
+			continue;
+		}
+
+		std::uint64_t const length = std::min<std::uint64_t>(bs, file_size - pos);
+		if (literal < pos) { Append(ops, {literal, pos - literal, LITERAL}); }
+		Append(ops, {pos, length, block * m_blockSize});
+		pos      += length;
+		literal   = pos;
+		preferred = block + 1;
+		fresh     = true;
+	}
+	if (literal < pos) { Append(ops, {literal, pos - literal, LITERAL}); }
+}
+
+
+
+// Returns the block with the same signature as the window or LITERAL. The
+// window is hashed only when a rolling sum is matched; `preferred` (the
+// block after the previous copy) is checked first to make the copies longer,
+// else the first matched block of the index is returned.
+std::uint64_t
+DeltaMaker::FindBlock(algo::IHasher& hasher, uint32_t rolling_sum, uint8_t const* window,
+                      std::uint64_t preferred, std::vector<uint8_t>& digest) const
+{
+	bool hashed = false;
+	auto const is_match = [&](std::uint64_t block)
+	{
+		if (not hashed)
+		{
+			hasher.Init(*m_cfg.GetInitAlgo());
+			hasher.Update(window, m_blockSize);
+			hasher.Finish(digest.data());
+			hashed = true;
+		}
+		return 0 == std::memcmp(digest.data(), &m_digests[block * m_digestSize], m_digestSize);
+	};
+
+	if (preferred < m_rollingSums.size() and m_rollingSums[preferred] == rolling_sum
+	    and is_match(preferred))
+	{
+		return preferred;
+	}
+	std::size_t const bucket = Bucket(rolling_sum);
+	for (std::size_t i = m_buckets[bucket]; i < m_buckets[bucket + 1]; ++i)
+	{
+		Entry const& entry = m_entries[i];
+		if (entry.rolling_sum < rolling_sum) { continue; }
+		if (entry.rolling_sum > rolling_sum) { break; }
+		if (is_match(entry.block)) { return entry.block; }
+	}
+	return LITERAL;
+}
+
+
+
+void
+DeltaMaker::WritePatch(std::vector<ops_t> const& segments)
+{
+	std::uint64_t const file_size = m_cfg.GetInputFileSize();
+
+	// The segments are ordered, a segment can start inside the last copy of
+	// the previous one
+	ops_t ops;
+	std::uint64_t covered = 0;
+	for (ops_t const& segment : segments)
+	{
+		for (Op op : segment)
+		{
+			if (op.offset + op.length <= covered) { continue; }
+			if (op.offset < covered)
+			{
+				std::uint64_t const skip = covered - op.offset;
+				op.offset += skip;
+				op.length -= skip;
+				if (op.source != LITERAL) { op.source += skip; }
+			}
+			Append(ops, op);
+			covered = op.offset + op.length;
+		}
+	}
+	if (covered != file_size)
+	{
+		THROW_ERROR("%s: the patch covers %ju bytes of %ju", __FUNCTION__, covered, file_size);
+	}
+
+	FileWriter out(m_cfg.GetOutputFile(), FileWriter::file_type_e::BINARY);
+	FileReader in(m_cfg.GetInputFile().c_str());
+	out.Write(MAGIC, sizeof(MAGIC));
+	out.Write(&m_blockSize, sizeof(m_blockSize), 1);
+	out.Write(&file_size, sizeof(file_size), 1);
+
+	std::vector<uint8_t> buffer(READ_SIZE);
+	for (Op const& op : ops)
+	{
+		if (op.source != LITERAL)
+		{
+			out.Write(&OP_COPY, sizeof(OP_COPY), 1);
+			out.Write(&op.source, sizeof(op.source), 1);
+			out.Write(&op.length, sizeof(op.length), 1);
+			m_copied += op.length;
+			continue;
+		}
+
+		out.Write(&OP_INSERT, sizeof(OP_INSERT), 1);
+		out.Write(&op.length, sizeof(op.length), 1);
+		in.SetPosition(op.offset);
+		for (std::uint64_t remains = op.length; remains > 0;)
+		{
+			auto const size = static_cast<std::size_t>(std::min<std::uint64_t>(remains, buffer.size()));
+			if (in.Read(buffer.data(), size) != size)
+			{
+				THROW_ERROR("%s: unexpected end of the file [%s]", __FUNCTION__, in.GetName());
+			}
+			out.Write(buffer.data(), size);
+			remains -= size;
+		}
+		m_literal += op.length;
+	}
+}
+
+
+
+// static
+void
+DeltaMaker::Append(ops_t& ops, Op const& op)
+{
+	if (not ops.empty())
+	{
+		Op& last = ops.back();
+		bool const both_literal = (last.source == LITERAL and op.source == LITERAL);
+		bool const both_copy    = (last.source != LITERAL and op.source != LITERAL);
+		if (last.offset + last.length == op.offset
+			and (both_literal or (both_copy and last.source + last.length == op.source)))
+		{
+			last.length += op.length;
+			return;
+		}
+	}
+	ops.push_back(op);
+}
+
+
+
+// Fibonacci hashing: the high bits of the product depend on all bits of the
+// rolling sum
+std::size_t
+DeltaMaker::Bucket(uint32_t rolling_sum) const noexcept
+{
+	return static_cast<std::size_t>((rolling_sum * std::uint64_t{0x9E3779B97F4A7C15ull}) >> (64 - m_bucketsBits));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include <cstdint>
+
+#include "algo/HasherFactory.hpp"
+#include "Config.hpp"
+
+
+
+class FileWriter;
+
+
+
+// The `delta` command: the rsync algorithm driven by a signature with the
+// rolling sums (see Config::IsRollingSum). The blocks of the old file are
+// indexed by their rolling sums (a bucket per block on average, the blocks
+// with the same content once); the rolling sum slides over the new file and
+// a match is confirmed by the signature of the block. The new file is split
+// on segments which are scanned in parallel.
+//
+// The patch (the fields are in the host byte order):
+//   header: MAGIC[8], block size (u64), new file size (u64)
+//   COPY:   OP_COPY (u8), offset in the old file (u64), length (u64)
+//   INSERT: OP_INSERT (u8), length (u64), the bytes
+//NOTE: a COPY of the last block of the old file can pass its end: the
+// missing bytes are the block filler (they were hashed as it).
+class DeltaMaker
+{
+public:
+	static constexpr char     MAGIC[8]         = {'S', 'I', 'G', 'D', 'E', 'L', 'T', 'A'};
+	static constexpr uint8_t  OP_COPY          = 1;
+	static constexpr uint8_t  OP_INSERT        = 2;
+	static constexpr uint64_t MIN_SEGMENT_SIZE = 4 * 1024 * 1024;
+	static constexpr size_t   MIN_BUCKETS_BITS = 10;
+
+	DeltaMaker(DeltaMaker&&)                  = delete;
+	DeltaMaker(DeltaMaker const&)             = delete;
+	DeltaMaker& operator= (DeltaMaker&&)      = delete;
+	DeltaMaker& operator= (DeltaMaker const&) = delete;
+
+	explicit DeltaMaker(Config const&);
+	~DeltaMaker() = default;
+
+	bool Run() noexcept;
+
+private:
+	static constexpr uint64_t LITERAL = UINT64_MAX;
+
+	struct Op
+	{
+		uint64_t offset; // in the new file
+		uint64_t length;
+		uint64_t source; // the offset in the old file or LITERAL
+	};
+	using ops_t = std::vector<Op>;
+
+	struct Entry
+	{
+		uint32_t rolling_sum;
+		uint64_t block;
+	};
+
+	void LoadSignature();
+	void ScanSegment(uint64_t begin, uint64_t end, ops_t&) const;
+	uint64_t FindBlock(algo::IHasher&, uint32_t rolling_sum, uint8_t const* window,
+	                   uint64_t preferred, std::vector<uint8_t>& digest) const;
+	void WritePatch(std::vector<ops_t> const&);
+	static void Append(ops_t&, Op const&);
+	std::size_t Bucket(uint32_t rolling_sum) const noexcept;
+
+private:
+	Config const&            m_cfg;
+	uint64_t                 m_blockSize;
+	std::size_t              m_digestSize;
+	std::vector<uint8_t>     m_digests;     // by the block number
+	std::vector<uint32_t>    m_rollingSums; // by the block number
+	std::vector<Entry>       m_entries;     // sorted by the bucket
+	std::vector<std::size_t> m_buckets;     // the first entry of each bucket
+	std::size_t              m_bucketsBits = MIN_BUCKETS_BITS;
+	uint64_t                 m_copied  = 0;
+	uint64_t                 m_literal = 0;
+};
@@ -0,0 +1,180 @@
+#include "MerkleTree.hpp"
+
+#include <algorithm>
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/FileWriter.hpp"
+#include "algo/IHasher.hpp"
+
+
+
+namespace {
+
+constexpr uint8_t LEAF_PREFIX = 0x00;
+constexpr uint8_t NODE_PREFIX = 0x01;
+
+} // namespace
+
+
+
+MerkleTree::MerkleTree(algo::InitHashStrategy const& strategy, std::uint64_t leaves_count)
+	: m_strategy(strategy.GetType())
+	, m_hasher(algo::HasherFactory::Create(m_strategy))
+	, m_digestSize(m_hasher->ResultSize())
+{
+	// level k + 1 has ceil(n_k / 2) nodes, the last level is the root
+	std::uint64_t count = leaves_count;
+	do
+	{
+		Level& level = m_levels.emplace_back();
+		level.digests.resize(count * m_digestSize);
+		level.known.resize(count, false);
+		count = (count + 1) / 2;
+	}
+	while (m_levels.back().known.size() > 1);
+
+	if (leaves_count == 0)
+	{
+		//NOTE: RFC 6962: the hash of an empty list is the hash of an empty string
+		m_emptyRoot.resize(m_digestSize);
+		m_hasher->Init(m_strategy);
+		m_hasher->Finish(m_emptyRoot.data());
+	}
+}
+
+
+
+MerkleTree::~MerkleTree() = default;
+
+
+
+void
+MerkleTree::AddLeaf(std::uint64_t index, uint8_t const* signature, std::size_t size)
+{
+	Level& leaves = m_levels.front();
+	if (index >= leaves.known.size() or leaves.known[index])
+	{
+		THROW_ERROR("%s: unexpected leaf #%zu (leaves count %zu)",
+			__FUNCTION__, index, leaves.known.size());
+	}
+	Hash(LEAF_PREFIX, signature, nullptr, size, RefDigest(0, index));
+	leaves.known[index] = true;
+
+	// Go up while both children of the parent are known
+	std::uint64_t pos = index;
+	for (std::size_t lvl = 0; lvl + 1 < m_levels.size(); ++lvl, pos /= 2)
+	{
+		Level const& level = m_levels[lvl];
+		std::uint64_t const left = pos & ~std::uint64_t{1};
+		uint8_t* const parent = RefDigest(lvl + 1, pos / 2);
+		if (left + 1 < level.known.size())
+		{
+			if (not level.known[left] or not level.known[left + 1]) { return; }
+			Hash(NODE_PREFIX, GetDigest(lvl, left), GetDigest(lvl, left + 1), m_digestSize, parent);
+		}
+		else
+		{
+			// the last node without a pair
+			std::memcpy(parent, GetDigest(lvl, pos), m_digestSize);
+		}
+		m_levels[lvl + 1].known[pos / 2] = true;
+	}
+}
+
+
+
+bool
+MerkleTree::IsComplete() const noexcept
+{
+	std::vector<bool> const& root = m_levels.back().known;
+	return root.empty() or root.front();
+}
+
+
+
+uint8_t const*
+MerkleTree::GetRoot() const noexcept
+{
+	if (not IsComplete()) { return nullptr; }
+	return (GetLeavesCount() == 0) ? m_emptyRoot.data() : GetDigest(m_levels.size() - 1, 0);
+}
+
+
+
+std::size_t
+MerkleTree::GetProof(std::uint64_t index, uint8_t const** path) const
+{
+	std::size_t length = 0;
+	std::uint64_t pos = index;
+	for (std::size_t lvl = 0; lvl + 1 < m_levels.size(); ++lvl, pos /= 2)
+	{
+		std::uint64_t const sibling = pos ^ 1;
+		if (sibling < m_levels[lvl].known.size())
+		{
+			path[length++] = GetDigest(lvl, sibling);
+		}
+	}
+	return length;
+}
+
+
+
+void
+MerkleTree::Save(FileWriter& out) const
+{
+	uint8_t const* const root = GetRoot();
+	if (not root) { THROW_ERROR("%s: the tree is not complete", __FUNCTION__); }
+
+	std::uint64_t const leaves = GetLeavesCount();
+	auto const digest_size = static_cast<uint32_t>(m_digestSize);
+	auto const depth       = static_cast<uint32_t>(GetDepth());
+	out.Write(MAGIC, sizeof(MAGIC));
+	out.Write(&leaves, sizeof(leaves), 1);
+	out.Write(&digest_size, sizeof(digest_size), 1);
+	out.Write(&depth, sizeof(depth), 1);
+	out.Write(root, m_digestSize);
+
+	std::vector<uint8_t const*> path(depth);
+	std::vector<uint8_t> const zeros(m_digestSize, 0);
+	for (std::uint64_t index = 0; index < leaves; ++index)
+	{
+		auto const length = static_cast<uint32_t>(GetProof(index, path.data()));
+		out.Write(&index, sizeof(index), 1);
+		out.Write(&length, sizeof(length), 1);
+		for (uint32_t i = 0; i < depth; ++i)
+		{
+			out.Write((i < length) ? path[i] : zeros.data(), m_digestSize);
+		}
+	}
+}
+
+
+
+uint8_t*
+MerkleTree::RefDigest(std::size_t level, std::uint64_t index) noexcept
+{
+	return m_levels[level].digests.data() + index * m_digestSize;
+}
+
+
+
+uint8_t const*
+MerkleTree::GetDigest(std::size_t level, std::uint64_t index) const noexcept
+{
+	return m_levels[level].digests.data() + index * m_digestSize;
+}
+
+
+
+void
+MerkleTree::Hash(uint8_t prefix, uint8_t const* left, uint8_t const* right,
+                 std::size_t size, uint8_t* result)
+{
+	m_hasher->Init(m_strategy);
+	m_hasher->Update(&prefix, 1);
+	m_hasher->Update(left, size);
+	if (right) { m_hasher->Update(right, size); }
+	m_hasher->Finish(result);
+}
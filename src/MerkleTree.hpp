@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include <cstdint>
+
+#include "algo/HasherFactory.hpp"
+
+
+
+class FileWriter;
+
+
+
+// Merkle tree over the block signatures with the hashing of RFC 6962:
+// leaf = H(0x00 || signature), node = H(0x01 || left || right), where H is
+// the signature algorithm. The last node of a level without a pair is moved
+// to the next level as is, so the tree is the same as the RFC 6962 one for any
+// number of leaves. The leaves can be added in any order: a node is computed
+// as soon as both its children are known.
+class MerkleTree
+{
+public:
+	// The sidecar file (see Save) starts with the header, which is followed by
+	// a record per block (the fields are in the host byte order):
+	//   header: MAGIC[8], leaves (u64), digest size (u32), depth (u32), root
+	//   record: block number (u64), path length (u32), `depth` digests
+	// The path is the digests of the siblings from the leaf to the root; the
+	// unused digests of the record are zeroed, so the records have the same size.
+	static constexpr char MAGIC[8] = {'M', 'E', 'R', 'K', 'L', 'E', '0', '1'};
+
+	MerkleTree(MerkleTree&&)                  = delete;
+	MerkleTree(MerkleTree const&)             = delete;
+	MerkleTree& operator= (MerkleTree&&)      = delete;
+	MerkleTree& operator= (MerkleTree const&) = delete;
+
+	MerkleTree(algo::InitHashStrategy const&, std::uint64_t leaves_count);
+	~MerkleTree();
+
+	void AddLeaf(std::uint64_t index, uint8_t const* signature, std::size_t size);
+	bool IsComplete() const noexcept;
+
+	std::size_t GetDigestSize() const noexcept    { return m_digestSize; }
+	std::size_t GetDepth() const noexcept         { return m_levels.size() - 1; }
+	std::uint64_t GetLeavesCount() const noexcept { return m_levels.front().known.size(); }
+	// Returns nullptr until the tree is complete
+	uint8_t const* GetRoot() const noexcept;
+	// Fills `path` (GetDepth() items at most) and returns its length
+	std::size_t GetProof(std::uint64_t index, uint8_t const** path) const;
+
+	void Save(FileWriter&) const;
+
+private:
+	struct Level
+	{
+		std::vector<uint8_t> digests;
+		std::vector<bool>    known;
+	};
+
+	uint8_t* RefDigest(std::size_t level, std::uint64_t index) noexcept;
+	uint8_t const* GetDigest(std::size_t level, std::uint64_t index) const noexcept;
+	void Hash(uint8_t prefix, uint8_t const* left, uint8_t const* right, std::size_t size, uint8_t* result);
+
+private:
+	algo::InitHashStrategy        m_strategy;
+	algo::HasherFactory::hasher_t m_hasher;
+	std::size_t                   m_digestSize;
+	std::vector<Level>            m_levels;    // from the leaves to the root
+	std::vector<uint8_t>          m_emptyRoot; // the root of the tree without leaves
+};
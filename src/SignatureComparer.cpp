@@ -0,0 +1,264 @@
+#include "SignatureComparer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/CpuFeatures.hpp"
+#include "common/FileWriter.hpp"
+#include "common/Logger.hpp"
+#include "SignatureFile.hpp"
+
+
+
+namespace {
+
+std::size_t
+FindMismatchPortable(uint8_t const* lhs, uint8_t const* rhs, std::size_t size) noexcept
+{
+	std::size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t l, r;
+		std::memcpy(&l, lhs + i, sizeof(l));
+		std::memcpy(&r, rhs + i, sizeof(r));
+		if (l != r) { break; }
+	}
+	for (; i < size; ++i)
+	{
+		if (lhs[i] != rhs[i]) { return i; }
+	}
+	return size;
+}
+
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+inline uint32_t
+EqualMaskAvx2(uint8_t const* lhs, uint8_t const* rhs) noexcept
+{
+	return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+		_mm256_loadu_si256(reinterpret_cast<__m256i const*>(lhs)),
+		_mm256_loadu_si256(reinterpret_cast<__m256i const*>(rhs)))));
+}
+
+
+__attribute__((target("avx2")))
+std::size_t
+FindMismatchAvx2(uint8_t const* lhs, uint8_t const* rhs, std::size_t size) noexcept
+{
+	std::size_t i = 0;
+	// 4 vectors per iteration, the mismatch is located by the next loop
+	for (; i + 128 <= size; i += 128)
+	{
+		uint32_t const eq = EqualMaskAvx2(lhs + i, rhs + i) & EqualMaskAvx2(lhs + i + 32, rhs + i + 32)
+			& EqualMaskAvx2(lhs + i + 64, rhs + i + 64) & EqualMaskAvx2(lhs + i + 96, rhs + i + 96);
+		if (eq != ~uint32_t{0}) { break; }
+	}
+	for (; i + 32 <= size; i += 32)
+	{
+		uint32_t const ne = ~EqualMaskAvx2(lhs + i, rhs + i);
+		if (ne != 0) { return i + static_cast<std::size_t>(__builtin_ctz(ne)); }
+	}
+	return i + FindMismatchPortable(lhs + i, rhs + i, size - i);
+}
+
+
+__attribute__((target("avx512f,avx512bw")))
+inline uint64_t
+NotEqualMaskAvx512(uint8_t const* lhs, uint8_t const* rhs) noexcept
+{
+	return _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(lhs), _mm512_loadu_si512(rhs));
+}
+
+
+__attribute__((target("avx512f,avx512bw")))
+std::size_t
+FindMismatchAvx512(uint8_t const* lhs, uint8_t const* rhs, std::size_t size) noexcept
+{
+	std::size_t i = 0;
+	// 4 vectors per iteration, the mismatch is located by the next loop
+	for (; i + 256 <= size; i += 256)
+	{
+		uint64_t const ne = NotEqualMaskAvx512(lhs + i, rhs + i) | NotEqualMaskAvx512(lhs + i + 64, rhs + i + 64)
+			| NotEqualMaskAvx512(lhs + i + 128, rhs + i + 128) | NotEqualMaskAvx512(lhs + i + 192, rhs + i + 192);
+		if (ne != 0) { break; }
+	}
+	for (; i + 64 <= size; i += 64)
+	{
+		uint64_t const ne = NotEqualMaskAvx512(lhs + i, rhs + i);
+		if (ne != 0) { return i + static_cast<std::size_t>(__builtin_ctzll(ne)); }
+	}
+	if (i < size)
+	{
+		__mmask64 const tail = ~uint64_t{0} >> (64 - (size - i));
+		uint64_t const ne = _mm512_mask_cmpneq_epi8_mask(tail,
+			_mm512_maskz_loadu_epi8(tail, lhs + i), _mm512_maskz_loadu_epi8(tail, rhs + i));
+		if (ne != 0) { return i + static_cast<std::size_t>(__builtin_ctzll(ne)); }
+	}
+	return size;
+}
+#endif // __x86_64__
+
+
+
+// Returns the records of the blocks [first, first + count) in the order of the
+// blocks: in place when the file is ordered, else they are copied to `buffer`
+uint8_t const*
+GatherRecords(SignatureFile const& file, std::uint64_t first, std::uint64_t count,
+              std::vector<uint8_t>& buffer) noexcept
+{
+	if (file.IsOrdered()) { return file.GetRecord(first); }
+
+	std::size_t const record_size = file.GetRecordSize();
+	for (std::uint64_t i = 0; i < count; ++i)
+	{
+		std::memcpy(buffer.data() + i * record_size, file.GetRecord(first + i), record_size);
+	}
+	return buffer.data();
+}
+
+} // namespace
+
+
+
+SignatureComparer::SignatureComparer(Config const& cfg)
+	: m_cfg(cfg)
+	, m_recordSize(SignatureFile::RecordSize(cfg))
+{}
+
+
+
+SignatureComparer::~SignatureComparer() = default;
+
+
+
+SignatureComparer::result_e
+SignatureComparer::Run() noexcept
+{
+	try
+	{
+		SignatureFile const lhs(m_cfg.GetSignatureFile().c_str(), m_recordSize);
+		SignatureFile const rhs(m_cfg.GetInputFile().c_str(), m_recordSize);
+		std::uint64_t const lhs_count = lhs.GetCount();
+		std::uint64_t const rhs_count = rhs.GetCount();
+		std::uint64_t const count = std::min(lhs_count, rhs_count);
+		bool const ordered = lhs.IsOrdered() and rhs.IsOrdered();
+
+		m_out = std::make_unique<FileWriter>(m_cfg.GetOutputFile(), FileWriter::file_type_e::TEXT);
+		if (ordered)
+		{
+			CompareOrdered(lhs.GetData(), rhs.GetData(), 0, count);
+		}
+		else
+		{
+			CompareIndexed(lhs, rhs, count);
+		}
+		if (count < std::max(lhs_count, rhs_count))
+		{
+			AddDiff(count, std::max(lhs_count, rhs_count) - 1);
+		}
+		FlushRange();
+
+		LOG_I("Compare: %ju of %ju blocks differ (%s order)", m_diffCount,
+			std::max(lhs_count, rhs_count), ordered ? "block" : "random");
+		return (m_diffCount == 0) ? result_e::SAME : result_e::DIFFERENT;
+	}
+	catch (std::exception const& ex)
+	{
+		LOG_E("Compare failed: %s", ex.what());
+	}
+	return result_e::FAILED;
+}
+
+
+
+// static
+std::size_t
+SignatureComparer::FindMismatch(uint8_t const* lhs, uint8_t const* rhs, std::size_t size) noexcept
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX512F | CpuFeatures::AVX512BW))
+	{
+		return FindMismatchAvx512(lhs, rhs, size);
+	}
+	if (CpuFeatures::Has(CpuFeatures::AVX2))
+	{
+		return FindMismatchAvx2(lhs, rhs, size);
+	}
+#endif
+	return FindMismatchPortable(lhs, rhs, size);
+}
+
+
+
+// The records of the blocks [first, first + count): the block numbers are the
+// same, so a mismatch is in the signature
+void
+SignatureComparer::CompareOrdered(uint8_t const* lhs, uint8_t const* rhs, std::uint64_t first, std::uint64_t count)
+{
+	std::size_t const size = count * m_recordSize;
+	std::size_t pos = 0;
+	while (pos < size)
+	{
+		pos += FindMismatch(lhs + pos, rhs + pos, size - pos);
+		if (pos == size) { break; }
+		std::uint64_t const block = pos / m_recordSize;
+		AddDiff(first + block, first + block);
+		pos = (block + 1) * m_recordSize;
+	}
+}
+
+
+
+// The records are permuted into the order of the blocks by chunks, and the
+// chunks are compared as the ordered files
+void
+SignatureComparer::CompareIndexed(SignatureFile const& lhs, SignatureFile const& rhs, std::uint64_t count)
+{
+	std::uint64_t const chunk = std::max<std::size_t>(SCRATCH_SIZE / m_recordSize, 1);
+	std::vector<uint8_t> lhs_buffer(lhs.IsOrdered() ? 0 : chunk * m_recordSize);
+	std::vector<uint8_t> rhs_buffer(rhs.IsOrdered() ? 0 : chunk * m_recordSize);
+	for (std::uint64_t first = 0; first < count; first += chunk)
+	{
+		std::uint64_t const n = std::min(chunk, count - first);
+		CompareOrdered(GatherRecords(lhs, first, n, lhs_buffer),
+		               GatherRecords(rhs, first, n, rhs_buffer), first, n);
+	}
+}
+
+
+
+void
+SignatureComparer::AddDiff(std::uint64_t first, std::uint64_t last)
+{
+	if (m_diffCount > 0 and first == m_rangeLast + 1)
+	{
+		m_rangeLast = last;
+	}
+	else
+	{
+		FlushRange();
+		m_rangeFirst = first;
+		m_rangeLast  = last;
+	}
+	m_diffCount += last - first + 1;
+}
+
+
+
+void
+SignatureComparer::FlushRange()
+{
+	if (m_diffCount == 0) { return; }
+	char line[64];
+	int const len = (m_rangeFirst == m_rangeLast)
+		? std::snprintf(line, sizeof(line), "%ju\n", m_rangeFirst)
+		: std::snprintf(line, sizeof(line), "%ju-%ju\n", m_rangeFirst, m_rangeLast);
+	m_out->Write(line, static_cast<std::size_t>(len));
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+
+#include <cstdint>
+
+#include "Config.hpp"
+
+
+
+class FileWriter;
+class SignatureFile;
+
+
+
+// The `compare` command: the differing blocks of two signatures of the fixed
+// mode. Both files are mapped and compared as the byte arrays by the SIMD
+// kernel, only the mismatches are decoded. The records of a signature made by
+// several Workers aren't in the order of the blocks (the usual case): they are
+// permuted into it through the index of SignatureFile by chunks of
+// SCRATCH_SIZE bytes first.
+//
+// The output is a text line per range of the differing blocks: `FIRST-LAST`
+// or `BLOCK`. The blocks which are present in one signature only differ.
+class SignatureComparer
+{
+public:
+	enum class result_e : uint8_t { SAME, DIFFERENT, FAILED };
+
+	SignatureComparer(SignatureComparer&&)                  = delete;
+	SignatureComparer(SignatureComparer const&)             = delete;
+	SignatureComparer& operator= (SignatureComparer&&)      = delete;
+	SignatureComparer& operator= (SignatureComparer const&) = delete;
+
+	explicit SignatureComparer(Config const&);
+	~SignatureComparer();
+
+	result_e Run() noexcept;
+
+	// The buffer of the permuted records of a file
+	static constexpr std::size_t SCRATCH_SIZE = 4 * 1024 * 1024;
+
+	// Returns the offset of the first differing byte or `size`
+	static std::size_t FindMismatch(uint8_t const* lhs, uint8_t const* rhs, std::size_t size) noexcept;
+
+private:
+	void CompareOrdered(uint8_t const* lhs, uint8_t const* rhs, std::uint64_t first, std::uint64_t count);
+	void CompareIndexed(SignatureFile const&, SignatureFile const&, std::uint64_t count);
+	void AddDiff(std::uint64_t first, std::uint64_t last);
+	void FlushRange();
+
+private:
+	Config const&               m_cfg;
+	std::size_t                 m_recordSize;
+	std::unique_ptr<FileWriter> m_out;
+	std::uint64_t               m_rangeFirst = 0;
+	std::uint64_t               m_rangeLast  = 0;
+	std::uint64_t               m_diffCount  = 0;
+};
@@ -0,0 +1,64 @@
+#include "SignatureFile.hpp"
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "algo/IHasher.hpp"
+#include "Config.hpp"
+
+
+
+namespace {
+
+constexpr std::uint64_t NO_RECORD = UINT64_MAX;
+
+} // namespace
+
+
+
+SignatureFile::SignatureFile(char const* name, std::size_t record_size)
+	: m_file(name)
+	, m_recordSize(record_size)
+	, m_count(m_file.GetSize() / record_size)
+{
+	if (m_file.GetSize() % m_recordSize != 0)
+	{
+		THROW_ERROR("%s: the size of [%s] is not a multiple of the record size %zu "
+			"(check -o sign_algo and -o rolling_sum)",
+			__FUNCTION__, GetName(), m_recordSize);
+	}
+	m_file.AdviseSequential();
+
+	uint8_t const* const data = m_file.GetData();
+	std::uint64_t block = 0;
+	std::uint64_t rec = 0;
+	for (; rec < m_count; ++rec)
+	{
+		std::memcpy(&block, data + rec * m_recordSize, sizeof(block));
+		if (block != rec) { break; }
+	}
+	if (rec == m_count) { return; }
+
+	m_index.assign(m_count, NO_RECORD);
+	for (rec = 0; rec < m_count; ++rec)
+	{
+		std::memcpy(&block, data + rec * m_recordSize, sizeof(block));
+		if (block >= m_count or m_index[block] != NO_RECORD)
+		{
+			THROW_ERROR("%s: unexpected block #%ju in [%s] (blocks count %ju)",
+				__FUNCTION__, block, GetName(), m_count);
+		}
+		m_index[block] = rec;
+	}
+}
+
+
+
+// static
+std::size_t
+SignatureFile::RecordSize(Config const& cfg)
+{
+	return sizeof(std::uint64_t)
+		+ (cfg.IsRollingSum() ? sizeof(uint32_t) : 0)
+		+ algo::HasherFactory::Create(*cfg.GetInitAlgo())->ResultSize();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include <cstdint>
+
+#include "common/MappedFile.hpp"
+
+
+
+class Config;
+
+
+
+// A signature of the fixed mode mapped to the memory. The Workers save the
+// records in the order of completion, so the records are indexed by the
+// block numbers unless they are already in the block order.
+class SignatureFile
+{
+public:
+	SignatureFile(SignatureFile&&)                  = delete;
+	SignatureFile(SignatureFile const&)             = delete;
+	SignatureFile& operator= (SignatureFile&&)      = delete;
+	SignatureFile& operator= (SignatureFile const&) = delete;
+
+	SignatureFile(char const* name, std::size_t record_size);
+	~SignatureFile() = default;
+
+	// The record of the current configuration: block number (u64), rolling
+	// sum (u32, if Config::IsRollingSum), signature
+	static std::size_t RecordSize(Config const&);
+
+	char const* GetName() const noexcept       { return m_file.GetName(); }
+	uint8_t const* GetData() const noexcept    { return m_file.GetData(); }
+	std::size_t GetRecordSize() const noexcept { return m_recordSize; }
+	std::uint64_t GetCount() const noexcept    { return m_count; }
+	// The record `i` is the block `i`
+	bool IsOrdered() const noexcept            { return m_index.empty(); }
+
+	uint8_t const* GetRecord(std::uint64_t block) const noexcept
+	{
+		return GetData() + (IsOrdered() ? block : m_index[block]) * m_recordSize;
+	}
+
+private:
+	MappedFile                 m_file;
+	std::size_t                m_recordSize;
+	std::uint64_t              m_count;
+	std::vector<std::uint64_t> m_index; // the record of each block
+};
@@ -1,26 +1,162 @@
 #include "Worker.hpp"
 
 #include <algorithm>
+#include <istream>
+
+#include <cstring>
 
 #include <cstdarg>
 
 #include "common/Logger.hpp"
+#include "common/ZeroBytes.hpp"
 #include "algo/HasherFactory.hpp"
+#include "algo/HasherDispatch.hpp"
 #include "WorkerManager.hpp"
+#include "BlockRing.hpp"
+#include "Chunker.hpp"
+
+
+
+namespace {
+
+// The size of the reads of a Worker: the reads ahead of io_e::URING
+std::size_t
+ReadAheadSize(Config const& cfg) noexcept
+{
+	if (cfg.GetChunking() == Config::chunking_e::CDC) { return 0; }
+	if (cfg.GetBlockParts() > 1) { return static_cast<std::size_t>(cfg.GetBlockPartSize()); }
+	return cfg.GetBlockBatch() * cfg.GetBlockSizeKB() * 1024;
+}
+
+
+
+// The buffers of the reads ahead of a reader: the readers of all Workers
+// share UringFile::MAX_ARENA_SIZE, and a reader doesn't need more than its
+// share of the file
+std::size_t
+ReadAheadBudget(Config const& cfg) noexcept
+{
+	std::uint64_t const group   = cfg.GetBlockLanes() * cfg.GetBlockBatch();
+	std::uint64_t const workers = cfg.IsPipeline() ? 1 : std::max<std::uint64_t>(cfg.GetBlocksShift() / group, 1);
+	std::uint64_t const readers = workers * cfg.GetBlockLanes();
+	std::uint64_t const share   = cfg.GetInputFileSize() / readers + ReadAheadSize(cfg);
+	return static_cast<std::size_t>(std::min<std::uint64_t>(UringFile::MAX_ARENA_SIZE / readers, share));
+}
+
+
+
+// The hashing Workers of the pipeline don't read the file: they get the idle
+// reader of stdin (a FIFO isn't opened by each of them)
+char const*
+WorkerInput(Config const& cfg, Worker::role_e role) noexcept
+{
+	return (cfg.IsPipeline() and role == Worker::role_e::HASHER)
+		? nullptr
+		: cfg.GetInputFile().c_str();
+}
+
+
+
+FileReader::io_e
+WorkerIo(Config const& cfg, Worker::role_e role) noexcept
+{
+	return (cfg.IsPipeline() and role == Worker::role_e::HASHER)
+		? FileReader::io_e::STREAM
+		: cfg.GetIo();
+}
 
 
 
-Worker::Worker(WorkerManager& mgr, std::uint64_t block_num)
+// Hashes `size` bytes of `data` (`size` bytes `fill` when `data` is nullptr).
+// While `skip_zeros` is set, the zero bytes are counted in `zeros` instead:
+// they are hashed when the first non-zero byte is met.
+template <typename Hasher>
+void
+UpdateSkippingZeros(Hasher& hasher, algo::Rollsum* weak, uint8_t const* data, uint8_t fill,
+                    std::uintmax_t size, std::uintmax_t& zeros, bool& skip_zeros)
+{
+	if (skip_zeros)
+	{
+		if (data ? AreZeroBytes(data, size) : fill == 0)
+		{
+			zeros += size;
+			return;
+		}
+		skip_zeros = false;
+		if (zeros != 0)
+		{
+			hasher.UpdateFill(0, zeros);
+			if (weak) { weak->UpdateFill(0, zeros); }
+		}
+	}
+	if (data)
+	{
+		hasher.Update(data, size);
+		if (weak) { weak->Update(data, size); }
+	}
+	else
+	{
+		hasher.UpdateFill(fill, size);
+		if (weak) { weak->UpdateFill(fill, size); }
+	}
+}
+
+} // namespace
+
+
+
+Worker::Worker(WorkerManager& mgr, std::uint64_t block_num, role_e role)
 	: m_mgr(&mgr)
-	, m_in(m_mgr->GetConfig().GetInputFile().c_str())
+	, m_in(WorkerInput(m_mgr->GetConfig(), role), WorkerIo(m_mgr->GetConfig(), role),
+	       m_mgr->GetConfig().GetQueueDepth() / m_mgr->GetConfig().GetBlockLanes(),
+	       ReadAheadSize(m_mgr->GetConfig()), ReadAheadBudget(m_mgr->GetConfig()))
 	, m_results(m_mgr->NewResultPool())
 	, m_producer(m_mgr->NewResultProducer())
 	, m_blockNum(block_num)
+	, m_role(role)
 {
 	Config const& cfg = m_mgr->GetConfig();
 
 	m_hasher = algo::HasherFactory::Create(*cfg.GetInitAlgo());
-	m_readBuffer.resize(std::min(cfg.GetReadBufferSize(), cfg.GetBlockSizeKB()*1024));
+	size_t const read_buf_size = std::min(cfg.GetReadBufferSize(), cfg.GetBlockSizeKB()*1024);
+	if (cfg.GetBlockLanes() > 1)
+	{
+		m_multiHasher = algo::HasherFactory::CreateMulti(*cfg.GetInitAlgo());
+		if (not m_multiHasher or m_multiHasher->Lanes() != cfg.GetBlockLanes())
+		{
+			ThrowRuntimeError("%s: can't create multi-buffer hasher with %zu lanes",
+				__FUNCTION__, cfg.GetBlockLanes());
+		}
+		size_t const lanes = m_multiHasher->Lanes();
+		m_lanesIn.reserve(lanes - 1);
+		for (size_t lane = 1; lane < lanes; ++lane)
+		{
+			m_lanesIn.emplace_back(cfg.GetInputFile().c_str(), cfg.GetIo(),
+				cfg.GetQueueDepth() / lanes, ReadAheadSize(cfg), ReadAheadBudget(cfg));
+		}
+		m_readBuffer.resize(lanes * read_buf_size);
+		m_lanesResult.resize(lanes * m_multiHasher->ResultSize());
+	}
+	else if (cfg.GetChunking() == Config::chunking_e::CDC)
+	{
+		//NOTE: the window keeps two chunks at the seam (see DoWorkChunks)
+		m_readBuffer.resize(4 * cfg.GetChunkMax());
+	}
+	else if (cfg.IsPipeline())
+	{
+		//NOTE: the blocks are read to the slots of BlockRing
+	}
+	else if (cfg.GetBlockBatch() > 1)
+	{
+		m_readBuffer.resize(cfg.GetBlockBatch() * cfg.GetBlockSizeKB() * 1024);
+	}
+	else
+	{
+		m_readBuffer.resize(read_buf_size);
+	}
+	m_batchInputs.resize(cfg.GetBlockBatch());
+	m_batchHashes.resize(cfg.GetBlockBatch());
+	m_batchResults.resize(cfg.GetBlockBatch());
 }
 
 
@@ -30,12 +166,13 @@ Worker::RunAsync() noexcept
 {
 	LOG_D("%s: start async running", __FUNCTION__);
 	bool res = false;
-	m_isRunning = false;
+	//NOTE: the flag is set before the start because a short Worker can
+	// finish (and reset the flag) before `std::async` returns
+	m_isRunning = true;
 	try
 	{
 		m_future = std::async(std::launch::async, &Worker::Run, this);
 		res = true;
-		m_isRunning = true;
 	}
 	catch (std::system_error const& ex)
 	{
@@ -46,6 +183,7 @@ Worker::RunAsync() noexcept
 	{
 		LOG_E("%s: caught bad_alloc", __FUNCTION__);
 	}
+	if (not res) { m_isRunning = false; }
 	return res;
 }
 
@@ -77,6 +215,33 @@ Worker::Run() noexcept
 
 void
 Worker::DoWork()
+{
+	if (m_role == role_e::READER) { return DoWorkReader(); }
+	if (m_multiHasher) { return DoWorkLanes(); }
+
+	Config const& cfg = m_mgr->GetConfig();
+	bool const by_ring   = m_mgr->GetRing() != nullptr;
+	bool const by_chunks = cfg.GetChunking() == Config::chunking_e::CDC;
+	bool const by_dirty  = cfg.IsIncremental();
+	bool const by_parts  = cfg.GetBlockParts() > 1;
+	bool const by_batch  = cfg.GetBlockBatch() > 1;
+	algo::DispatchHasher(cfg.GetInitAlgo()->GetType(), *m_hasher,
+		[this, by_ring, by_chunks, by_dirty, by_parts, by_batch](auto& hasher)
+		{
+			if      (by_ring)   { DoWorkRing(hasher); }
+			else if (by_chunks) { DoWorkChunks(hasher); }
+			else if (by_dirty)  { DoWorkDirtyBlocks(hasher); }
+			else if (by_parts)  { DoWorkParts(hasher); }
+			else if (by_batch)  { DoWorkBatch(hasher); }
+			else                { DoWorkBlocks(hasher); }
+		});
+}
+
+
+
+template <typename Hasher>
+void
+Worker::DoWorkBlocks(Hasher& hasher)
 {
 	Config const& cfg = m_mgr->GetConfig();
 	std::uint64_t const last_block_num = cfg.GetLastBlockNum();
@@ -84,12 +249,13 @@ Worker::DoWork()
 	std::uintmax_t const bytes_shift   = cfg.GetFileBytesShift();
 	std::uintmax_t const block_size    = cfg.GetBlockSizeKB() * 1024;
 
+	algo::Rollsum rollsum;
+	algo::Rollsum* const weak = cfg.IsRollingSum() ? &rollsum : nullptr;
+
 	if (m_blockNum > last_block_num) { return; }
 	LOG_D("%s: shift file pointer on the %zuth block", __FUNCTION__, m_blockNum);
 	m_in.SkipNextBytes(block_size * m_blockNum);
 
-	std::uintmax_t remains = 0;
-	std::size_t read_bytes = 0;
 	while (m_blockNum <= last_block_num)
 	{
 		LOG_I("%s: Start calculate BLOCK #%zu", __FUNCTION__, m_blockNum);
@@ -99,56 +265,675 @@ Worker::DoWork()
 			      __FUNCTION__, m_blockNum);
 			break;
 		}
-		remains = block_size;
-		m_hasher->Init(*cfg.GetInitAlgo());
+		WorkerResult& result = AllocateResult(m_blockNum);
+		HashBlock(hasher, result, weak);
+		PushResult(result);
+
+		m_in.SkipNextBytes(bytes_shift);
+		LOG_I("%s: Finish calculate BLOCK #%zu", __FUNCTION__, m_blockNum);
+		m_blockNum += blocks_shift;
+	}
+}
+
+
+
+void
+Worker::DoWorkLanes()
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::uint64_t const last_block_num = cfg.GetLastBlockNum();
+	std::uint64_t const blocks_shift   = cfg.GetBlocksShift();
+	std::uintmax_t const bytes_shift   = cfg.GetFileBytesShift();
+	std::uintmax_t const block_size    = cfg.GetBlockSizeKB() * 1024;
+	std::size_t const lanes            = m_multiHasher->Lanes();
+	std::size_t const result_size      = m_multiHasher->ResultSize();
+	std::size_t const chunk_size       = m_readBuffer.size() / lanes;
+	std::uintmax_t const file_size     = cfg.GetInputFileSize();
+	bool const skip_zeros              = m_mgr->IsSkippingZeros();
+
+	if (m_blockNum > last_block_num) { return; }
+
+	// The lane `i` processes the blocks `m_blockNum + i` (+ blocks_shift)
+	std::vector<FileReader*> readers {&m_in};
+	std::vector<uint8_t const*> lanes_data;
+	std::vector<uint8_t*> lanes_result;
+	for (FileReader& in : m_lanesIn) { readers.push_back(&in); }
+	for (std::size_t lane = 0; lane < lanes; ++lane)
+	{
+		readers[lane]->SkipNextBytes(block_size * (m_blockNum + lane));
+		lanes_data.push_back(m_readBuffer.data() + lane * chunk_size);
+		lanes_result.push_back(m_lanesResult.data() + lane * result_size);
+	}
+
+	std::uintmax_t remains = 0;
+	while (m_blockNum <= last_block_num)
+	{
+		LOG_I("%s: Start calculate BLOCKS #%zu..%zu", __FUNCTION__,
+		      m_blockNum, m_blockNum + lanes - 1);
+		if (IsNeedStop())
+		{
+			LOG_W("%s: Detect 'stop' sign. Abort calculation BLOCK #%zu.",
+			      __FUNCTION__, m_blockNum);
+			break;
+		}
+		//NOTE: the lanes are hashed together, so only the groups of holes
+		// are skipped
+		std::uintmax_t const begin = m_blockNum * block_size;
+		if (skip_zeros and m_mgr->IsHole(begin, begin + lanes * block_size))
+		{
+			for (std::size_t lane = 0; lane < lanes; ++lane)
+			{
+				if (m_blockNum + lane > last_block_num) { break; }
+				WorkerResult& result = AllocateResult(m_blockNum + lane);
+				std::memcpy(result.RefHash().data(), m_mgr->GetZeroDigest(), result_size);
+				PushResult(result);
+				readers[lane]->SkipNextBytes(block_size + bytes_shift);
+			}
+			m_blockNum += blocks_shift;
+			continue;
+		}
+		m_multiHasher->Init(*cfg.GetInitAlgo());
 
-		while (remains != 0)
+		// The blocks are hashed in place when it is possible (io=mmap,
+		// io=direct), the filler needs the buffer
+		bool const in_place = block_size <= m_in.GetMaxView()
+		                      and (m_blockNum + lanes) * block_size <= file_size;
+		for (remains = block_size; remains != 0; )
 		{
-			read_bytes = m_in.Read(m_readBuffer.data(), m_readBuffer.size());
-			if (read_bytes != 0)
+			std::size_t const len = in_place
+				? static_cast<std::size_t>(remains)
+				: std::min<std::uintmax_t>(chunk_size, remains);
+			for (std::size_t lane = 0; lane < lanes; ++lane)
 			{
-				if (remains > read_bytes)
+				uint8_t* const buf = m_readBuffer.data() + lane * chunk_size;
+				std::size_t const read_bytes = readers[lane]->Read(lanes_data[lane], buf, len);
+				if (read_bytes < len)
 				{
-					m_hasher->Update(m_readBuffer.data(), read_bytes);
-					remains -= read_bytes;
+					if (lanes_data[lane] != buf) { std::memcpy(buf, lanes_data[lane], read_bytes); }
+					std::memset(buf + read_bytes, cfg.GetBlockFiller(), len - read_bytes);
+					lanes_data[lane] = buf;
 				}
-				else
-				{
-					m_hasher->Update(m_readBuffer.data(), remains);
-					remains = 0;
-				}
-			}
-			else
-			{
-				m_hasher->Update(cfg.GetBlockFiller(), remains);
-				remains = 0;
 			}
+			m_multiHasher->Update(lanes_data.data(), len);
+			remains -= len;
 		}
-		auto sp_results = m_results.lock();
-		if (not sp_results)
+		m_multiHasher->Finish(lanes_result.data());
+
+		//NOTE: the lanes after the last block hash the filler only
+		for (std::size_t lane = 0; lane < lanes; ++lane)
 		{
-			ThrowRuntimeError("%s: can't allocate result object. Abort execution.",
-				__FUNCTION__);
+			if (m_blockNum + lane > last_block_num) { break; }
+			WorkerResult& result = AllocateResult(m_blockNum + lane);
+			std::memcpy(result.RefHash().data(), lanes_result[lane], result_size);
+			PushResult(result);
+			readers[lane]->SkipNextBytes(bytes_shift);
 		}
-		WorkerResult& result = sp_results->allocate();
-		auto& hash_buf = result.RefHash();
-		hash_buf.resize(m_hasher->ResultSize()); //TODO: resize each time?
-		result.SetBlockNum(m_blockNum);
-		m_hasher->Finish(hash_buf.data());
-		if (not m_producer.push(result))
+		LOG_I("%s: Finish calculate BLOCKS #%zu..%zu", __FUNCTION__,
+		      m_blockNum, m_blockNum + lanes - 1);
+		m_blockNum += blocks_shift;
+	}
+}
+
+
+
+template <typename Hasher>
+void
+Worker::DoWorkParts(Hasher& hasher)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::uint64_t const parts          = cfg.GetBlockParts();
+	std::uint64_t const last_part_num  = (cfg.GetLastBlockNum() + 1) * parts - 1;
+	std::uint64_t const parts_shift    = cfg.GetBlocksShift();
+	std::uintmax_t const block_size    = cfg.GetBlockSizeKB() * 1024;
+	std::uintmax_t const part_size     = cfg.GetBlockPartSize();
+
+	// NOTE: m_blockNum enumerates the parts of all blocks here
+	for (; m_blockNum <= last_part_num; m_blockNum += parts_shift)
+	{
+		std::uint64_t const block_num   = m_blockNum / parts;
+		std::uint64_t const part_num    = m_blockNum % parts;
+		std::uintmax_t const part_begin = part_num * part_size;
+		std::uintmax_t const part_len   = std::min(part_size, block_size - part_begin);
+
+		LOG_I("%s: Start calculate BLOCK #%zu PART #%zu", __FUNCTION__,
+		      block_num, part_num);
+		if (IsNeedStop())
 		{
-			ThrowRuntimeError("%s: can't save the result. Abort execution.",
-				__FUNCTION__);
+			LOG_W("%s: Detect 'stop' sign. Abort calculation BLOCK #%zu PART #%zu.",
+			      __FUNCTION__, block_num, part_num);
+			break;
 		}
+		m_in.SetPosition(block_num * block_size + part_begin);
+		hasher.InitPart(*cfg.GetInitAlgo(), part_begin);
+		HashNextBytes(hasher, part_len);
+
+		WorkerResult& result = AllocateResult(block_num);
+		result.SetPartNum(part_num);
+		result.RefHash().resize(hasher.PartResultSize());
+		hasher.FinishPart(result.RefHash().data());
+		PushResult(result);
+		LOG_I("%s: Finish calculate BLOCK #%zu PART #%zu", __FUNCTION__,
+		      block_num, part_num);
+	}
+}
+
+
+
+template <typename Hasher>
+void
+Worker::DoWorkBatch(Hasher& hasher)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::uint64_t const last_block_num = cfg.GetLastBlockNum();
+	std::uint64_t const blocks_shift   = cfg.GetBlocksShift();
+	std::uintmax_t const bytes_shift   = cfg.GetFileBytesShift();
+	std::size_t const block_size       = cfg.GetBlockSizeKB() * 1024;
+	std::size_t const batch            = cfg.GetBlockBatch();
+
+	if (m_blockNum > last_block_num) { return; }
+	LOG_D("%s: shift file pointer on the %zuth block", __FUNCTION__, m_blockNum);
+	m_in.SkipNextBytes(block_size * m_blockNum);
+
+	bool const skip_zeros = m_mgr->IsSkippingZeros();
+
+	while (m_blockNum <= last_block_num)
+	{
+		std::size_t const count = std::min<std::uint64_t>(batch, last_block_num - m_blockNum + 1);
+		LOG_I("%s: Start calculate BLOCKS #%zu..%zu", __FUNCTION__,
+		      m_blockNum, m_blockNum + count - 1);
+		if (IsNeedStop())
+		{
+			LOG_W("%s: Detect 'stop' sign. Abort calculation BLOCK #%zu.",
+			      __FUNCTION__, m_blockNum);
+			break;
+		}
+
+		//NOTE: only the last block of the file can be incomplete
+		std::size_t const size = count * block_size;
+		std::uintmax_t const begin = m_blockNum * block_size;
+		bool const hole = skip_zeros and m_mgr->IsHole(begin, begin + size);
+		uint8_t const* batch_data = m_readBuffer.data();
+		if (hole)
+		{
+			m_in.SkipNextBytes(size);
+		}
+		else if (std::size_t const read_bytes = m_in.Read(batch_data, m_readBuffer.data(), size); read_bytes < size)
+		{
+			if (batch_data != m_readBuffer.data()) { std::memcpy(m_readBuffer.data(), batch_data, read_bytes); }
+			std::memset(m_readBuffer.data() + read_bytes, cfg.GetBlockFiller(), size - read_bytes);
+			batch_data = m_readBuffer.data();
+		}
+
+		HashBlocks(hasher, batch_data, count, hole, nullptr);
 
 		m_in.SkipNextBytes(bytes_shift);
-		LOG_I("%s: Finish calculate BLOCK #%zu", __FUNCTION__, m_blockNum);
+		LOG_I("%s: Finish calculate BLOCKS #%zu..%zu", __FUNCTION__,
+		      m_blockNum, m_blockNum + count - 1);
 		m_blockNum += blocks_shift;
 	}
 }
 
 
 
+template <typename Hasher>
+void
+Worker::DoWorkChunks(Hasher& hasher)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::uint64_t const last_segment   = cfg.GetLastBlockNum();
+	std::uint64_t const segments_shift = cfg.GetBlocksShift();
+	std::uintmax_t const segment_size  = cfg.GetChunkSegmentSize();
+	std::uintmax_t const file_size     = cfg.GetInputFileSize();
+	Chunker const chunker(cfg.GetChunkMin(), cfg.GetChunkAvg(), cfg.GetChunkMax());
+
+	// NOTE: m_blockNum enumerates the segments here. The chunking of a
+	//       segment starts at its beginning and goes on after its end until
+	//       it meets the chunking which starts at the end (the one of the next
+	//       segment): the next chunks are the same. Both chunkings are
+	//       advanced by the lagging one; the chunks of the second one are not
+	//       hashed (the next segment's Worker does it).
+	for (; m_blockNum <= last_segment; m_blockNum += segments_shift)
+	{
+		std::uintmax_t pos  = m_blockNum * segment_size;
+		std::uintmax_t seam = std::min(file_size, pos + segment_size);
+		LOG_I("%s: Start chunking SEGMENT #%zu", __FUNCTION__, m_blockNum);
+
+		m_in.SetPosition(pos);
+		m_windowBegin = m_windowEnd = pos;
+		while (pos != seam)
+		{
+			if (IsNeedStop())
+			{
+				LOG_W("%s: Detect 'stop' sign. Abort chunking SEGMENT #%zu.",
+				      __FUNCTION__, m_blockNum);
+				return;
+			}
+			std::uintmax_t& cursor = (pos < seam) ? pos : seam;
+			std::uintmax_t const end = std::min(file_size, cursor + chunker.GetMax());
+			uint8_t const* const data = ReadWindow(cursor, end);
+			std::size_t const length = chunker.FindCut(data, end - cursor);
+			if (&cursor == &pos)
+			{
+				WorkerResult& result = AllocateResult(m_blockNum);
+				result.SetChunk(pos, length);
+				hasher.Init(*cfg.GetInitAlgo());
+				hasher.Update(data, length);
+				hasher.Finish(result.RefHash().data());
+				PushResult(result);
+			}
+			cursor += length;
+		}
+
+		if (m_blockNum != last_segment)
+		{
+			WorkerResult& result = AllocateResult(m_blockNum);
+			result.SetChunk(pos, 0);
+			result.RefHash().clear();
+			PushResult(result);
+		}
+		LOG_I("%s: Finish chunking SEGMENT #%zu", __FUNCTION__, m_blockNum);
+	}
+}
+
+
+
+template <typename Hasher>
+void
+Worker::DoWorkDirtyBlocks(Hasher& hasher)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::vector<std::uint64_t> const& dirty_blocks = m_mgr->GetDirtyBlocks();
+	std::uint64_t const blocks_shift = cfg.GetBlocksShift();
+	std::uintmax_t const block_size  = cfg.GetBlockSizeKB() * 1024;
+
+	algo::Rollsum rollsum;
+	algo::Rollsum* const weak = cfg.IsRollingSum() ? &rollsum : nullptr;
+
+	// NOTE: m_blockNum enumerates the dirty blocks here, the records of the
+	//       other ones are copied from the base signature by WorkerManager
+	for (; m_blockNum < dirty_blocks.size(); m_blockNum += blocks_shift)
+	{
+		std::uint64_t const block_num = dirty_blocks[m_blockNum];
+		LOG_I("%s: Start calculate BLOCK #%zu", __FUNCTION__, block_num);
+		if (IsNeedStop())
+		{
+			LOG_W("%s: Detect 'stop' sign. Abort calculation BLOCK #%zu.",
+			      __FUNCTION__, block_num);
+			break;
+		}
+		m_in.SetPosition(block_num * block_size);
+		WorkerResult& result = AllocateResult(block_num);
+		HashBlock(hasher, result, weak);
+		PushResult(result);
+		LOG_I("%s: Finish calculate BLOCK #%zu", __FUNCTION__, block_num);
+	}
+}
+
+
+
+// Reads the file sequentially to the slots of the ring: a slot is `batch`
+// blocks, the last one is completed by the filler (see Config::IsPipeline).
+// The blocks of a stream are counted until its end: the last slot is the
+// first short reading.
+void
+Worker::DoWorkReader()
+{
+	Config const& cfg = m_mgr->GetConfig();
+	BlockRing& ring = *m_mgr->GetRing();
+	std::uint64_t const last_block_num = cfg.GetLastBlockNum();
+	std::size_t const block_size       = cfg.GetBlockSizeKB() * 1024;
+	std::size_t const batch            = cfg.GetBlockBatch();
+	bool const skip_holes              = m_mgr->IsSkippingZeros();
+	bool const is_stream               = cfg.IsStreamInput();
+	bool const by_pieces               = block_size > ring.GetSlotSize();
+
+	std::uintmax_t stream_size = 0;
+	bool is_end = false;
+	for (; not is_end and m_blockNum <= last_block_num; m_blockNum += batch)
+	{
+		if (IsNeedStop())
+		{
+			LOG_W("%s: Detect 'stop' sign. Abort reading BLOCK #%zu.",
+			      __FUNCTION__, m_blockNum);
+			break;
+		}
+		//NOTE: a block which is larger than a slot is read by pieces (the
+		// batch is 1 then)
+		//NOTE: the bytes after the end of the file aren't read: they aren't
+		// holes
+		std::size_t const count    = std::min<std::uint64_t>(batch - 1, last_block_num - m_blockNum) + 1;
+		std::uintmax_t const begin = m_blockNum * block_size;
+		std::size_t const size     = is_stream
+			? count * block_size
+			: std::min<std::uintmax_t>(count * block_size, cfg.GetInputFileSize() - begin);
+		for (std::size_t offset = 0; offset < size; )
+		{
+			BlockRing::Slot* const slot = ring.AcquireFree();
+			if (not slot)
+			{
+				is_end = true;
+				break;
+			}
+			std::size_t const piece = std::min(size - offset, ring.GetSlotSize());
+			slot->first_block = m_blockNum;
+			slot->count       = count;
+			slot->offset      = offset;
+			slot->is_hole     = skip_holes and m_mgr->IsHole(begin + offset, begin + offset + piece);
+
+			std::size_t read_bytes = piece;
+			if (slot->is_hole) { m_in.SkipNextBytes(piece); }
+			else               { read_bytes = m_in.Read(slot->data, piece); }
+			offset += read_bytes;
+			slot->size    = read_bytes;
+			slot->is_last = (offset == size) or (read_bytes < piece);
+			if (is_stream and read_bytes < piece)
+			{
+				is_end      = true;
+				slot->count = (offset + block_size - 1) / block_size;
+				stream_size = begin + offset;
+				m_mgr->SetStreamSize(stream_size);
+			}
+			if (slot->count == 0)
+			{
+				ring.Release(*slot);
+				break;
+			}
+			//NOTE: the tail of the last piece is filled by the hashing Worker
+			if (std::size_t const filled = slot->count * block_size;
+			    not by_pieces and not slot->is_hole and read_bytes < filled)
+			{
+				std::memset(slot->data + read_bytes, cfg.GetBlockFiller(), filled - read_bytes);
+			}
+			ring.Publish(*slot);
+			if (slot->is_last) { break; }
+		}
+	}
+	if (is_end and stream_size != 0)
+	{
+		LOG_I("%s: the stream [%s] is ended: %zu bytes", __FUNCTION__, m_in.GetName(), stream_size);
+	}
+	ring.Finish();
+}
+
+
+
+// Hashes the slots of the ring in the order they are read
+template <typename Hasher>
+void
+Worker::DoWorkRing(Hasher& hasher)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	BlockRing& ring = *m_mgr->GetRing();
+	bool const by_pieces = cfg.GetBlockSizeKB() * 1024 > ring.GetSlotSize();
+
+	algo::Rollsum rollsum;
+	algo::Rollsum* const weak = cfg.IsRollingSum() ? &rollsum : nullptr;
+
+	while (BlockRing::Slot* const slot = ring.AcquireFilled())
+	{
+		m_blockNum = slot->first_block;
+		std::size_t const count = slot->count;
+		if (IsNeedStop())
+		{
+			LOG_W("%s: Detect 'stop' sign. Abort calculation BLOCK #%zu.",
+			      __FUNCTION__, m_blockNum);
+			ring.Release(*slot);
+			break;
+		}
+		LOG_I("%s: Start calculate BLOCKS #%zu..%zu", __FUNCTION__,
+		      m_blockNum, m_blockNum + count - 1);
+		if (by_pieces)
+		{
+			if (not HashPieces(hasher, ring, *slot, weak)) { break; }
+		}
+		else
+		{
+			HashBlocks(hasher, slot->data, slot->count, slot->is_hole, weak);
+			ring.Release(*slot);
+		}
+		LOG_I("%s: Finish calculate BLOCKS #%zu..%zu", __FUNCTION__,
+		      m_blockNum, m_blockNum + count - 1);
+	}
+}
+
+
+
+// Hashes the block m_blockNum by its pieces from `first`, the pieces are
+// released. Returns false when the ring is closed.
+template <typename Hasher>
+bool
+Worker::HashPieces(Hasher& hasher, BlockRing& ring, BlockRing::Slot& first, algo::Rollsum* weak)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::size_t const block_size = cfg.GetBlockSizeKB() * 1024;
+
+	WorkerResult& result = AllocateResult(m_blockNum);
+	hasher.Init(*cfg.GetInitAlgo());
+	if (weak) { weak->Reset(); }
+
+	std::uintmax_t zeros = 0; // the skipped bytes
+	bool skip_zeros = m_mgr->IsSkippingZeros();
+	for (BlockRing::Slot* piece = &first; ; )
+	{
+		UpdateSkippingZeros(hasher, weak, piece->is_hole ? nullptr : piece->data, 0,
+		                    piece->size, zeros, skip_zeros);
+		std::size_t const end = piece->offset + piece->size;
+		bool const is_last    = piece->is_last;
+		ring.Release(*piece);
+		if (is_last)
+		{
+			UpdateSkippingZeros(hasher, weak, nullptr, cfg.GetBlockFiller(),
+			                    block_size - end, zeros, skip_zeros);
+			break;
+		}
+		piece = ring.AcquireNext(m_blockNum, end);
+		if (not piece)
+		{
+			if (IsNeedStop()) { return false; }
+			ThrowRuntimeError("%s: the piece at %zu of BLOCK #%zu isn't read",
+				__FUNCTION__, end, m_blockNum);
+		}
+	}
+
+	//NOTE: the rolling sum of zeros is 0 (see AllocateResult)
+	if (skip_zeros)
+	{
+		std::memcpy(result.RefHash().data(), m_mgr->GetZeroDigest(), result.RefHash().size());
+	}
+	else
+	{
+		hasher.Finish(result.RefHash().data());
+		if (weak) { result.SetRollingSum(weak->Digest()); }
+	}
+	PushResult(result);
+	return true;
+}
+
+
+
+// Hashes `count` blocks from m_blockNum which are in `data` and pushes their
+// results. The zero blocks aren't hashed (`data` isn't read when `is_hole`).
+// The blocks are hashed by IHasher::HashBatch unless the rolling sums are
+// computed.
+template <typename Hasher>
+void
+Worker::HashBlocks(Hasher& hasher, uint8_t const* data, std::size_t count, bool is_hole,
+                   algo::Rollsum* weak)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::size_t const block_size = cfg.GetBlockSizeKB() * 1024;
+	bool const skip_zeros        = m_mgr->IsSkippingZeros();
+
+	std::size_t hashed = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		WorkerResult& result = AllocateResult(m_blockNum + i);
+		m_batchResults[i] = &result;
+		uint8_t const* const block = data + i * block_size;
+		//NOTE: the rolling sum of zeros is 0 (see AllocateResult)
+		if (skip_zeros and (is_hole or AreZeroBytes(block, block_size)))
+		{
+			std::memcpy(result.RefHash().data(), m_mgr->GetZeroDigest(), result.RefHash().size());
+			continue;
+		}
+		if (weak)
+		{
+			hasher.Init(*cfg.GetInitAlgo());
+			hasher.Update(block, block_size);
+			hasher.Finish(result.RefHash().data());
+			weak->Reset();
+			weak->Update(block, block_size);
+			result.SetRollingSum(weak->Digest());
+			continue;
+		}
+		m_batchInputs[hashed] = block;
+		m_batchHashes[hashed] = result.RefHash().data();
+		++hashed;
+	}
+	hasher.HashBatch(*cfg.GetInitAlgo(), m_batchInputs.data(), block_size, m_batchHashes.data(), hashed);
+	for (std::size_t i = 0; i < count; ++i) { PushResult(*m_batchResults[i]); }
+}
+
+
+
+// Returns the bytes [from, to) of the file, the bytes before `from` are not
+// kept anymore
+uint8_t const*
+Worker::ReadWindow(std::uintmax_t from, std::uintmax_t to)
+{
+	if (m_in.IsMapped())
+	{
+		uint8_t const* data = nullptr;
+		m_in.SetPosition(from);
+		if (m_in.Read(data, nullptr, to - from) != to - from)
+		{
+			ThrowRuntimeError("%s: unexpected end of the file at %zu (expected %zu)",
+				__FUNCTION__, from, to);
+		}
+		return data;
+	}
+	if (to > m_windowEnd)
+	{
+		std::size_t const kept = m_windowEnd - from;
+		std::memmove(m_readBuffer.data(), m_readBuffer.data() + (from - m_windowBegin), kept);
+		m_windowBegin = from;
+		m_windowEnd   = from + kept + m_in.Read(m_readBuffer.data() + kept, m_readBuffer.size() - kept);
+		if (to > m_windowEnd)
+		{
+			ThrowRuntimeError("%s: unexpected end of the file at %zu (expected %zu)",
+				__FUNCTION__, m_windowEnd, to);
+		}
+	}
+	return m_readBuffer.data() + (from - m_windowBegin);
+}
+
+
+
+// Hashes the block of `result` from the current position of the file. The
+// holes aren't read and the zero blocks aren't hashed: they get the
+// signature of the zero block.
+template <typename Hasher>
+void
+Worker::HashBlock(Hasher& hasher, WorkerResult& result, algo::Rollsum* weak)
+{
+	Config const& cfg = m_mgr->GetConfig();
+	std::uintmax_t const block_size  = cfg.GetBlockSizeKB() * 1024;
+	std::uintmax_t const begin       = result.GetBlockNum() * block_size;
+	bool const skip_zeros            = m_mgr->IsSkippingZeros();
+
+	bool zeros = skip_zeros and m_mgr->IsHole(begin, begin + block_size);
+	if (zeros)
+	{
+		m_in.SkipNextBytes(block_size);
+	}
+	else
+	{
+		hasher.Init(*cfg.GetInitAlgo());
+		if (weak) { weak->Reset(); }
+		zeros = HashNextBytes(hasher, block_size, weak, skip_zeros);
+	}
+
+	//NOTE: the rolling sum of zeros is 0 (see AllocateResult)
+	if (zeros)
+	{
+		std::memcpy(result.RefHash().data(), m_mgr->GetZeroDigest(), result.RefHash().size());
+		return;
+	}
+	hasher.Finish(result.RefHash().data());
+	if (weak) { result.SetRollingSum(weak->Digest()); }
+}
+
+
+
+// Returns true when `skip_zeros` is set and all bytes are zeros: nothing is
+// hashed then. Otherwise the leading zeros are hashed when the first non-zero
+// byte is met.
+template <typename Hasher>
+bool
+Worker::HashNextBytes(Hasher& hasher, std::uintmax_t remains, algo::Rollsum* weak, bool skip_zeros)
+{
+	uint8_t const filler = m_mgr->GetConfig().GetBlockFiller();
+	std::uintmax_t zeros = 0; // the skipped bytes
+
+	std::size_t read_bytes = 0;
+	uint8_t const* data = nullptr;
+	while (remains != 0)
+	{
+		//NOTE: don't read more than `remains` bytes, otherwise the file
+		// position passes the beginning of the next block. The bytes which
+		// are hashed in place (io=mmap, io=direct) aren't limited by the
+		// buffer.
+		std::size_t const to_read = static_cast<std::size_t>(std::min<std::uintmax_t>(
+			std::max(m_readBuffer.size(), m_in.GetMaxView()), remains));
+		read_bytes = m_in.Read(data, m_readBuffer.data(), to_read);
+		if (read_bytes != 0)
+		{
+			UpdateSkippingZeros(hasher, weak, data, 0, read_bytes, zeros, skip_zeros);
+			remains -= read_bytes;
+		}
+		else
+		{
+			UpdateSkippingZeros(hasher, weak, nullptr, filler, remains, zeros, skip_zeros);
+			remains = 0;
+		}
+	}
+	return skip_zeros;
+}
+
+
+
+WorkerResult&
+Worker::AllocateResult(std::uint64_t block_num)
+{
+	auto sp_results = m_results.lock();
+	if (not sp_results)
+	{
+		ThrowRuntimeError("%s: can't allocate result object. Abort execution.",
+			__FUNCTION__);
+	}
+	WorkerResult& result = sp_results->allocate();
+	result.RefHash().resize(m_hasher->ResultSize()); //TODO: resize each time?
+	result.SetBlockNum(block_num);
+	result.SetPartNum(0);
+	result.SetChunk(0, 0);
+	result.SetRollingSum(0);
+	return result;
+}
+
+
+
+void
+Worker::PushResult(WorkerResult& result)
+{
+	if (not m_producer.push(result))
+	{
+		ThrowRuntimeError("%s: can't save the result. Abort execution.",
+			__FUNCTION__);
+	}
+}
+
+
+
 void
 Worker::ThrowError() const
 {
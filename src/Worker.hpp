@@ -12,6 +12,9 @@
 #include "common/MpocQueueItem.hpp"
 #include "common/MpocQueueProducer.hpp"
 #include "algo/IHasher.hpp"
+#include "algo/IMultiHasher.hpp"
+#include "algo/Rollsum.hpp"
+#include "BlockRing.hpp"
 
 
 
@@ -26,16 +29,36 @@ public:
 	using hash_t = std::vector<uint8_t>;
 
 	std::uint64_t GetBlockNum() const noexcept { return m_blockNum; }
+	std::uint64_t GetPartNum() const noexcept  { return m_partNum; }
 	hash_t const& GetHash() const noexcept     { return m_hash; }
+	// NOTE: chunking=cdc: GetBlockNum() is the segment and the chunk is
+	//       [offset, offset + length). A result without the length and the
+	//       hash is the seam: the offset where the chunking of the segment
+	//       has met the one of the next segment.
+	std::uint64_t GetOffset() const noexcept   { return m_offset; }
+	std::uint64_t GetLength() const noexcept   { return m_length; }
+	bool IsSeam() const noexcept               { return m_length == 0; }
+	uint32_t GetRollingSum() const noexcept    { return m_rollingSum; } // see Config::IsRollingSum
 
 private:
 	friend class Worker;
 
 	void SetBlockNum(std::uint64_t v) noexcept { m_blockNum = v; }
+	void SetPartNum(std::uint64_t v) noexcept  { m_partNum = v; }
+	void SetRollingSum(uint32_t v) noexcept    { m_rollingSum = v; }
+	void SetChunk(std::uint64_t offset, std::uint64_t length) noexcept
+	{
+		m_offset = offset;
+		m_length = length;
+	}
 	hash_t& RefHash() noexcept                 { return m_hash; }
 
 private:
 	std::uint64_t    m_blockNum = 0;
+	std::uint64_t    m_partNum  = 0; // see Config::GetBlockParts
+	std::uint64_t    m_offset   = 0; // see Config::GetChunking
+	std::uint64_t    m_length   = 0;
+	uint32_t         m_rollingSum = 0;
 	hash_t           m_hash;
 
 	mutable WorkerResult const* m_next = nullptr;
@@ -47,13 +70,22 @@ class Worker
 {
 public:
 	using wp_pool_t = std::weak_ptr<Pool<WorkerResult>>;
-	using hasher_t  = std::unique_ptr<algo::IHasher>;
-	using readbuf_t = std::vector<uint8_t>;
+	using hasher_t       = std::unique_ptr<algo::IHasher>;
+	using multi_hasher_t = std::unique_ptr<algo::IMultiHasher>;
+	using readbuf_t      = std::vector<uint8_t>;
+
+	enum class role_e : uint8_t
+	{
+		HASHER, // reads and hashes its blocks (the slots of BlockRing)
+		READER, // reads the file to BlockRing (see Config::IsPipeline)
+	};
 
 	Worker(Worker const&)             = delete;
 	Worker& operator= (Worker const&) = delete;
 
-	Worker(WorkerManager& mgr, std::uint64_t block_num);
+	//NOTE: when blocks are split on parts `block_num` is the number of the
+	// first part: (block_num * parts + part_num).
+	Worker(WorkerManager& mgr, std::uint64_t block_num, role_e role = role_e::HASHER);
 	Worker(Worker&&)             = default;
 	Worker& operator= (Worker&&) = default;
 	~Worker()                    = default;
@@ -71,6 +103,25 @@ public:
 private:
 	void Run() noexcept;
 	void DoWork();
+	void DoWorkLanes();
+	void DoWorkReader();
+	// These loops are instantiated per concrete hasher (see algo::DispatchHasher)
+	template <typename Hasher> void DoWorkBlocks(Hasher&);
+	template <typename Hasher> void DoWorkParts(Hasher&);
+	template <typename Hasher> void DoWorkBatch(Hasher&);
+	template <typename Hasher> void DoWorkChunks(Hasher&);
+	template <typename Hasher> void DoWorkDirtyBlocks(Hasher&);
+	template <typename Hasher> void DoWorkRing(Hasher&);
+	template <typename Hasher> void HashBlocks(Hasher&, uint8_t const* data, std::size_t count,
+	                                           bool is_hole, algo::Rollsum*);
+	template <typename Hasher> bool HashPieces(Hasher&, BlockRing&, BlockRing::Slot& first,
+	                                           algo::Rollsum*);
+	template <typename Hasher> void HashBlock(Hasher&, WorkerResult&, algo::Rollsum*);
+	template <typename Hasher> bool HashNextBytes(Hasher&, std::uintmax_t num,
+	                                              algo::Rollsum* = nullptr, bool skip_zeros = false);
+	uint8_t const* ReadWindow(std::uintmax_t from, std::uintmax_t to);
+	WorkerResult& AllocateResult(std::uint64_t block_num);
+	void PushResult(WorkerResult&);
 	void ThrowRuntimeError(char const* format, ...) const;
 
 private:
@@ -78,15 +129,24 @@ private:
 
 	WorkerManager*       m_mgr;
 	hasher_t             m_hasher;
+	multi_hasher_t       m_multiHasher; // is set when Config::GetBlockLanes() > 1
 	future_t             m_future;
 	FileReader           m_in;
+	std::vector<FileReader> m_lanesIn;  // a reader per lane except the first (m_in)
 
 	wp_pool_t            m_results;
 	MpocQueueProducer    m_producer;
 	readbuf_t            m_readBuffer;
+	readbuf_t            m_lanesResult;
+	std::vector<uint8_t const*> m_batchInputs;  // see HashBlocks
+	std::vector<uint8_t*>       m_batchHashes;
+	std::vector<WorkerResult*>  m_batchResults;
+	std::uintmax_t       m_windowBegin = 0; // the file offsets of m_readBuffer
+	std::uintmax_t       m_windowEnd   = 0; // (chunking=cdc)
 
 	std::exception_ptr   m_exceptPtr;
 	std::uint64_t        m_blockNum;
+	role_e               m_role;
 	bool                 m_isNeedStop = false;
 	bool                 m_isRunning = false;
 };
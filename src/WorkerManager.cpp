@@ -4,8 +4,14 @@
 #include <chrono>
 #include <algorithm>
 #include <istream>
+#include <numeric>
+#include <charconv>
+#include <string_view>
+
+#include <cstring>
 
 #include "common/Logger.hpp"
+#include "algo/IMultiHasher.hpp"
 
 
 
@@ -20,32 +26,330 @@ WorkerManager::WorkerManager(Config& config)
 	{
 		++blocks_count;
 	}
+	//NOTE: the blocks of a stream are counted by the reader (see
+	// Worker::DoWorkReader), the Workers are prepared for an endless file
+	if (m_cfg.IsStreamInput())
+	{
+		blocks_count = UINT64_MAX / block_size;
+	}
+
+	//NOTE: `0 == threads_num` is the paranoia case because Config class
+	// will check the value of the `threads_num`.
+	//NOTE: -1 because the main thread does not calculate hash
+	size_t const threads_num = m_cfg.GetThreadsNum();
+	uint64_t const max_workers = (threads_num > 1) ? threads_num - 1 : 1;
 
-	auto const worker_num = [&blocks_count](size_t const threads_num) -> uint64_t
+	if (m_cfg.GetChunking() == Config::chunking_e::CDC)
 	{
-		//NOTE: `0 == threads_num` is the paranoia case because Config class
-		// will check the value of the `threads_num`.
-		if (1 == threads_num || 0 == threads_num) { return 1; }
-		//NOTE: -1 because the main thread does not calculate hash
-		return std::min(threads_num - 1, blocks_count);
-	}(m_cfg.GetThreadsNum());
+		blocks_count = SplitOnChunkSegments(max_workers);
+	}
+	if (m_cfg.IsIncremental())
+	{
+		LoadDirtyBlocks(blocks_count);
+	}
+	if (m_cfg.GetChunking() == Config::chunking_e::FIXED and m_cfg.GetBlockFiller() == 0)
+	{
+		PrepareZeroBlocks();
+	}
 
-	m_workers.reserve(worker_num);
-	for (uint64_t block_num = 0; block_num < worker_num; ++block_num)
+	// The small blocks are read and hashed by batches. Otherwise multi-buffer
+	// hashing is used only when there are enough blocks to fill all lanes of
+	// all Workers, else a block per Worker is faster.
+	//NOTE: the rolling sums and the dirty blocks are computed by the
+	// block-by-block loops only. The pipeline hashes a slot of BlockRing by a
+	// batch: the lanes and the parts aren't used.
+	bool const one_by_one = m_cfg.GetChunking() == Config::chunking_e::CDC
+		or m_cfg.IsRollingSum() or m_cfg.IsIncremental();
+	uint64_t const batch = one_by_one ? 1 : SelectBlockBatch(blocks_count, max_workers);
+	uint64_t lanes = 1;
+	if (batch == 1 and not one_by_one and not m_cfg.IsPipeline())
+	{
+		if (auto multi = algo::HasherFactory::CreateMulti(*m_cfg.GetInitAlgo()))
+		{
+			if (blocks_count >= max_workers * multi->Lanes())
+			{
+				lanes = multi->Lanes();
+			}
+		}
+	}
+	m_cfg.SetBlockBatch(batch);
+	m_cfg.SetBlockLanes(lanes);
+	if (lanes == 1 and batch == 1 and not one_by_one and not m_cfg.IsPipeline())
 	{
-		m_workers.emplace_back(*this, block_num);
+		SplitBlocksIfNeeded(blocks_count, max_workers);
 	}
-	LOG_I("%s: create %zu Workers and will be processed %zu blocks",
-	      __FUNCTION__, m_workers.size(), blocks_count);
 
+	// NOTE: a Worker processes either `group` blocks (`lanes` or `batch`)
+	//       or a part of a block at once
+	uint64_t const group = lanes * batch;
+	uint64_t const units_count = m_cfg.IsIncremental()
+		? m_dirtyBlocks.size()
+		: blocks_count * m_cfg.GetBlockParts();
+	uint64_t const worker_num = std::min(max_workers, (units_count + group - 1) / group);
+
+	//NOTE: the shifts are set before the Workers are created: their readers
+	// are sized by the Workers count (see Worker::Worker)
 	// -1 because block counter start from 0
 	m_cfg.SetLastBlockNum(blocks_count - 1);
-	m_cfg.SetBlocksShift(m_workers.size());
+	m_cfg.SetBlocksShift(worker_num * group);
+
+	// -batch because `batch` blocks have read this thread (by each lane) and
+	// next blocks should skip
+	m_cfg.SetFileBytesShift(block_size * (worker_num * group - batch));
+
+	if (m_cfg.IsPipeline() and worker_num != 0)
+	{
+		// The reader is a Worker too: it takes a thread of the hashing ones
+		// (if there are two at least). A slot per hashing Worker is being
+		// filled while the others are hashed.
+		uint64_t const hashers = (worker_num > 1) ? worker_num - 1 : 1;
+		//NOTE: a larger block is read by pieces, a piece isn't larger than
+		// the file
+		uint64_t slot_size = batch * block_size;
+		if (slot_size > BlockRing::MAX_SLOT_SIZE)
+		{
+			uint64_t const file_size = m_cfg.IsStreamInput()
+				? BlockRing::MAX_SLOT_SIZE
+				: std::max<uint64_t>(m_cfg.GetInputFileSize(), 1);
+			slot_size = std::min<uint64_t>(BlockRing::MAX_SLOT_SIZE, file_size);
+		}
+		m_ring = std::make_unique<BlockRing>(2 * hashers, slot_size);
+		m_workers.reserve(hashers + 1);
+		for (uint64_t wrk = 0; wrk < hashers; ++wrk)
+		{
+			m_workers.emplace_back(*this, wrk * group);
+		}
+		m_workers.emplace_back(*this, 0, Worker::role_e::READER);
+	}
+	else
+	{
+		m_workers.reserve(worker_num);
+		for (uint64_t wrk = 0; wrk < worker_num; ++wrk)
+		{
+			m_workers.emplace_back(*this, wrk * group);
+		}
+	}
+	LOG_I("%s: create %zu Workers (%zu lanes, %zu blocks per batch, %zu parts "
+	      "per block) and will be processed %zu blocks",
+	      __FUNCTION__, m_workers.size(), lanes, batch, m_cfg.GetBlockParts(),
+	      blocks_count);
+
+	if (not m_cfg.GetMerkleFile().empty())
+	{
+		m_merkle = std::make_unique<MerkleTree>(*m_cfg.GetInitAlgo(), blocks_count);
+	}
+	if (m_cfg.IsDedup())
+	{
+		uint64_t expected_count = (m_cfg.GetChunking() == Config::chunking_e::CDC)
+			? m_cfg.GetInputFileSize() / m_cfg.GetChunkAvg()
+			: blocks_count;
+		if (m_cfg.IsStreamInput()) { expected_count = 0; }
+		m_dedup = std::make_unique<DedupTable>(expected_count, not m_cfg.GetDedupMap().empty(),
+			m_cfg.GetDedupMaxMemory());
+	}
+
+	//NOTE: a log message is cut at LoggerMessage::MSG_MAX_SIZE, so the
+	// configuration is logged by lines
+	LOG_I("%s: final configuration:", __FUNCTION__);
+	for (std::string_view dump = m_cfg.toString(); not dump.empty(); )
+	{
+		std::size_t const eol = std::min(dump.find('\n'), dump.size());
+		std::string_view const line = dump.substr(0, eol);
+		LOG_I("%.*s", LOG_SV(line));
+		dump.remove_prefix(std::min(eol + 1, dump.size()));
+	}
+}
+
+
+
+uint64_t
+WorkerManager::SelectBlockBatch(uint64_t blocks_count, uint64_t max_workers) const
+{
+	// A batch is read by one call and hashed by IHasher::HashBatch, so the
+	// small blocks don't pay the per-block overhead. Each Worker gets a batch
+	// at least, and the batch is a multiple of the multi-buffer lanes (the
+	// rest of the blocks would be hashed one by one).
+	uint64_t const block_size = m_cfg.GetBlockSizeKB() * 1024;
+	if (block_size > MAX_BATCH_BLOCK_SIZE or max_workers == 0) { return 1; }
+
+	uint64_t batch = std::min({MAX_BATCH_SIZE / block_size, MAX_BATCH_BLOCKS,
+	                           blocks_count / max_workers});
+	if (auto multi = algo::HasherFactory::CreateMulti(*m_cfg.GetInitAlgo()))
+	{
+		if (batch >= multi->Lanes()) { batch -= batch % multi->Lanes(); }
+	}
+	return (batch > 1) ? batch : 1;
+}
+
+
+
+void
+WorkerManager::SplitBlocksIfNeeded(uint64_t blocks_count, uint64_t max_workers)
+{
+	// Blocks are split on parts when some Workers would stay idle while the
+	// last blocks are hashed. The parts are distributed between the Workers
+	// evenly: blocks_count * parts is a multiple of max_workers (if the
+	// hasher doesn't need the other part size, see IHasher::AlignPartSize).
+	m_combiner = algo::HasherFactory::Create(*m_cfg.GetInitAlgo());
+	if (not m_combiner->IsSplittable() or blocks_count == 0) { return; }
+
+	uint64_t const block_size = m_cfg.GetBlockSizeKB() * 1024;
+	uint64_t const max_parts  = block_size / MIN_BLOCK_PART_SIZE;
+	uint64_t const parts      = std::min(max_workers / std::gcd(blocks_count, max_workers), max_parts);
+	if (parts < 2) { return; }
+
+	uint64_t part_size = (block_size + parts - 1) / parts;
+	part_size = (part_size + BLOCK_PART_ALIGN - 1) / BLOCK_PART_ALIGN * BLOCK_PART_ALIGN;
+	part_size = m_combiner->AlignPartSize(part_size);
+	if (part_size == 0 or part_size >= block_size) { return; }
+
+	m_cfg.SetBlockParts((block_size + part_size - 1) / part_size, part_size);
+	LOG_I("%s: each block is split on %zu parts of %zu bytes",
+	      __FUNCTION__, m_cfg.GetBlockParts(), part_size);
+}
+
+
+
+uint64_t
+WorkerManager::SplitOnChunkSegments(uint64_t max_workers)
+{
+	// The segments are chunked in parallel, each one costs the rechunking of
+	// a few chunks at its end (see Worker::DoWorkChunks), so a segment is
+	// MIN_CHUNKS_PER_SEGMENT max chunks at least. The segments are striped
+	// over the Workers like the blocks.
+	uint64_t const file_size = m_cfg.GetInputFileSize();
+	uint64_t const min_size  = MIN_CHUNKS_PER_SEGMENT * m_cfg.GetChunkMax();
+	uint64_t const even_size = (file_size + max_workers - 1) / max_workers;
+	uint64_t const segment_size = std::max(min_size, std::min(even_size, MAX_CHUNK_SEGMENT_SIZE));
+	uint64_t const segments = (file_size + segment_size - 1) / segment_size;
+	m_cfg.SetChunkSegmentSize(segment_size);
+
+	m_chunkSegments.resize(segments);
+	if (segments != 0)
+	{
+		m_chunkSegments.front().seam = 0;
+		m_chunkSegments.front().sync = 0;
+		m_syncedSegments = 1;
+	}
+	LOG_I("%s: the file is split on %zu segments of %zu bytes for the chunking",
+	      __FUNCTION__, segments, segment_size);
+	return segments;
+}
+
+
+
+void
+WorkerManager::LoadDirtyBlocks(uint64_t blocks_count)
+{
+	// The last blocks of the base and of the file and the blocks between are
+	// always dirty: the size of the file could be changed, so the filler of
+	// the last block could be replaced by the data and vice versa
+	m_base = std::make_unique<SignatureFile>(m_cfg.GetBaseSignature().c_str(),
+	                                         SignatureFile::RecordSize(m_cfg));
+	uint64_t const block_size = m_cfg.GetBlockSizeKB() * 1024;
+	uint64_t const base_count = m_base->GetCount();
+	std::vector<bool> dirty(blocks_count, false);
+	uint64_t const common_count = std::min(base_count, blocks_count);
+	for (uint64_t b = (common_count > 0) ? common_count - 1 : 0; b < blocks_count; ++b)
+	{
+		dirty[b] = true;
+	}
+
+	// A line is `OFFSET LENGTH` (bytes), the empty lines and the lines
+	// starting with '#' are skipped
+	std::string text;
+	{
+		FileReader in(m_cfg.GetDirtyRanges().c_str());
+		char buffer[4096];
+		while (std::size_t const read_bytes = in.Read(buffer, sizeof(buffer)))
+		{
+			text.append(buffer, read_bytes);
+		}
+	}
+	uint64_t ranges = 0;
+	std::size_t line_num = 0;
+	for (std::size_t pos = 0; pos < text.size(); )
+	{
+		std::size_t const eol = std::min(text.find('\n', pos), text.size());
+		char const* cur = text.data() + pos;
+		char const* const end = text.data() + eol;
+		pos = eol + 1;
+		++line_num;
+
+		auto const skip_spaces = [&cur, end]()
+		{
+			while (cur != end and (*cur == ' ' or *cur == '\t' or *cur == '\r')) { ++cur; }
+		};
+		skip_spaces();
+		if (cur == end or *cur == '#') { continue; }
+
+		uint64_t range[2] = {};
+		for (uint64_t& v : range)
+		{
+			skip_spaces();
+			auto const res = std::from_chars(cur, end, v);
+			if (res.ec != std::errc())
+			{
+				THROW_ERROR("%s: can't parse the line %zu of [%s], expected `OFFSET LENGTH`",
+					__FUNCTION__, line_num, m_cfg.GetDirtyRanges().c_str());
+			}
+			cur = res.ptr;
+		}
+		skip_spaces();
+		if (cur != end)
+		{
+			THROW_ERROR("%s: unexpected characters at the line %zu of [%s]",
+				__FUNCTION__, line_num, m_cfg.GetDirtyRanges().c_str());
+		}
+
+		auto const [offset, length] = range;
+		++ranges;
+		if (length == 0) { continue; }
+		uint64_t const first = offset / block_size;
+		uint64_t const last  = std::min((offset + (length - 1)) / block_size + 1, blocks_count);
+		for (uint64_t b = first; b < last; ++b) { dirty[b] = true; }
+	}
+
+	for (uint64_t b = 0; b < blocks_count; ++b)
+	{
+		if (dirty[b]) { m_dirtyBlocks.push_back(b); }
+	}
+	LOG_I("%s: %zu dirty ranges, %zu of %zu blocks will be hashed (the base has %zu blocks)",
+	      __FUNCTION__, ranges, m_dirtyBlocks.size(), blocks_count, base_count);
+}
+
 
-	// -1 because one block has read this thread and next blocks should skip
-	m_cfg.SetFileBytesShift(block_size * (m_workers.size() - 1));
 
-	LOG_I("%s: final configuration:\n%s", __FUNCTION__, m_cfg.toString());
+void
+WorkerManager::PrepareZeroBlocks()
+{
+	// The zero blocks have the same signature (see GetZeroDigest). The last
+	// block is padded by zeros too, so it is the same for a zero tail.
+	m_isSkippingZeros = true;
+	if (m_cfg.IsStreamInput()) { return; }
+
+	m_sparse = std::make_unique<SparseMap>(m_cfg.GetInputFile().c_str(), m_cfg.GetInputFileSize());
+	LOG_I("%s: %zu of %zu bytes of the input file are data (the rest are holes)",
+	      __FUNCTION__, m_sparse->GetDataSize(), m_cfg.GetInputFileSize());
+}
+
+
+
+//NOTE: hashing a large block of zeros takes seconds, so it is done only when
+// a hole or a zero block is met
+uint8_t const*
+WorkerManager::GetZeroDigest()
+{
+	std::call_once(m_zeroDigestOnce, [this]
+	{
+		uint64_t const block_size = m_cfg.GetBlockSizeKB() * 1024;
+		auto hasher = algo::HasherFactory::Create(*m_cfg.GetInitAlgo());
+		m_zeroDigest.resize(hasher->ResultSize());
+		hasher->Init(*m_cfg.GetInitAlgo());
+		hasher->UpdateFill(0, block_size);
+		hasher->Finish(m_zeroDigest.data());
+	});
+	return m_zeroDigest.data();
 }
 
 
@@ -94,7 +398,17 @@ WorkerManager::DoWork() noexcept
 		//Responcibility: save the workers' results
 		if (WorkerResult* res = m_results->pop_as<WorkerResult>())
 		{
-			SaveResult(*res);
+			//NOTE: e.g. the dedup map doesn't fit into its memory
+			try { SaveResult(*res); }
+			catch (std::exception const& ex)
+			{
+				if (not was_error)
+				{
+					LOG_E("%s: can't save the result: %s", __FUNCTION__, ex.what());
+					was_error = true;
+					StartAborting();
+				}
+			}
 			res->Release();
 		}
 
@@ -133,10 +447,29 @@ WorkerManager::DoWork() noexcept
 
 	if(was_error)
 	{
-		LOG_E("%s: there was initial error: "
-			"the Worker with BLOCK #%zu failed: %s",
-			__FUNCTION__,
-			failed_worker_block_num, failed_worker_err_msg.c_str());
+		if (not failed_worker_err_msg.empty())
+		{
+			LOG_E("%s: there was initial error: "
+				"the Worker with BLOCK #%zu failed: %s",
+				__FUNCTION__,
+				failed_worker_block_num, failed_worker_err_msg.c_str());
+		}
+	}
+	else if (m_merkle or m_base or m_dedup or m_cfg.GetChunking() == Config::chunking_e::CDC)
+	{
+		try
+		{
+			HandleUnprocessed();
+			if (m_cfg.GetChunking() == Config::chunking_e::CDC) { CheckChunkSegments(); }
+			if (m_base) { CopyCleanRecords(); }
+			if (m_merkle) { SaveMerkleTree(); }
+			if (m_dedup) { SaveDedup(); }
+		}
+		catch (std::exception const& ex)
+		{
+			LOG_E("%s: can't finish the signature: %s", __FUNCTION__, ex.what());
+			was_error = true;
+		}
 	}
 	return not was_error;
 }
@@ -145,10 +478,235 @@ WorkerManager::DoWork() noexcept
 void
 WorkerManager::SaveResult(WorkerResult const& res)
 {
-	auto const  bnum = res.GetBlockNum();
+	if (m_cfg.GetChunking() == Config::chunking_e::CDC) { return SaveChunkResult(res); }
+	if (m_cfg.GetBlockParts() > 1) { return SavePartResult(res); }
+
+	auto const& hash = res.GetHash();
+	WriteRecord(res.GetBlockNum(), res.GetRollingSum(), hash.data(), hash.size());
+}
+
+
+
+void
+WorkerManager::SavePartResult(WorkerResult const& res)
+{
+	uint64_t const parts      = m_cfg.GetBlockParts();
+	uint64_t const part_size  = m_cfg.GetBlockPartSize();
+	uint64_t const block_size = m_cfg.GetBlockSizeKB() * 1024;
+	auto const&    part_hash  = res.GetHash();
+
+	PartialBlock& block = m_partialBlocks[res.GetBlockNum()];
+	block.parts_result.resize(parts * part_hash.size());
+	std::copy(part_hash.begin(), part_hash.end(),
+	          block.parts_result.begin() + res.GetPartNum() * part_hash.size());
+	if (++block.received < parts) { return; }
+
+	std::vector<uint8_t> hash(m_combiner->ResultSize());
+	int const err = m_combiner->CombineParts(
+		block.parts_result.data(), parts,
+		part_size, block_size - (parts - 1) * part_size,
+		hash.data());
+	if (err != 0)
+	{
+		THROW_ERROR("%s: can't combine parts of the BLOCK #%zu",
+			__FUNCTION__, res.GetBlockNum());
+	}
+	WriteRecord(res.GetBlockNum(), 0, hash.data(), hash.size());
+	m_partialBlocks.erase(res.GetBlockNum());
+}
+
+
+
+void
+WorkerManager::SaveChunkResult(WorkerResult const& res)
+{
+	// The chunks of a segment are valid from its `sync` offset, which is
+	// known when the seams of all previous segments are received:
+	//   sync[0] = 0, sync[i] = max(sync[i - 1], seam[i]).
+	// If the previous chunking passes the seam[i] (the segment i - 1 got in
+	// sync with its own previous one after seam[i]) it has met the chunking
+	// of the segment i anyway: the chunkings are the same after a common
+	// boundary.
+	uint64_t const segment = res.GetBlockNum();
+	if (res.IsSeam())
+	{
+		m_chunkSegments.at(segment + 1).seam = res.GetOffset();
+		for (; m_syncedSegments < m_chunkSegments.size(); ++m_syncedSegments)
+		{
+			ChunkSegment& cur = m_chunkSegments[m_syncedSegments];
+			if (cur.seam == ChunkSegment::UNKNOWN) { break; }
+
+			cur.sync = std::max(m_chunkSegments[m_syncedSegments - 1].sync, cur.seam);
+			for (ChunkSegment::Chunk const& chunk : cur.pending)
+			{
+				if (chunk.offset < cur.sync) { continue; }
+				WriteChunkRecord(chunk.offset, chunk.length, chunk.hash.data(), chunk.hash.size());
+			}
+			std::vector<ChunkSegment::Chunk>().swap(cur.pending);
+		}
+		return;
+	}
+
 	auto const& hash = res.GetHash();
+	ChunkSegment& seg = m_chunkSegments.at(segment);
+	if (segment >= m_syncedSegments)
+	{
+		seg.pending.push_back({res.GetOffset(), res.GetLength(), hash});
+	}
+	else if (res.GetOffset() >= seg.sync)
+	{
+		WriteChunkRecord(res.GetOffset(), res.GetLength(), hash.data(), hash.size());
+	}
+}
+
+
+
+void
+WorkerManager::CheckChunkSegments() const
+{
+	if (m_syncedSegments != m_chunkSegments.size())
+	{
+		THROW_ERROR("%s: the seam of the SEGMENT #%zu wasn't received",
+			__FUNCTION__, m_syncedSegments);
+	}
+	LOG_I("%s: %zu chunks in %zu segments", __FUNCTION__,
+	      m_chunksCount, m_chunkSegments.size());
+}
+
+
+
+void
+WorkerManager::WriteChunkRecord(uint64_t offset, uint64_t length, uint8_t const* hash, size_t hash_size)
+{
+	m_out.Write(&offset, sizeof(offset), 1);
+	m_out.Write(&length, sizeof(length), 1);
+	m_out.Write(hash, hash_size);
+	if (m_dedup) { m_dedup->Add(offset, hash, hash_size, length); }
+	++m_chunksCount;
+}
+
+
+
+void
+WorkerManager::WriteRecord(uint64_t bnum, uint32_t rolling_sum, uint8_t const* hash, size_t hash_size)
+{
 	m_out.Write(&bnum, sizeof(bnum), 1);
-	m_out.Write(hash.data(), hash.size());
+	if (m_cfg.IsRollingSum()) { m_out.Write(&rolling_sum, sizeof(rolling_sum), 1); }
+	m_out.Write(hash, hash_size);
+	//NOTE: the blocks come out of order, the tree is built as they come
+	if (m_merkle) { m_merkle->AddLeaf(bnum, hash, hash_size); }
+	if (m_dedup)
+	{
+		uint64_t const block_size = m_cfg.GetBlockSizeKB() * 1024;
+		m_dedup->Add(bnum, hash, hash_size,
+			std::min(block_size, GetInputSize() - bnum * block_size));
+	}
+}
+
+
+
+void
+WorkerManager::CopyCleanRecords()
+{
+	//NOTE: LastBlockNum + 1 is 0 for an empty file
+	uint64_t const blocks_count = m_cfg.GetLastBlockNum() + 1;
+	uint64_t first = 0;
+	for (uint64_t dirty : m_dirtyBlocks)
+	{
+		CopyBaseRecords(first, dirty);
+		first = dirty + 1;
+	}
+	CopyBaseRecords(first, blocks_count);
+	LOG_I("%s: %zu records were copied from [%s]", __FUNCTION__,
+	      blocks_count - m_dirtyBlocks.size(), m_base->GetName());
+}
+
+
+
+// Copies the records of the blocks [first, last)
+void
+WorkerManager::CopyBaseRecords(uint64_t first, uint64_t last)
+{
+	if (first >= last) { return; }
+	std::size_t const record_size = m_base->GetRecordSize();
+	if (m_base->IsOrdered() and not m_merkle and not m_dedup)
+	{
+		// the records are the same: block number, rolling sum, signature
+		m_out.Write(m_base->GetRecord(first), (last - first) * record_size);
+		return;
+	}
+
+	std::size_t const hash_offset = sizeof(uint64_t) + (m_cfg.IsRollingSum() ? sizeof(uint32_t) : 0);
+	for (uint64_t block = first; block < last; ++block)
+	{
+		uint8_t const* const record = m_base->GetRecord(block);
+		uint32_t rolling_sum = 0;
+		if (m_cfg.IsRollingSum()) { std::memcpy(&rolling_sum, record + sizeof(uint64_t), sizeof(rolling_sum)); }
+		WriteRecord(block, rolling_sum, record + hash_offset, record_size - hash_offset);
+	}
+}
+
+
+
+void
+WorkerManager::SaveMerkleTree()
+{
+	if (not m_merkle->IsComplete())
+	{
+		THROW_ERROR("%s: not all blocks were signed", __FUNCTION__);
+	}
+
+	FileWriter out(m_cfg.GetMerkleFile(), FileWriter::file_type_e::BINARY);
+	m_merkle->Save(out);
+
+	constexpr char const* HEX = "0123456789abcdef";
+	uint8_t const* root = m_merkle->GetRoot();
+	std::string root_hex;
+	for (std::size_t i = 0; i < m_merkle->GetDigestSize(); ++i)
+	{
+		root_hex.push_back(HEX[root[i] >> 4]);
+		root_hex.push_back(HEX[root[i] & 0xF]);
+	}
+	LOG_I("%s: the Merkle root of %zu blocks is %s (saved to '%s')",
+	      __FUNCTION__, m_merkle->GetLeavesCount(), root_hex.c_str(),
+	      m_cfg.GetMerkleFile().c_str());
+}
+
+
+
+void
+WorkerManager::SaveDedup()
+{
+	if (not m_cfg.GetDedupMap().empty())
+	{
+		FileWriter out(m_cfg.GetDedupMap(), FileWriter::file_type_e::BINARY);
+		m_dedup->SaveMap(out);
+	}
+
+	//NOTE: the report is the result of the run, so it is printed regardless
+	// of the log level
+	uint64_t const count      = m_dedup->GetCount();
+	uint64_t const duplicates = count - m_dedup->GetUniqueCount();
+	uint64_t const bytes      = m_dedup->GetBytes();
+	auto const percent = [](uint64_t part, uint64_t total)
+	{
+		return (total == 0) ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(total);
+	};
+	char approximate[128] = "";
+	if (m_dedup->IsApproximate())
+	{
+		std::snprintf(approximate, sizeof(approximate),
+			" (approximate: dedup_max_memory is exceeded, the standard error of the unique count is %.2f%%)",
+			100 * DedupTable::APPROXIMATE_ERROR);
+	}
+	char report[384];
+	int const len = std::snprintf(report, sizeof(report),
+		"dedup: %ju %s, %ju duplicates (%.2f%%), %ju of %ju bytes are duplicate (%.2f%%)%s\n",
+		count, (m_cfg.GetChunking() == Config::chunking_e::CDC) ? "chunks" : "blocks",
+		duplicates, percent(duplicates, count),
+		m_dedup->GetDuplicateBytes(), bytes, percent(m_dedup->GetDuplicateBytes(), bytes),
+		approximate);
+	FileWriter("stdout", FileWriter::file_type_e::TEXT).Write(report, static_cast<size_t>(len));
 }
 
 
@@ -158,6 +716,7 @@ WorkerManager::StartAborting() noexcept
 {
 	m_isAborting = true;
 	LOG_D("%s: start aborting", __FUNCTION__);
+	if (m_ring) { m_ring->Close(); }
 	for (Worker& w : m_workers)
 	{
 		if (w.IsRunning()) { w.SetStop(); }
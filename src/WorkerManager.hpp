@@ -1,10 +1,20 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "common/MpocQueue.hpp"
 #include "common/MpocQueueProducer.hpp"
 #include "common/FileWriter.hpp"
 #include "common/PoolStorage.hpp"
+#include "common/SparseMap.hpp"
+#include "BlockRing.hpp"
 #include "Config.hpp"
+#include "DedupTable.hpp"
+#include "MerkleTree.hpp"
+#include "SignatureFile.hpp"
 #include "Worker.hpp"
 
 
@@ -18,6 +28,13 @@ public:
 	static constexpr size_t   INIT_RESULTS_SIZE          = 64;
 	static constexpr size_t   INC_RESULTS_POOL           = 32;
 	static constexpr uint32_t DEFAULT_QUEUE_POLLING_MS   = 1000;
+	static constexpr uint64_t MIN_BLOCK_PART_SIZE        = 1024 * 1024;
+	static constexpr uint64_t BLOCK_PART_ALIGN           = 4096;
+	static constexpr uint64_t MAX_BATCH_BLOCK_SIZE       = 64 * 1024;
+	static constexpr uint64_t MAX_BATCH_SIZE             = 1024 * 1024;
+	static constexpr uint64_t MAX_BATCH_BLOCKS           = 256;
+	static constexpr uint64_t MAX_CHUNK_SEGMENT_SIZE     = 64 * 1024 * 1024;
+	static constexpr uint64_t MIN_CHUNKS_PER_SEGMENT     = 16; // of the max size
 
 	WorkerManager(WorkerManager&&)                 = delete;
 	WorkerManager(WorkerManager const&)            = delete;
@@ -34,6 +51,23 @@ public:
 	bool IsAborting() const noexcept               { return m_isAborting; }
 	void StartAborting() noexcept;
 	Config const& GetConfig() const noexcept       { return m_cfg; }
+	// The blocks to hash (ascending) when Config::IsIncremental
+	std::vector<uint64_t> const& GetDirtyBlocks() const noexcept { return m_dirtyBlocks; }
+	// The holes and the zero blocks aren't hashed (chunking=fixed and the
+	// filler is zero): they get the signature of the block of zeros
+	bool IsSkippingZeros() const noexcept          { return m_isSkippingZeros; }
+	// The signature of the block of zeros: it is computed by the first call
+	uint8_t const* GetZeroDigest();
+	// The bytes [begin, end) of the input file are a hole (see SparseMap)
+	bool IsHole(uint64_t begin, uint64_t end) const noexcept
+	{
+		return m_sparse and m_sparse->IsHole(begin, end);
+	}
+	// The ring between the reader and the hashing Workers or nullptr (see
+	// Config::IsPipeline)
+	BlockRing* GetRing() const noexcept            { return m_ring.get(); }
+	// The reader sets the size of a stream at its end (see Config::IsStreamInput)
+	void SetStreamSize(uint64_t v) noexcept        { m_streamSize.store(v); }
 
 	MpocQueueProducer NewResultProducer() noexcept { return m_results->NewProducer(); }
 	result_pool_t NewResultPool() noexcept
@@ -43,9 +77,57 @@ public:
 	void HandleUnprocessed() noexcept;
 
 private:
+	uint64_t GetInputSize() const noexcept
+	{
+		return m_cfg.IsStreamInput() ? m_streamSize.load() : m_cfg.GetInputFileSize();
+	}
 	Worker* FindFailedWorker() noexcept;
 	bool AreAllWorkersStop() const noexcept;
 	void StopAllWorkers() noexcept;
+	uint64_t SelectBlockBatch(uint64_t blocks_count, uint64_t max_workers) const;
+	void SplitBlocksIfNeeded(uint64_t blocks_count, uint64_t max_workers);
+	uint64_t SplitOnChunkSegments(uint64_t max_workers);
+	void LoadDirtyBlocks(uint64_t blocks_count);
+	void PrepareZeroBlocks();
+	void CopyCleanRecords();
+	void CopyBaseRecords(uint64_t first, uint64_t last);
+	void SavePartResult(WorkerResult const&);
+	void SaveChunkResult(WorkerResult const&);
+	void CheckChunkSegments() const;
+	void WriteRecord(uint64_t block_num, uint32_t rolling_sum, uint8_t const* hash, size_t hash_size);
+	void WriteChunkRecord(uint64_t offset, uint64_t length, uint8_t const* hash, size_t hash_size);
+	void SaveMerkleTree();
+	void SaveDedup();
+
+private:
+	struct PartialBlock
+	{
+		std::vector<uint8_t> parts_result;
+		uint64_t             received = 0;
+	};
+	using partial_blocks_t = std::unordered_map<uint64_t, PartialBlock>;
+
+	// The chunks of a segment before its `sync` offset are dropped: they are
+	// covered by the chunks of the previous segments
+	struct ChunkSegment
+	{
+		static constexpr uint64_t UNKNOWN = UINT64_MAX;
+		struct Chunk
+		{
+			uint64_t             offset;
+			uint64_t             length;
+			std::vector<uint8_t> hash;
+		};
+
+		uint64_t           seam = UNKNOWN; // where the previous chunking meets this one
+		uint64_t           sync = UNKNOWN; // max(seam, the previous sync)
+		std::vector<Chunk> pending;        // the chunks received before `sync`
+	};
+	using chunk_segments_t = std::vector<ChunkSegment>;
+	using hasher_t         = algo::HasherFactory::hasher_t;
+	using merkle_tree_t    = std::unique_ptr<MerkleTree>;
+	using base_signature_t = std::unique_ptr<SignatureFile>;
+	using dedup_table_t    = std::unique_ptr<DedupTable>;
 
 private:
 	Config&               m_cfg;
@@ -53,6 +135,21 @@ private:
 	pool_storage_t        m_pool_storage;
 	result_queue_t        m_results;
 	std::vector<Worker>   m_workers;
+	hasher_t              m_combiner;       // merges parts of blocks
+	partial_blocks_t      m_partialBlocks;
+	merkle_tree_t         m_merkle;         // if Config::GetMerkleFile is set
+	dedup_table_t         m_dedup;          // if Config::IsDedup
+	chunk_segments_t      m_chunkSegments;  // chunking=cdc
+	uint64_t              m_syncedSegments = 0;
+	uint64_t              m_chunksCount    = 0;
+	base_signature_t      m_base;           // if Config::IsIncremental
+	std::vector<uint64_t> m_dirtyBlocks;
+	bool                  m_isSkippingZeros = false;
+	std::once_flag        m_zeroDigestOnce;
+	std::vector<uint8_t>  m_zeroDigest;     // see GetZeroDigest
+	std::unique_ptr<SparseMap> m_sparse;
+	std::unique_ptr<BlockRing> m_ring;          // if Config::IsPipeline
+	std::atomic<uint64_t> m_streamSize {UINT64_MAX}; // unknown until the end
 
 	bool                  m_wasFinished = false;
 	bool                  m_isAborting  = false;
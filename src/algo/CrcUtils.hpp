@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+
+#include <cstdint>
+#include <cstring>
+
+
+
+namespace algo::crc {
+
+// Reflected polynomials
+constexpr uint32_t POLY_CRC32  = 0xEDB88320; // IEEE 802.3
+constexpr uint32_t POLY_CRC32C = 0x82F63B78; // Castagnoli
+
+template <std::size_t N>
+using slice_tables_t = std::array<std::array<uint32_t, 256>, N>;
+
+
+
+// Generates tables for the "slice-by-N" algorithm at compile time:
+// tables[0] is the classic byte-wise table, tables[k][i] is CRC of the byte
+// `i` followed by `k` zero bytes.
+template <uint32_t POLY, std::size_t N>
+constexpr slice_tables_t<N>
+MakeSliceTables()
+{
+	slice_tables_t<N> tables {};
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; ++bit)
+		{
+			crc = (crc & 1) ? (crc >> 1) ^ POLY : (crc >> 1);
+		}
+		tables[0][i] = crc;
+	}
+	for (std::size_t k = 1; k < N; ++k)
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t const prev = tables[k - 1][i];
+			tables[k][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+		}
+	}
+	return tables;
+}
+
+
+
+// Multiplies the polynomials a(x) and b(x) modulo POLY. All of them are
+// bit-reflected, i.e. the value `1u << 31` is x^0 (see zlib's `multmodp`).
+template <uint32_t POLY>
+constexpr uint32_t
+MultModP(uint32_t a, uint32_t b) noexcept
+{
+	uint32_t res = 0;
+	for (uint32_t m = 1u << 31; m != 0; m >>= 1)
+	{
+		if (a & m) { res ^= b; }
+		b = (b & 1) ? (b >> 1) ^ POLY : (b >> 1);
+	}
+	return res;
+}
+
+
+
+// Returns x^(8*n) modulo POLY: the operator which appends `n` zero bytes
+// to the raw CRC register.
+template <uint32_t POLY>
+constexpr uint32_t
+X8nModP(uint64_t n) noexcept
+{
+	uint32_t res = 1u << 31; // x^0
+	uint32_t sq  = 1u << 23; // x^8
+	while (n != 0)
+	{
+		if (n & 1) { res = MultModP<POLY>(sq, res); }
+		sq = MultModP<POLY>(sq, sq);
+		n >>= 1;
+	}
+	return res;
+}
+
+
+
+// Returns CRC of the concatenation A|B by CRC of A, CRC of B and length of B
+// (see zlib's `crc32_combine`). It takes O(log(len2)) time.
+template <uint32_t POLY>
+constexpr uint32_t
+Combine(uint32_t crc1, uint32_t crc2, uint64_t len2) noexcept
+{
+	return MultModP<POLY>(X8nModP<POLY>(len2), crc1) ^ crc2;
+}
+
+
+
+// Appends `n` copies of the same byte to the raw CRC register in O(log(n))
+// time. `byte_crc` is the raw CRC of that byte alone (tables[0][byte] of
+// MakeSliceTables). The register of 2L bytes run is the register of L bytes
+// run shifted over L zero bytes and xored with itself.
+template <uint32_t POLY>
+constexpr uint32_t
+AppendRun(uint32_t crc, uint32_t byte_crc, uint64_t n) noexcept
+{
+	uint32_t run = byte_crc;  // the raw CRC of the run of `len` bytes
+	uint32_t op  = 1u << 23;  // x^(8*len): appends `len` zero bytes
+	while (n != 0)
+	{
+		if (n & 1) { crc = MultModP<POLY>(op, crc) ^ run; }
+		n >>= 1;
+		if (n == 0) { break; }
+		run = MultModP<POLY>(op, run) ^ run;
+		op  = MultModP<POLY>(op, op);
+	}
+	return crc;
+}
+
+
+
+// Generates tables which append `LEN` zero bytes to the raw CRC register
+// byte by byte (see Mark Adler's crc32c.c `crc32c_zeros`).
+template <uint32_t POLY, uint64_t LEN>
+constexpr slice_tables_t<4>
+MakeShiftTables()
+{
+	constexpr uint32_t op = X8nModP<POLY>(LEN);
+	slice_tables_t<4> tables {};
+	for (uint32_t k = 0; k < 4; ++k)
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			tables[k][i] = MultModP<POLY>(op, i << (8 * k));
+		}
+	}
+	return tables;
+}
+
+
+
+inline uint32_t
+Shift(slice_tables_t<4> const& t, uint32_t crc) noexcept
+{
+	return t[0][ crc        & 0xFF] ^ t[1][(crc >>  8) & 0xFF]
+	     ^ t[2][(crc >> 16) & 0xFF] ^ t[3][ crc >> 24        ];
+}
+
+
+
+inline uint32_t
+LoadBe32(uint8_t const* p) noexcept
+{
+	return (static_cast<uint32_t>(p[0]) << 24)
+	     | (static_cast<uint32_t>(p[1]) << 16)
+	     | (static_cast<uint32_t>(p[2]) <<  8)
+	     |  static_cast<uint32_t>(p[3]);
+}
+
+
+inline void
+StoreBe32(uint8_t* p, uint32_t v) noexcept
+{
+	p[0] = static_cast<uint8_t>(v >> 24);
+	p[1] = static_cast<uint8_t>(v >> 16);
+	p[2] = static_cast<uint8_t>(v >>  8);
+	p[3] = static_cast<uint8_t>(v);
+}
+
+
+
+// Merges CRCs (big-endian) of the consecutive parts (see IHasher::CombineParts)
+template <uint32_t POLY>
+inline void
+CombineParts(uint8_t const* parts, std::size_t count, uint64_t part_size,
+             uint64_t last_part_size, uint8_t* result) noexcept
+{
+	uint32_t crc = LoadBe32(parts);
+	for (std::size_t i = 1; i < count; ++i)
+	{
+		uint64_t const len = (i + 1 == count) ? last_part_size : part_size;
+		crc = Combine<POLY>(crc, LoadBe32(parts + 4*i), len);
+	}
+	StoreBe32(result, crc);
+}
+
+
+
+inline uint32_t
+LoadLe32(uint8_t const* p) noexcept
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+#else
+	return  static_cast<uint32_t>(p[0])
+	     | (static_cast<uint32_t>(p[1]) <<  8)
+	     | (static_cast<uint32_t>(p[2]) << 16)
+	     | (static_cast<uint32_t>(p[3]) << 24);
+#endif
+}
+
+
+
+// Updates the raw (not inverted) CRC register by "slice-by-16" algorithm.
+template <std::size_t N>
+inline uint32_t
+UpdateSlice16(slice_tables_t<N> const& t, uint32_t crc, uint8_t const* p, std::size_t len) noexcept
+{
+	static_assert(N >= 16, "slice-by-16 requires 16 tables");
+	while (len >= 16)
+	{
+		uint32_t const w0 = LoadLe32(p) ^ crc;
+		uint32_t const w1 = LoadLe32(p + 4);
+		uint32_t const w2 = LoadLe32(p + 8);
+		uint32_t const w3 = LoadLe32(p + 12);
+		crc = t[15][ w0        & 0xFF] ^ t[14][(w0 >>  8) & 0xFF]
+		    ^ t[13][(w0 >> 16) & 0xFF] ^ t[12][ w0 >> 24        ]
+		    ^ t[11][ w1        & 0xFF] ^ t[10][(w1 >>  8) & 0xFF]
+		    ^ t[ 9][(w1 >> 16) & 0xFF] ^ t[ 8][ w1 >> 24        ]
+		    ^ t[ 7][ w2        & 0xFF] ^ t[ 6][(w2 >>  8) & 0xFF]
+		    ^ t[ 5][(w2 >> 16) & 0xFF] ^ t[ 4][ w2 >> 24        ]
+		    ^ t[ 3][ w3        & 0xFF] ^ t[ 2][(w3 >>  8) & 0xFF]
+		    ^ t[ 1][(w3 >> 16) & 0xFF] ^ t[ 0][ w3 >> 24        ];
+		p   += 16;
+		len -= 16;
+	}
+	while (len-- != 0)
+	{
+		crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+	}
+	return crc;
+}
+
+} // namespace algo::crc
@@ -0,0 +1,731 @@
+#include "HasherBlake3.hpp"
+
+#include <array>
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+#include "SimdTranspose.hpp"
+
+
+
+namespace {
+
+using algo::HasherBlake3;
+using output_t = HasherBlake3::output_t;
+using cv_stack_t = uint8_t[HasherBlake3::MAX_DEPTH][HasherBlake3::OUT_LEN];
+
+constexpr std::size_t BLOCK_LEN        = HasherBlake3::BLOCK_LEN;
+constexpr std::size_t CHUNK_LEN        = HasherBlake3::CHUNK_LEN;
+constexpr std::size_t OUT_LEN          = HasherBlake3::OUT_LEN;
+constexpr std::size_t BLOCKS_PER_CHUNK = CHUNK_LEN / BLOCK_LEN;
+constexpr std::size_t ROUNDS           = 7;
+
+// Domain flags
+constexpr uint32_t CHUNK_START = 1u << 0;
+constexpr uint32_t CHUNK_END   = 1u << 1;
+constexpr uint32_t PARENT      = 1u << 2;
+constexpr uint32_t ROOT        = 1u << 3;
+
+constexpr uint32_t IV[8] = {
+	0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+	0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+constexpr uint8_t MSG_PERMUTATION[16] = { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 };
+
+
+// The message words order of each round: the permutation is applied
+// to the order of the previous round.
+constexpr std::array<std::array<uint8_t, 16>, ROUNDS>
+MakeMsgSchedule()
+{
+	std::array<std::array<uint8_t, 16>, ROUNDS> s {};
+	for (uint8_t i = 0; i < 16; ++i) { s[0][i] = i; }
+	for (std::size_t r = 1; r < ROUNDS; ++r)
+	{
+		for (std::size_t i = 0; i < 16; ++i) { s[r][i] = s[r - 1][MSG_PERMUTATION[i]]; }
+	}
+	return s;
+}
+
+constexpr auto MSG_SCHEDULE = MakeMsgSchedule();
+
+
+
+inline uint32_t
+Load32(uint8_t const* p) noexcept
+{
+	return  static_cast<uint32_t>(p[0])
+	     | (static_cast<uint32_t>(p[1]) <<  8)
+	     | (static_cast<uint32_t>(p[2]) << 16)
+	     | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+
+inline void
+Store32(uint8_t* p, uint32_t v) noexcept
+{
+	p[0] = static_cast<uint8_t>(v);
+	p[1] = static_cast<uint8_t>(v >>  8);
+	p[2] = static_cast<uint8_t>(v >> 16);
+	p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+
+inline uint32_t Rotr32(uint32_t v, int r) noexcept { return (v >> r) | (v << (32 - r)); }
+
+
+
+// The quarter-round and the round are shared by the scalar and SIMD code:
+// V_ADD, V_XOR and V_ROTR16/12/8/7 have to be defined before the use.
+#define BLAKE3_G(a, b, c, d, mx, my) \
+	{ \
+		(a) = V_ADD(V_ADD((a), (b)), (mx)); \
+		(d) = V_ROTR16(V_XOR((d), (a))); \
+		(c) = V_ADD((c), (d)); \
+		(b) = V_ROTR12(V_XOR((b), (c))); \
+		(a) = V_ADD(V_ADD((a), (b)), (my)); \
+		(d) = V_ROTR8(V_XOR((d), (a))); \
+		(c) = V_ADD((c), (d)); \
+		(b) = V_ROTR7(V_XOR((b), (c))); \
+	}
+
+#define BLAKE3_ROUND(v, m, r) \
+	/* Columns */ \
+	BLAKE3_G(v[0], v[4], v[ 8], v[12], m[MSG_SCHEDULE[r][ 0]], m[MSG_SCHEDULE[r][ 1]]) \
+	BLAKE3_G(v[1], v[5], v[ 9], v[13], m[MSG_SCHEDULE[r][ 2]], m[MSG_SCHEDULE[r][ 3]]) \
+	BLAKE3_G(v[2], v[6], v[10], v[14], m[MSG_SCHEDULE[r][ 4]], m[MSG_SCHEDULE[r][ 5]]) \
+	BLAKE3_G(v[3], v[7], v[11], v[15], m[MSG_SCHEDULE[r][ 6]], m[MSG_SCHEDULE[r][ 7]]) \
+	/* Diagonals */ \
+	BLAKE3_G(v[0], v[5], v[10], v[15], m[MSG_SCHEDULE[r][ 8]], m[MSG_SCHEDULE[r][ 9]]) \
+	BLAKE3_G(v[1], v[6], v[11], v[12], m[MSG_SCHEDULE[r][10]], m[MSG_SCHEDULE[r][11]]) \
+	BLAKE3_G(v[2], v[7], v[ 8], v[13], m[MSG_SCHEDULE[r][12]], m[MSG_SCHEDULE[r][13]]) \
+	BLAKE3_G(v[3], v[4], v[ 9], v[14], m[MSG_SCHEDULE[r][14]], m[MSG_SCHEDULE[r][15]])
+
+#define BLAKE3_ROUNDS(v, m) \
+	BLAKE3_ROUND(v, m, 0) \
+	BLAKE3_ROUND(v, m, 1) \
+	BLAKE3_ROUND(v, m, 2) \
+	BLAKE3_ROUND(v, m, 3) \
+	BLAKE3_ROUND(v, m, 4) \
+	BLAKE3_ROUND(v, m, 5) \
+	BLAKE3_ROUND(v, m, 6)
+
+
+
+//
+// Portable
+//
+#define V_ADD(a, b)  ((a) + (b))
+#define V_XOR(a, b)  ((a) ^ (b))
+#define V_ROTR16(a)  Rotr32((a), 16)
+#define V_ROTR12(a)  Rotr32((a), 12)
+#define V_ROTR8(a)   Rotr32((a),  8)
+#define V_ROTR7(a)   Rotr32((a),  7)
+
+// Returns the full compression state: the first 8 words are the new chaining
+// value and all 16 words are the extended output.
+void
+Compress(uint32_t const cv[8], uint8_t const* block, uint64_t counter,
+         uint32_t block_len, uint32_t flags, uint32_t out[16])
+{
+	uint32_t m[16];
+	for (std::size_t i = 0; i < 16; ++i) { m[i] = Load32(block + 4 * i); }
+
+	uint32_t v[16] = {
+		cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+		IV[0], IV[1], IV[2], IV[3],
+		static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+		block_len, flags,
+	};
+	BLAKE3_ROUNDS(v, m)
+
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		out[i]     = v[i] ^ v[i + 8];
+		out[i + 8] = v[i + 8] ^ cv[i];
+	}
+}
+
+#undef V_ADD
+#undef V_XOR
+#undef V_ROTR16
+#undef V_ROTR12
+#undef V_ROTR8
+#undef V_ROTR7
+
+
+
+// `len` is in [0, CHUNK_LEN]. Compresses all blocks of the chunk except
+// the last one.
+output_t
+ChunkOutput(uint8_t const* chunk, std::size_t len, uint64_t counter)
+{
+	output_t out;
+	std::memcpy(out.cv, IV, sizeof(IV));
+	out.counter = counter;
+
+	uint32_t flags = CHUNK_START;
+	uint32_t state[16];
+	for (; len > BLOCK_LEN; len -= BLOCK_LEN, chunk += BLOCK_LEN)
+	{
+		Compress(out.cv, chunk, counter, BLOCK_LEN, flags, state);
+		std::memcpy(out.cv, state, sizeof(out.cv));
+		flags = 0;
+	}
+	std::memset(out.block, 0, BLOCK_LEN);
+	std::memcpy(out.block, chunk, len);
+	out.block_len = static_cast<uint32_t>(len);
+	out.flags     = flags | CHUNK_END;
+	return out;
+}
+
+
+output_t
+ParentOutput(uint8_t const* left_cv, uint8_t const* right_cv)
+{
+	output_t out;
+	std::memcpy(out.cv, IV, sizeof(IV));
+	std::memcpy(out.block, left_cv, OUT_LEN);
+	std::memcpy(out.block + OUT_LEN, right_cv, OUT_LEN);
+	out.counter   = 0;
+	out.block_len = BLOCK_LEN;
+	out.flags     = PARENT;
+	return out;
+}
+
+
+void
+OutputCv(output_t const& out, uint8_t* cv)
+{
+	uint32_t state[16];
+	Compress(out.cv, out.block, out.counter, out.block_len, out.flags, state);
+	for (std::size_t i = 0; i < 8; ++i) { Store32(cv + 4 * i, state[i]); }
+}
+
+
+void
+OutputRoot(output_t const& out, uint8_t* result)
+{
+	uint32_t state[16];
+	Compress(out.cv, out.block, 0, out.block_len, out.flags | ROOT, state);
+	for (std::size_t i = 0; i < OUT_LEN / 4; ++i) { Store32(result + 4 * i, state[i]); }
+}
+
+
+// Pushes the chaining value of a subtree of the same size as the previous
+// ones and merges the completed subtrees. `total` is the number of
+// subtrees including the pushed one.
+void
+PushCv(cv_stack_t& stack, std::size_t& stack_len, uint8_t const* new_cv, uint64_t total)
+{
+	uint8_t cv[OUT_LEN];
+	std::memcpy(cv, new_cv, OUT_LEN);
+	for (; (total & 1) == 0; total >>= 1)
+	{
+		--stack_len;
+		OutputCv(ParentOutput(stack[stack_len], cv), cv);
+	}
+	std::memcpy(stack[stack_len], cv, OUT_LEN);
+	++stack_len;
+}
+
+
+void
+HashChunksPortable(uint8_t const* chunks, uint64_t counter, uint8_t* cvs)
+{
+	OutputCv(ChunkOutput(chunks, CHUNK_LEN, counter), cvs);
+}
+
+
+
+#if defined(__x86_64__)
+
+using algo::simd::Transpose4x4;
+using algo::simd::Transpose8x8;
+using algo::simd::Transpose16x16;
+
+
+template <std::size_t LANES>
+struct LanesCounter
+{
+	alignas(64) uint32_t lo[LANES];
+	alignas(64) uint32_t hi[LANES];
+
+	explicit LanesCounter(uint64_t counter)
+	{
+		for (std::size_t l = 0; l < LANES; ++l)
+		{
+			lo[l] = static_cast<uint32_t>(counter + l);
+			hi[l] = static_cast<uint32_t>((counter + l) >> 32);
+		}
+	}
+};
+
+
+// Stores the chaining values from h[word][lane] to cvs[lane][word]
+template <std::size_t LANES>
+void
+StoreLanesCv(uint32_t const (&h)[8][LANES], uint8_t* cvs)
+{
+	for (std::size_t l = 0; l < LANES; ++l)
+	{
+		for (std::size_t i = 0; i < 8; ++i) { Store32(cvs + OUT_LEN * l + 4 * i, h[i][l]); }
+	}
+}
+
+
+
+//
+// SSE4.1: 4 lanes
+//
+#define V_ADD(a, b)  _mm_add_epi32((a), (b))
+#define V_XOR(a, b)  _mm_xor_si128((a), (b))
+#define V_ROTR16(a)  _mm_shuffle_epi8((a), _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13))
+#define V_ROTR12(a)  _mm_or_si128(_mm_srli_epi32((a), 12), _mm_slli_epi32((a), 20))
+#define V_ROTR8(a)   _mm_shuffle_epi8((a), _mm_setr_epi8(1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12))
+#define V_ROTR7(a)   _mm_or_si128(_mm_srli_epi32((a), 7), _mm_slli_epi32((a), 25))
+
+__attribute__((target("sse4.1")))
+void
+HashChunksSse41(uint8_t const* chunks, uint64_t counter, uint8_t* cvs)
+{
+	constexpr std::size_t LANES = 4;
+	LanesCounter<LANES> const cnt(counter);
+	__m128i const cnt_lo = _mm_load_si128(reinterpret_cast<__m128i const*>(cnt.lo));
+	__m128i const cnt_hi = _mm_load_si128(reinterpret_cast<__m128i const*>(cnt.hi));
+
+	__m128i h[8];
+	for (std::size_t i = 0; i < 8; ++i) { h[i] = _mm_set1_epi32(static_cast<int>(IV[i])); }
+
+	__m128i m[16];
+	for (std::size_t b = 0; b < BLOCKS_PER_CHUNK; ++b)
+	{
+		for (std::size_t w = 0; w < 16; w += 4)
+		{
+			for (std::size_t l = 0; l < LANES; ++l)
+			{
+				m[w + l] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(
+					chunks + CHUNK_LEN * l + BLOCK_LEN * b + 4 * w));
+			}
+			Transpose4x4(&m[w]);
+		}
+
+		uint32_t const flags = (b == 0 ? CHUNK_START : 0u) | (b == BLOCKS_PER_CHUNK - 1 ? CHUNK_END : 0u);
+		__m128i v[16] = {
+			h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+			_mm_set1_epi32(static_cast<int>(IV[0])), _mm_set1_epi32(static_cast<int>(IV[1])),
+			_mm_set1_epi32(static_cast<int>(IV[2])), _mm_set1_epi32(static_cast<int>(IV[3])),
+			cnt_lo, cnt_hi,
+			_mm_set1_epi32(BLOCK_LEN), _mm_set1_epi32(static_cast<int>(flags)),
+		};
+		BLAKE3_ROUNDS(v, m)
+		for (std::size_t i = 0; i < 8; ++i) { h[i] = V_XOR(v[i], v[i + 8]); }
+	}
+
+	alignas(16) uint32_t out[8][LANES];
+	for (std::size_t i = 0; i < 8; ++i) { _mm_store_si128(reinterpret_cast<__m128i*>(out[i]), h[i]); }
+	StoreLanesCv(out, cvs);
+}
+
+#undef V_ADD
+#undef V_XOR
+#undef V_ROTR16
+#undef V_ROTR12
+#undef V_ROTR8
+#undef V_ROTR7
+
+
+
+//
+// AVX2: 8 lanes
+//
+#define V_ADD(a, b)  _mm256_add_epi32((a), (b))
+#define V_XOR(a, b)  _mm256_xor_si256((a), (b))
+#define V_ROTR16(a)  _mm256_shuffle_epi8((a), _mm256_setr_epi8( \
+	2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, \
+	2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13))
+#define V_ROTR12(a)  _mm256_or_si256(_mm256_srli_epi32((a), 12), _mm256_slli_epi32((a), 20))
+#define V_ROTR8(a)   _mm256_shuffle_epi8((a), _mm256_setr_epi8( \
+	1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12, \
+	1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12))
+#define V_ROTR7(a)   _mm256_or_si256(_mm256_srli_epi32((a), 7), _mm256_slli_epi32((a), 25))
+
+__attribute__((target("avx2")))
+void
+HashChunksAvx2(uint8_t const* chunks, uint64_t counter, uint8_t* cvs)
+{
+	constexpr std::size_t LANES = 8;
+	LanesCounter<LANES> const cnt(counter);
+	__m256i const cnt_lo = _mm256_load_si256(reinterpret_cast<__m256i const*>(cnt.lo));
+	__m256i const cnt_hi = _mm256_load_si256(reinterpret_cast<__m256i const*>(cnt.hi));
+
+	__m256i h[8];
+	for (std::size_t i = 0; i < 8; ++i) { h[i] = _mm256_set1_epi32(static_cast<int>(IV[i])); }
+
+	__m256i m[16];
+	for (std::size_t b = 0; b < BLOCKS_PER_CHUNK; ++b)
+	{
+		for (std::size_t w = 0; w < 16; w += 8)
+		{
+			for (std::size_t l = 0; l < LANES; ++l)
+			{
+				m[w + l] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(
+					chunks + CHUNK_LEN * l + BLOCK_LEN * b + 4 * w));
+			}
+			Transpose8x8(&m[w]);
+		}
+
+		uint32_t const flags = (b == 0 ? CHUNK_START : 0u) | (b == BLOCKS_PER_CHUNK - 1 ? CHUNK_END : 0u);
+		__m256i v[16] = {
+			h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+			_mm256_set1_epi32(static_cast<int>(IV[0])), _mm256_set1_epi32(static_cast<int>(IV[1])),
+			_mm256_set1_epi32(static_cast<int>(IV[2])), _mm256_set1_epi32(static_cast<int>(IV[3])),
+			cnt_lo, cnt_hi,
+			_mm256_set1_epi32(BLOCK_LEN), _mm256_set1_epi32(static_cast<int>(flags)),
+		};
+		BLAKE3_ROUNDS(v, m)
+		for (std::size_t i = 0; i < 8; ++i) { h[i] = V_XOR(v[i], v[i + 8]); }
+	}
+
+	alignas(32) uint32_t out[8][LANES];
+	for (std::size_t i = 0; i < 8; ++i) { _mm256_store_si256(reinterpret_cast<__m256i*>(out[i]), h[i]); }
+	StoreLanesCv(out, cvs);
+}
+
+#undef V_ADD
+#undef V_XOR
+#undef V_ROTR16
+#undef V_ROTR12
+#undef V_ROTR8
+#undef V_ROTR7
+
+
+
+//
+// AVX-512: 16 lanes
+//
+#define V_ADD(a, b)  _mm512_add_epi32((a), (b))
+#define V_XOR(a, b)  _mm512_xor_si512((a), (b))
+#define V_ROTR16(a)  _mm512_ror_epi32((a), 16)
+#define V_ROTR12(a)  _mm512_ror_epi32((a), 12)
+#define V_ROTR8(a)   _mm512_ror_epi32((a),  8)
+#define V_ROTR7(a)   _mm512_ror_epi32((a),  7)
+
+__attribute__((target("avx512f")))
+void
+HashChunksAvx512(uint8_t const* chunks, uint64_t counter, uint8_t* cvs)
+{
+	constexpr std::size_t LANES = 16;
+	LanesCounter<LANES> const cnt(counter);
+	__m512i const cnt_lo = _mm512_load_si512(cnt.lo);
+	__m512i const cnt_hi = _mm512_load_si512(cnt.hi);
+
+	__m512i h[8];
+	for (std::size_t i = 0; i < 8; ++i) { h[i] = _mm512_set1_epi32(static_cast<int>(IV[i])); }
+
+	__m512i m[16];
+	for (std::size_t b = 0; b < BLOCKS_PER_CHUNK; ++b)
+	{
+		for (std::size_t l = 0; l < LANES; ++l)
+		{
+			m[l] = _mm512_loadu_si512(chunks + CHUNK_LEN * l + BLOCK_LEN * b);
+		}
+		Transpose16x16(m);
+
+		uint32_t const flags = (b == 0 ? CHUNK_START : 0u) | (b == BLOCKS_PER_CHUNK - 1 ? CHUNK_END : 0u);
+		__m512i v[16] = {
+			h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+			_mm512_set1_epi32(static_cast<int>(IV[0])), _mm512_set1_epi32(static_cast<int>(IV[1])),
+			_mm512_set1_epi32(static_cast<int>(IV[2])), _mm512_set1_epi32(static_cast<int>(IV[3])),
+			cnt_lo, cnt_hi,
+			_mm512_set1_epi32(BLOCK_LEN), _mm512_set1_epi32(static_cast<int>(flags)),
+		};
+		BLAKE3_ROUNDS(v, m)
+		for (std::size_t i = 0; i < 8; ++i) { h[i] = V_XOR(v[i], v[i + 8]); }
+	}
+
+	alignas(64) uint32_t out[8][LANES];
+	for (std::size_t i = 0; i < 8; ++i) { _mm512_store_si512(out[i], h[i]); }
+	StoreLanesCv(out, cvs);
+}
+
+#undef V_ADD
+#undef V_XOR
+#undef V_ROTR16
+#undef V_ROTR12
+#undef V_ROTR8
+#undef V_ROTR7
+
+#endif // __x86_64__
+
+#undef BLAKE3_ROUNDS
+#undef BLAKE3_ROUND
+#undef BLAKE3_G
+
+
+struct Kernel
+{
+	HasherBlake3::hash_chunks_t hash_chunks = &HashChunksPortable;
+	std::size_t                 lanes       = 1;
+};
+
+
+Kernel
+SelectKernel() noexcept
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX512F)) { return {&HashChunksAvx512, 16}; }
+	if (CpuFeatures::Has(CpuFeatures::AVX2))    { return {&HashChunksAvx2,    8}; }
+	if (CpuFeatures::Has(CpuFeatures::SSE41))   { return {&HashChunksSse41,   4}; }
+#endif
+	return {};
+}
+
+} // namespace
+
+
+
+namespace algo {
+
+// static
+std::size_t
+HasherBlake3::SupportedLanes() noexcept
+{
+	return SelectKernel().lanes;
+}
+
+
+
+HasherBlake3::HasherBlake3()
+{
+	Kernel const kernel = SelectKernel();
+	m_hashChunks = kernel.hash_chunks;
+	m_lanes      = kernel.lanes;
+	Init(InitBlake3HashStrategy{});
+}
+
+
+
+int
+HasherBlake3::Init(InitHashStrategy const&)
+{
+	m_cvStackLen   = 0;
+	m_bufferedSize = 0;
+	m_chunkCounter = 0;
+	m_chunksHashed = 0;
+	m_was_finished = false;
+	return 0;
+}
+
+
+
+int
+HasherBlake3::InitPart(InitHashStrategy const& strategy, std::uint64_t offset)
+{
+	if (offset % CHUNK_LEN != 0)
+	{
+		THROW_ERROR("HasherBlake3::%s: the part offset %zu isn't aligned on the chunk size",
+		            __FUNCTION__, offset);
+	}
+	Init(strategy);
+	m_chunkCounter = offset / CHUNK_LEN;
+	return 0;
+}
+
+
+
+void
+HasherBlake3::PushChunkCv(uint8_t const* cv)
+{
+	++m_chunkCounter;
+	++m_chunksHashed;
+	PushCv(m_cvStack, m_cvStackLen, cv, m_chunksHashed);
+}
+
+
+
+void
+HasherBlake3::HashChunks(uint8_t const* chunks, std::size_t count)
+{
+	uint8_t cvs[MAX_LANES * OUT_LEN];
+	for (; count >= m_lanes; count -= m_lanes, chunks += m_lanes * CHUNK_LEN)
+	{
+		m_hashChunks(chunks, m_chunkCounter, cvs);
+		for (std::size_t l = 0; l < m_lanes; ++l) { PushChunkCv(cvs + OUT_LEN * l); }
+	}
+	for (; count != 0; --count, chunks += CHUNK_LEN)
+	{
+		HashChunksPortable(chunks, m_chunkCounter, cvs);
+		PushChunkCv(cvs);
+	}
+}
+
+
+
+int
+HasherBlake3::Update(uint8_t const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherBlake3::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	//NOTE: the last chunk is always kept in the buffer because it becomes
+	// the root node if there are no more data.
+	std::size_t const buffer_size = m_lanes * CHUNK_LEN;
+	if (m_bufferedSize + inputLen <= buffer_size)
+	{
+		std::memcpy(m_buffer + m_bufferedSize, input, inputLen);
+		m_bufferedSize += inputLen;
+		return 0;
+	}
+	if (m_bufferedSize != 0)
+	{
+		std::size_t const fill = buffer_size - m_bufferedSize;
+		std::memcpy(m_buffer + m_bufferedSize, input, fill);
+		HashChunks(m_buffer, m_lanes);
+		input    += fill;
+		inputLen -= fill;
+		m_bufferedSize = 0;
+	}
+	for (; inputLen > buffer_size; inputLen -= buffer_size, input += buffer_size)
+	{
+		HashChunks(input, m_lanes);
+	}
+	std::memcpy(m_buffer, input, inputLen);
+	m_bufferedSize = inputLen;
+	return 0;
+}
+
+
+
+HasherBlake3::output_t
+HasherBlake3::FinalOutput()
+{
+	std::size_t const full_chunks = (m_bufferedSize != 0) ? (m_bufferedSize - 1) / CHUNK_LEN : 0;
+	HashChunks(m_buffer, full_chunks);
+
+	output_t out = ChunkOutput(m_buffer + full_chunks * CHUNK_LEN,
+	                           m_bufferedSize - full_chunks * CHUNK_LEN,
+	                           m_chunkCounter);
+	uint8_t cv[OUT_LEN];
+	while (m_cvStackLen != 0)
+	{
+		--m_cvStackLen;
+		OutputCv(out, cv);
+		out = ParentOutput(m_cvStack[m_cvStackLen], cv);
+	}
+	return out;
+}
+
+
+
+int
+HasherBlake3::Finish(uint8_t* buffer)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherBlake3::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	OutputRoot(FinalOutput(), buffer);
+
+	m_was_finished = true;
+	return 0;
+}
+
+
+
+int
+HasherBlake3::FinishPart(uint8_t* part_result)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherBlake3::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	OutputCv(FinalOutput(), part_result);
+
+	m_was_finished = true;
+	return 0;
+}
+
+
+
+std::size_t
+HasherBlake3::ResultSize() const
+{
+	return OUT_LEN;
+}
+
+
+
+char const*
+HasherBlake3::KernelName() const
+{
+	switch (m_lanes)
+	{
+	case 16: return "avx512";
+	case 8:  return "avx2";
+	case 4:  return "sse4.1";
+	}
+	return "portable";
+}
+
+
+
+std::size_t
+HasherBlake3::PartResultSize() const
+{
+	return OUT_LEN;
+}
+
+
+
+std::uint64_t
+HasherBlake3::AlignPartSize(std::uint64_t part_size) const
+{
+	// A part has to be a complete subtree: 2^N chunks
+	if (part_size < CHUNK_LEN) { return 0; }
+	return std::uint64_t{1} << (63 - __builtin_clzll(part_size));
+}
+
+
+
+int
+HasherBlake3::CombineParts(uint8_t const* parts, std::size_t count,
+                           std::uint64_t /*part_size*/, std::uint64_t /*last_part_size*/,
+                           uint8_t* result)
+{
+	//NOTE: the root node of one part can't be restored from its chaining value
+	if (count < 2) { return -1; }
+
+	// The parts (except the last one) are the subtrees of the same size, so
+	// they are merged the same way as chunks.
+	cv_stack_t  stack;
+	std::size_t stack_len = 0;
+	for (std::size_t i = 0; i + 1 < count; ++i)
+	{
+		PushCv(stack, stack_len, parts + OUT_LEN * i, i + 1);
+	}
+
+	output_t out = ParentOutput(stack[--stack_len], parts + OUT_LEN * (count - 1));
+	uint8_t cv[OUT_LEN];
+	while (stack_len != 0)
+	{
+		--stack_len;
+		OutputCv(out, cv);
+		out = ParentOutput(stack[stack_len], cv);
+	}
+	OutputRoot(out, result);
+	return 0;
+}
+
+} // namespace algo
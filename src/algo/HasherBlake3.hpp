@@ -0,0 +1,94 @@
+#pragma once
+
+
+#include "IHasher.hpp"
+
+
+
+namespace algo {
+
+class InitBlake3HashStrategy : public InitHashStrategy
+{
+public:
+	InitBlake3HashStrategy()
+		: InitHashStrategy(hash_type_e::BLAKE3)
+	{}
+
+private:
+};
+
+
+
+// BLAKE3 (https://github.com/BLAKE3-team/BLAKE3-specs) with the default 32
+// bytes output. Several whole chunks are compressed at once by a SIMD kernel
+// (a chunk per lane). BLAKE3 is a tree hash, so a block can be split on parts
+// of 2^N chunks: a part is a subtree, its chaining value is returned by
+// `FinishPart` and the parts are merged by `CombineParts`.
+class HasherBlake3 final : public IHasher
+{
+public:
+	static constexpr std::size_t OUT_LEN   = 32;
+	static constexpr std::size_t KEY_LEN   = 32;
+	static constexpr std::size_t BLOCK_LEN = 64;
+	static constexpr std::size_t CHUNK_LEN = 1024;
+	static constexpr std::size_t MAX_LANES = 16;
+	static constexpr std::size_t MAX_DEPTH = 54; // 2^54 * CHUNK_LEN = 2^64 bytes
+
+	// Hashes `Lanes()` whole chunks with the counters [counter, counter + lanes)
+	// and stores their chaining values into `cvs`.
+	using hash_chunks_t = void (*)(uint8_t const* chunks, uint64_t counter, uint8_t* cvs);
+
+	// Returns the number of chunks hashed at once by the best kernel for the
+	// current CPU (1 if there is no SIMD kernel).
+	static std::size_t SupportedLanes() noexcept;
+
+	HasherBlake3(HasherBlake3&&)                 = delete;
+	HasherBlake3(HasherBlake3 const&)            = delete;
+	HasherBlake3& operator=(HasherBlake3&&)      = delete;
+	HasherBlake3& operator=(HasherBlake3 const&) = delete;
+
+	HasherBlake3();
+	~HasherBlake3() = default;
+
+	// IHasher
+	int Init(InitHashStrategy const&) override;
+	int Update(uint8_t const*, std::size_t) override;
+	int Finish(uint8_t*) override;
+	std::size_t ResultSize() const override;
+	char const* KernelName() const override;
+	bool IsSplittable() const override { return true; }
+	std::uint64_t AlignPartSize(std::uint64_t) const override;
+	int InitPart(InitHashStrategy const&, std::uint64_t offset) override;
+	std::size_t PartResultSize() const override;
+	int FinishPart(uint8_t*) override;
+	int CombineParts(uint8_t const*, std::size_t, std::uint64_t, std::uint64_t, uint8_t*) override;
+
+	// The state of the last compression that is needed to produce either
+	// a chaining value or the root output.
+	struct output_t
+	{
+		uint32_t cv[8];
+		uint8_t  block[BLOCK_LEN];
+		uint64_t counter;
+		uint32_t block_len;
+		uint32_t flags;
+	};
+
+private:
+	void HashChunks(uint8_t const* chunks, std::size_t count);
+	void PushChunkCv(uint8_t const* cv);
+	output_t FinalOutput();
+
+private:
+	alignas(64) uint8_t m_buffer[MAX_LANES * CHUNK_LEN];
+	uint8_t             m_cvStack[MAX_DEPTH][OUT_LEN];
+	std::size_t         m_cvStackLen    = 0;
+	std::size_t         m_bufferedSize  = 0;
+	uint64_t            m_chunkCounter  = 0; // the counter of the next chunk
+	uint64_t            m_chunksHashed  = 0; // since Init (for merging the stack)
+	hash_chunks_t       m_hashChunks    = nullptr;
+	std::size_t         m_lanes         = 1;
+	bool                m_was_finished  = false;
+};
+
+} // namespace algo
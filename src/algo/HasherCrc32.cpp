@@ -1,30 +1,213 @@
 #include "HasherCrc32.hpp"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+#include "CrcUtils.hpp"
+
+
+
+namespace {
+
+constexpr auto CRC32_TABLES = algo::crc::MakeSliceTables<algo::crc::POLY_CRC32, 16>();
+
+
+uint32_t
+UpdatePortable(uint32_t crc, uint8_t const* data, std::size_t len)
+{
+	return algo::crc::UpdateSlice16(CRC32_TABLES, crc, data, len);
+}
+
+
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.1,pclmul")))
+inline __m128i
+Load128(uint8_t const* p)
+{
+	return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+}
+
+
+// Returns (x.hi * k.hi) ^ (x.lo * k.lo) ^ y
+__attribute__((target("sse4.1,pclmul")))
+inline __m128i
+Fold128(__m128i x, __m128i k, __m128i y)
+{
+	__m128i const lo = _mm_clmulepi64_si128(x, k, 0x00);
+	__m128i const hi = _mm_clmulepi64_si128(x, k, 0x11);
+	return _mm_xor_si128(_mm_xor_si128(hi, lo), y);
+}
+
+
+// Folding by carry-less multiplication. See Intel's paper "Fast CRC
+// Computation for Generic Polynomials Using PCLMULQDQ Instruction" (2009).
+// The constants are the bit-reflected ones from the end of the paper.
+// Requirements: len >= 64 and len % 16 == 0.
+__attribute__((target("sse4.1,pclmul")))
+uint32_t
+FoldPclmul(uint32_t crc, uint8_t const* buf, std::size_t len)
+{
+	alignas(16) static uint64_t const k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+	alignas(16) static uint64_t const k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+	alignas(16) static uint64_t const k5k0[] = { 0x0163cd6124, 0x0000000000 };
+	alignas(16) static uint64_t const poly[] = { 0x01db710641, 0x01f7011641 };
+
+	__m128i x1 = Load128(buf + 0x00);
+	__m128i x2 = Load128(buf + 0x10);
+	__m128i x3 = Load128(buf + 0x20);
+	__m128i x4 = Load128(buf + 0x30);
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+	buf += 64;
+	len -= 64;
+
+	// Fold by 4 x 128 bits in parallel
+	__m128i k = _mm_load_si128(reinterpret_cast<__m128i const*>(k1k2));
+	while (len >= 64)
+	{
+		x1 = Fold128(x1, k, Load128(buf + 0x00));
+		x2 = Fold128(x2, k, Load128(buf + 0x10));
+		x3 = Fold128(x3, k, Load128(buf + 0x20));
+		x4 = Fold128(x4, k, Load128(buf + 0x30));
+		buf += 64;
+		len -= 64;
+	}
+
+	// Fold 512 bits into 128 bits
+	k  = _mm_load_si128(reinterpret_cast<__m128i const*>(k3k4));
+	x1 = Fold128(x1, k, x2);
+	x1 = Fold128(x1, k, x3);
+	x1 = Fold128(x1, k, x4);
+
+	while (len >= 16)
+	{
+		x1 = Fold128(x1, k, Load128(buf));
+		buf += 16;
+		len -= 16;
+	}
+
+	// Fold 128 bits into 64 bits
+	__m128i const mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	k  = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduction to 32 bits
+	k  = _mm_load_si128(reinterpret_cast<__m128i const*>(poly));
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, k, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+
+uint32_t
+UpdatePclmul(uint32_t crc, uint8_t const* data, std::size_t len)
+{
+	constexpr std::size_t MIN_FOLD_LEN = 64;
+	if (len >= MIN_FOLD_LEN)
+	{
+		std::size_t const fold_len = len & ~std::size_t{15};
+		crc   = FoldPclmul(crc, data, fold_len);
+		data += fold_len;
+		len  -= fold_len;
+	}
+	return UpdatePortable(crc, data, len);
+}
+
+#endif // __x86_64__
+
+
+algo::HasherCrc32::update_fn_t
+SelectUpdate()
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::PCLMUL | CpuFeatures::SSE41))
+	{
+		return &UpdatePclmul;
+	}
+#endif
+	return &UpdatePortable;
+}
+
+} // namespace
+
 
 
 namespace algo {
 
+HasherCrc32::HasherCrc32()
+	: m_update(SelectUpdate())
+{
+	Init(InitCrc32HashStrategy{});
+}
+
+
+
 int
 HasherCrc32::Init(InitHashStrategy const&)
 {
-	//TODO: implement
+	m_was_finished = false;
+	m_crc = 0xFFFFFFFF;
+	return 0;
+}
+
+
+
+int
+HasherCrc32::Update(uint8_t const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherCrc32::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	m_crc = m_update(m_crc, input, inputLen);
 	return 0;
 }
 
 
+
 int
-HasherCrc32::Update(uint8_t const*, std::size_t)
+HasherCrc32::UpdateFill(uint8_t ch, std::uint64_t count)
 {
-	//TODO: implement
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherCrc32::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	m_crc = crc::AppendRun<crc::POLY_CRC32>(m_crc, CRC32_TABLES[0][ch], count);
 	return 0;
 }
 
 
 
 int
-HasherCrc32::Finish(uint8_t*)
+HasherCrc32::Finish(uint8_t* buffer)
 {
-	//TODO: implement
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherCrc32::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	crc::StoreBe32(buffer, ~m_crc);
+
+	m_was_finished = true;
 	return 0;
 }
 
@@ -35,5 +218,24 @@ HasherCrc32::ResultSize() const
 	return 4; //32 bits
 }
 
-} // namespace algo
 
+
+char const*
+HasherCrc32::KernelName() const
+{
+	return (m_update == &UpdatePortable) ? "portable" : "pclmul";
+}
+
+
+
+int
+HasherCrc32::CombineParts(uint8_t const* parts, std::size_t count,
+                          std::uint64_t part_size, std::uint64_t last_part_size,
+                          uint8_t* result)
+{
+	if (count == 0) { return -1; }
+	crc::CombineParts<crc::POLY_CRC32>(parts, count, part_size, last_part_size, result);
+	return 0;
+}
+
+} // namespace algo
@@ -19,26 +19,35 @@ private:
 
 
 
-class HasherCrc32 : public IHasher
+// IEEE 802.3 CRC32 (the same as zlib's `crc32`). The digest is stored in
+// big-endian order, i.e. as it is usually printed.
+class HasherCrc32 final : public IHasher
 {
 public:
+	using update_fn_t = uint32_t (*)(uint32_t crc, uint8_t const*, std::size_t);
+
 	HasherCrc32(HasherCrc32&&)                 = delete;
 	HasherCrc32(HasherCrc32 const&)            = delete;
 	HasherCrc32& operator=(HasherCrc32&&)      = delete;
 	HasherCrc32& operator=(HasherCrc32 const&) = delete;
 
-	HasherCrc32() {}
+	HasherCrc32();
 	~HasherCrc32() = default;
 
 	// IHasher
 	int Init(InitHashStrategy const&) override;
 	int Update(uint8_t const*, std::size_t) override;
+	int UpdateFill(uint8_t, std::uint64_t) override;
 	int Finish(uint8_t*) override;
 	std::size_t ResultSize() const override;
+	char const* KernelName() const override;
+	bool IsSplittable() const override { return true; }
+	int CombineParts(uint8_t const*, std::size_t, std::uint64_t, std::uint64_t, uint8_t*) override;
 
 private:
-	bool m_was_finished = false;
+	update_fn_t m_update;
+	uint32_t    m_crc          = 0;
+	bool        m_was_finished = false;
 };
 
 } // namespace algo
-
@@ -0,0 +1,219 @@
+#include "HasherCrc32c.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+#include "CrcUtils.hpp"
+
+
+
+namespace {
+
+constexpr auto CRC32C_TABLES = algo::crc::MakeSliceTables<algo::crc::POLY_CRC32C, 16>();
+
+
+uint32_t
+UpdatePortable(uint32_t crc, uint8_t const* data, std::size_t len)
+{
+	return algo::crc::UpdateSlice16(CRC32C_TABLES, crc, data, len);
+}
+
+
+
+#if defined(__x86_64__)
+
+// The `crc32` instruction has latency 3 and throughput 1, so three independent
+// streams keep the unit busy. The streams are merged by shifting the CRC of
+// the preceding stream over the length of the next one (see Mark Adler's
+// answer https://stackoverflow.com/a/17646775).
+constexpr std::size_t LONG_LEN  = 8192;
+constexpr std::size_t SHORT_LEN = 256;
+
+constexpr auto SHIFT_LONG  = algo::crc::MakeShiftTables<algo::crc::POLY_CRC32C, LONG_LEN>();
+constexpr auto SHIFT_SHORT = algo::crc::MakeShiftTables<algo::crc::POLY_CRC32C, SHORT_LEN>();
+
+
+inline uint64_t
+Load64(uint8_t const* p)
+{
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+
+template <std::size_t LEN>
+__attribute__((target("sse4.2")))
+inline uint64_t
+Interleave3(uint64_t crc0, uint8_t const* p, algo::crc::slice_tables_t<4> const& shift)
+{
+	uint64_t crc1 = 0;
+	uint64_t crc2 = 0;
+	uint8_t const* const end = p + LEN;
+	do
+	{
+		crc0 = _mm_crc32_u64(crc0, Load64(p));
+		crc1 = _mm_crc32_u64(crc1, Load64(p + LEN));
+		crc2 = _mm_crc32_u64(crc2, Load64(p + 2 * LEN));
+		p += 8;
+	}
+	while (p < end);
+	crc0 = algo::crc::Shift(shift, static_cast<uint32_t>(crc0)) ^ crc1;
+	crc0 = algo::crc::Shift(shift, static_cast<uint32_t>(crc0)) ^ crc2;
+	return crc0;
+}
+
+
+__attribute__((target("sse4.2")))
+uint32_t
+UpdateSse42(uint32_t crc32, uint8_t const* data, std::size_t len)
+{
+	uint64_t crc = crc32;
+
+	// Align the data to 8 bytes boundary
+	while (len != 0 and (reinterpret_cast<uintptr_t>(data) & 7) != 0)
+	{
+		crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *data++);
+		--len;
+	}
+	while (len >= 3 * LONG_LEN)
+	{
+		crc   = Interleave3<LONG_LEN>(crc, data, SHIFT_LONG);
+		data += 3 * LONG_LEN;
+		len  -= 3 * LONG_LEN;
+	}
+	while (len >= 3 * SHORT_LEN)
+	{
+		crc   = Interleave3<SHORT_LEN>(crc, data, SHIFT_SHORT);
+		data += 3 * SHORT_LEN;
+		len  -= 3 * SHORT_LEN;
+	}
+	while (len >= 8)
+	{
+		crc   = _mm_crc32_u64(crc, Load64(data));
+		data += 8;
+		len  -= 8;
+	}
+	while (len != 0)
+	{
+		crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *data++);
+		--len;
+	}
+	return static_cast<uint32_t>(crc);
+}
+
+#endif // __x86_64__
+
+
+algo::HasherCrc32c::update_fn_t
+SelectUpdate()
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::SSE42))
+	{
+		return &UpdateSse42;
+	}
+#endif
+	return &UpdatePortable;
+}
+
+} // namespace
+
+
+
+namespace algo {
+
+HasherCrc32c::HasherCrc32c()
+	: m_update(SelectUpdate())
+{
+	Init(InitCrc32cHashStrategy{});
+}
+
+
+
+int
+HasherCrc32c::Init(InitHashStrategy const&)
+{
+	m_was_finished = false;
+	m_crc = 0xFFFFFFFF;
+	return 0;
+}
+
+
+
+int
+HasherCrc32c::Update(uint8_t const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherCrc32c::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	m_crc = m_update(m_crc, input, inputLen);
+	return 0;
+}
+
+
+
+int
+HasherCrc32c::UpdateFill(uint8_t ch, std::uint64_t count)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherCrc32c::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	m_crc = crc::AppendRun<crc::POLY_CRC32C>(m_crc, CRC32C_TABLES[0][ch], count);
+	return 0;
+}
+
+
+
+int
+HasherCrc32c::Finish(uint8_t* buffer)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherCrc32c::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	crc::StoreBe32(buffer, ~m_crc);
+
+	m_was_finished = true;
+	return 0;
+}
+
+
+std::size_t
+HasherCrc32c::ResultSize() const
+{
+	return 4; //32 bits
+}
+
+
+
+char const*
+HasherCrc32c::KernelName() const
+{
+	return (m_update == &UpdatePortable) ? "portable" : "sse4.2";
+}
+
+
+
+int
+HasherCrc32c::CombineParts(uint8_t const* parts, std::size_t count,
+                           std::uint64_t part_size, std::uint64_t last_part_size,
+                           uint8_t* result)
+{
+	if (count == 0) { return -1; }
+	crc::CombineParts<crc::POLY_CRC32C>(parts, count, part_size, last_part_size, result);
+	return 0;
+}
+
+} // namespace algo
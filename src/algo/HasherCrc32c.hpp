@@ -0,0 +1,53 @@
+#pragma once
+
+
+#include "IHasher.hpp"
+
+
+
+namespace algo {
+
+class InitCrc32cHashStrategy : public InitHashStrategy
+{
+public:
+	InitCrc32cHashStrategy()
+		: InitHashStrategy(hash_type_e::CRC32C)
+	{}
+
+private:
+};
+
+
+
+// CRC32C (Castagnoli, iSCSI/ext4/Btrfs checksum). The digest is stored in
+// big-endian order, i.e. as it is usually printed.
+class HasherCrc32c final : public IHasher
+{
+public:
+	using update_fn_t = uint32_t (*)(uint32_t crc, uint8_t const*, std::size_t);
+
+	HasherCrc32c(HasherCrc32c&&)                 = delete;
+	HasherCrc32c(HasherCrc32c const&)            = delete;
+	HasherCrc32c& operator=(HasherCrc32c&&)      = delete;
+	HasherCrc32c& operator=(HasherCrc32c const&) = delete;
+
+	HasherCrc32c();
+	~HasherCrc32c() = default;
+
+	// IHasher
+	int Init(InitHashStrategy const&) override;
+	int Update(uint8_t const*, std::size_t) override;
+	int UpdateFill(uint8_t, std::uint64_t) override;
+	int Finish(uint8_t*) override;
+	std::size_t ResultSize() const override;
+	char const* KernelName() const override;
+	bool IsSplittable() const override { return true; }
+	int CombineParts(uint8_t const*, std::size_t, std::uint64_t, std::uint64_t, uint8_t*) override;
+
+private:
+	update_fn_t m_update;
+	uint32_t    m_crc          = 0;
+	bool        m_was_finished = false;
+};
+
+} // namespace algo
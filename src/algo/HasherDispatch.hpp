@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common/Logger.hpp"
+
+#include "IHasher.hpp"
+#include "HasherMd5.hpp"
+#include "HasherCrc32.hpp"
+#include "HasherCrc32c.hpp"
+#include "HasherXxh3.hpp"
+#include "HasherBlake3.hpp"
+#include "HasherSha256.hpp"
+
+
+
+namespace algo {
+
+// Calls `fn(hasher)` with `hasher` cast to the concrete (final) class of the
+// `type` algorithm. `fn` is instantiated once per algorithm, so the hot loops
+// written as a generic lambda call the hasher directly instead of through
+// the IHasher vtable. `hasher` MUST BE created by HasherFactory::Create for
+// the same `type`.
+template <typename Fn>
+decltype(auto)
+DispatchHasher(hash_type_e type, IHasher& hasher, Fn&& fn)
+{
+	switch (type)
+	{
+	case hash_type_e::MD5:     return fn(static_cast<HasherMd5&>(hasher));
+	case hash_type_e::CRC32:   return fn(static_cast<HasherCrc32&>(hasher));
+	case hash_type_e::CRC32C:  return fn(static_cast<HasherCrc32c&>(hasher));
+	case hash_type_e::XXH3:
+	case hash_type_e::XXH128:  return fn(static_cast<HasherXxh3&>(hasher));
+	case hash_type_e::BLAKE3:  return fn(static_cast<HasherBlake3&>(hasher));
+	case hash_type_e::SHA256:  return fn(static_cast<HasherSha256&>(hasher));
+
+	case hash_type_e::UNKNOWN:
+		break;
+	}
+	THROW_ERROR("%s: Select UNKNOWN hasher", __FUNCTION__);
+}
+
+} // namespace algo
@@ -1,10 +1,23 @@
 #include "HasherFactory.hpp"
 
+#include <algorithm>
+#include <iterator>
+
+#include <cstring>
+
 #include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
 
 #include "IHasher.hpp"
+#include "IMultiHasher.hpp"
 #include "HasherMd5.hpp"
+#include "HasherMd5Mb.hpp"
 #include "HasherCrc32.hpp"
+#include "HasherCrc32c.hpp"
+#include "HasherXxh3.hpp"
+#include "HasherBlake3.hpp"
+#include "HasherSha256.hpp"
+#include "HasherSha256Mb.hpp"
 
 
 
@@ -16,6 +29,11 @@ toString(algo::hash_type_e v)
 	case algo::hash_type_e::UNKNOWN: return "UNKNOWN";
 	case algo::hash_type_e::MD5:     return "MD5";
 	case algo::hash_type_e::CRC32:   return "CRC32";
+	case algo::hash_type_e::CRC32C:  return "CRC32C";
+	case algo::hash_type_e::XXH3:    return "XXH3";
+	case algo::hash_type_e::XXH128:  return "XXH128";
+	case algo::hash_type_e::BLAKE3:  return "BLAKE3";
+	case algo::hash_type_e::SHA256:  return "SHA256";
 	}
 	return "?";
 }
@@ -23,6 +41,198 @@ toString(algo::hash_type_e v)
 
 namespace algo {
 
+namespace {
+
+//NOTE: the implementations of each algorithm are ordered from the fastest one
+HasherImpl const g_impls[] =
+{
+	{ hash_type_e::MD5,    "avx512-mb", "avx512",   CpuFeatures::AVX512F,  true  },
+	{ hash_type_e::MD5,    "avx2-mb",   "avx2",     CpuFeatures::AVX2,     true  },
+	{ hash_type_e::MD5,    "sse2-mb",   "sse2",     CpuFeatures::SSE2,     true  },
+	{ hash_type_e::MD5,    "portable",  "portable", CpuFeatures::NONE,     false },
+
+	{ hash_type_e::CRC32,  "pclmul",    "pclmul",   CpuFeatures::PCLMUL | CpuFeatures::SSE41, false },
+	{ hash_type_e::CRC32,  "portable",  "portable", CpuFeatures::NONE,     false },
+
+	{ hash_type_e::CRC32C, "sse4.2",    "sse4.2",   CpuFeatures::SSE42,    false },
+	{ hash_type_e::CRC32C, "portable",  "portable", CpuFeatures::NONE,     false },
+
+	{ hash_type_e::XXH3,   "avx2",      "avx2",     CpuFeatures::AVX2,     false },
+	{ hash_type_e::XXH3,   "sse2",      "sse2",     CpuFeatures::SSE2,     false },
+	{ hash_type_e::XXH3,   "portable",  "portable", CpuFeatures::NONE,     false },
+
+	{ hash_type_e::XXH128, "avx2",      "avx2",     CpuFeatures::AVX2,     false },
+	{ hash_type_e::XXH128, "sse2",      "sse2",     CpuFeatures::SSE2,     false },
+	{ hash_type_e::XXH128, "portable",  "portable", CpuFeatures::NONE,     false },
+
+	{ hash_type_e::BLAKE3, "avx512",    "avx512",   CpuFeatures::AVX512F,  false },
+	{ hash_type_e::BLAKE3, "avx2",      "avx2",     CpuFeatures::AVX2,     false },
+	{ hash_type_e::BLAKE3, "sse4.1",    "sse4.1",   CpuFeatures::SSE41,    false },
+	{ hash_type_e::BLAKE3, "portable",  "portable", CpuFeatures::NONE,     false },
+
+	//NOTE: a single SHA-NI stream is faster than the SIMD lanes
+	{ hash_type_e::SHA256, "sha-ni",    "sha-ni",   CpuFeatures::SHA | CpuFeatures::SSE41 | CpuFeatures::SSSE3, false },
+	{ hash_type_e::SHA256, "avx512-mb", "avx512",   CpuFeatures::AVX512F,  true  },
+	{ hash_type_e::SHA256, "avx2-mb",   "avx2",     CpuFeatures::AVX2,     true  },
+	{ hash_type_e::SHA256, "portable",  "portable", CpuFeatures::NONE,     false },
+};
+
+
+// The known-answer messages are "", "abc" and KAT_LONG_SIZE bytes of
+// a pattern. The long one covers several BLAKE3 chunks per lane of the widest
+// kernel and it is passed by the pieces which are not aligned to the blocks.
+constexpr std::size_t KAT_MESSAGES    = 3;
+constexpr std::size_t KAT_LONG_SIZE   = 17413;
+constexpr std::size_t KAT_UPDATE_SIZE = 1000;
+// HashBatch is checked by a batch of the long messages: the widest lanes and
+// the rest hashed one by one
+constexpr std::size_t KAT_BATCH_SIZE  = 17;
+
+struct KnownAnswers
+{
+	hash_type_e type;
+	char const* digests[KAT_MESSAGES]; // hex
+};
+
+KnownAnswers const g_known_answers[] =
+{
+	{ hash_type_e::MD5, {
+		"d41d8cd98f00b204e9800998ecf8427e",
+		"900150983cd24fb0d6963f7d28e17f72",
+		"345bc6737e91572063ae46463c73d68c",
+	}},
+	{ hash_type_e::CRC32, {
+		"00000000",
+		"352441c2",
+		"dcec61d8",
+	}},
+	{ hash_type_e::CRC32C, {
+		"00000000",
+		"364b3fb7",
+		"03e596f6",
+	}},
+	{ hash_type_e::XXH3, {
+		"2d06800538d394c2",
+		"78af5f94892f3950",
+		"8eb023d3b3106d8f",
+	}},
+	{ hash_type_e::XXH128, {
+		"99aa06d3014798d86001c324468d497f",
+		"06b05ab6733a618578af5f94892f3950",
+		"4fd0e0a5d8e5a5e48eb023d3b3106d8f",
+	}},
+	{ hash_type_e::BLAKE3, {
+		"af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262",
+		"6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85",
+		"23065c38e511af48f8db1104954da6a15f6758d6c319766b91c04c3fdd8e7a65",
+	}},
+	{ hash_type_e::SHA256, {
+		"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+		"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+		"91765f94a7cdafd733a2f9f675fd28e4e0fa70f7c6a498173d441af34acb2e46",
+	}},
+};
+
+
+std::vector<uint8_t>
+KnownAnswerMessage(std::size_t index)
+{
+	std::vector<uint8_t> message;
+	switch (index)
+	{
+	case 0: break;
+	case 1: message = {'a', 'b', 'c'}; break;
+	default:
+		message.resize(KAT_LONG_SIZE);
+		for (std::size_t i = 0; i < message.size(); ++i)
+		{
+			message[i] = static_cast<uint8_t>(i * 131 + (i >> 9));
+		}
+	}
+	return message;
+}
+
+
+bool
+IsDigest(uint8_t const* digest, std::size_t size, char const* hex)
+{
+	constexpr char HEX_DIGITS[] = "0123456789abcdef";
+	if (std::strlen(hex) != 2 * size) { return false; }
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		if (   hex[2*i]     != HEX_DIGITS[digest[i] >> 4]
+		    or hex[2*i + 1] != HEX_DIGITS[digest[i] & 0x0F])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+HashKnownAnswers(IHasher& hasher, InitHashStrategy const& strategy, KnownAnswers const& answers)
+{
+	std::vector<uint8_t> digest(hasher.ResultSize());
+	for (std::size_t i = 0; i < KAT_MESSAGES; ++i)
+	{
+		std::vector<uint8_t> const message = KnownAnswerMessage(i);
+		hasher.Init(strategy);
+		for (std::size_t off = 0; off < message.size(); off += KAT_UPDATE_SIZE)
+		{
+			hasher.Update(message.data() + off, std::min(KAT_UPDATE_SIZE, message.size() - off));
+		}
+		hasher.Finish(digest.data());
+		if (not IsDigest(digest.data(), digest.size(), answers.digests[i])) { return false; }
+	}
+
+	std::vector<uint8_t> const message = KnownAnswerMessage(KAT_MESSAGES - 1);
+	std::vector<uint8_t> digests(KAT_BATCH_SIZE * digest.size());
+	std::vector<uint8_t const*> inputs(KAT_BATCH_SIZE, message.data());
+	std::vector<uint8_t*> results;
+	for (std::size_t i = 0; i < KAT_BATCH_SIZE; ++i) { results.push_back(digests.data() + i * digest.size()); }
+	hasher.HashBatch(strategy, inputs.data(), message.size(), results.data(), results.size());
+	for (uint8_t const* result : results)
+	{
+		if (not IsDigest(result, digest.size(), answers.digests[KAT_MESSAGES - 1])) { return false; }
+	}
+	return true;
+}
+
+
+//NOTE: all lanes hash the same message
+bool
+HashKnownAnswers(IMultiHasher& hasher, InitHashStrategy const& strategy, KnownAnswers const& answers)
+{
+	std::size_t const lanes = hasher.Lanes();
+	std::size_t const digest_size = hasher.ResultSize();
+	std::vector<uint8_t> digests(lanes * digest_size);
+	std::vector<uint8_t*> lanes_result(lanes);
+	std::vector<uint8_t const*> lanes_data(lanes);
+	for (std::size_t l = 0; l < lanes; ++l) { lanes_result[l] = digests.data() + l * digest_size; }
+
+	for (std::size_t i = 0; i < KAT_MESSAGES; ++i)
+	{
+		std::vector<uint8_t> const message = KnownAnswerMessage(i);
+		hasher.Init(strategy);
+		for (std::size_t off = 0; off < message.size(); off += KAT_UPDATE_SIZE)
+		{
+			std::fill(lanes_data.begin(), lanes_data.end(), message.data() + off);
+			hasher.Update(lanes_data.data(), std::min(KAT_UPDATE_SIZE, message.size() - off));
+		}
+		hasher.Finish(lanes_result.data());
+		for (uint8_t const* digest : lanes_result)
+		{
+			if (not IsDigest(digest, digest_size, answers.digests[i])) { return false; }
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+
+
 // static
 HasherFactory::hasher_t
 HasherFactory::Create(InitHashStrategy const& strategy)
@@ -32,6 +242,11 @@ HasherFactory::Create(InitHashStrategy const& strategy)
 	{
 	case hash_type_e::MD5:            hasher.reset(new HasherMd5); break;
 	case hash_type_e::CRC32:          hasher.reset(new HasherCrc32); break;
+	case hash_type_e::CRC32C:         hasher.reset(new HasherCrc32c); break;
+	case hash_type_e::XXH3:           hasher.reset(new HasherXxh3(hash_type_e::XXH3)); break;
+	case hash_type_e::XXH128:         hasher.reset(new HasherXxh3(hash_type_e::XXH128)); break;
+	case hash_type_e::BLAKE3:         hasher.reset(new HasherBlake3); break;
+	case hash_type_e::SHA256:         hasher.reset(new HasherSha256); break;
 
 	case hash_type_e::UNKNOWN:
 		THROW_ERROR("%s: Select UNKNOWN hasher", __FUNCTION__);
@@ -39,5 +254,152 @@ HasherFactory::Create(InitHashStrategy const& strategy)
 	return hasher;
 }
 
-} // namespace algo
 
+
+// static
+HasherFactory::multi_hasher_t
+HasherFactory::CreateMulti(InitHashStrategy const& strategy)
+{
+	multi_hasher_t hasher;
+	switch (strategy.GetType())
+	{
+	case hash_type_e::MD5:
+		if (HasherMd5Mb::SupportedLanes() > 1) { hasher.reset(new HasherMd5Mb); }
+		break;
+
+	case hash_type_e::SHA256:
+		//NOTE: a single SHA-NI stream is faster than the SIMD lanes
+		if (not HasherSha256::HasShaNi() and HasherSha256Mb::SupportedLanes() > 1)
+		{
+			hasher.reset(new HasherSha256Mb);
+		}
+		break;
+
+	case hash_type_e::CRC32:
+	case hash_type_e::CRC32C:
+	case hash_type_e::XXH3:
+	case hash_type_e::XXH128:
+	case hash_type_e::BLAKE3:
+		break;
+
+	case hash_type_e::UNKNOWN:
+		THROW_ERROR("%s: Select UNKNOWN hasher", __FUNCTION__);
+	}
+	return hasher;
+}
+
+
+
+
+// static
+HasherFactory::impls_t
+HasherFactory::Implementations(hash_type_e type)
+{
+	impls_t impls;
+	for (HasherImpl const& impl : g_impls)
+	{
+		if (impl.type == type) { impls.push_back(&impl); }
+	}
+	return impls;
+}
+
+
+
+// static
+bool
+HasherFactory::IsSupported(HasherImpl const& impl) noexcept
+{
+	return (CpuFeatures::Detected() & impl.features) == impl.features;
+}
+
+
+
+//NOTE: it changes the CPU features visible to the hashers for a while, so it
+// must not be called while other threads create hashers
+// static
+bool
+HasherFactory::SelfTest(HasherImpl const& impl)
+{
+	auto const answers = std::find_if(std::begin(g_known_answers), std::end(g_known_answers),
+		[&impl](KnownAnswers const& a) { return a.type == impl.type; });
+	if (answers == std::end(g_known_answers) or not IsSupported(impl)) { return false; }
+
+	uint32_t const visible_features = CpuFeatures::Get();
+	CpuFeatures::Restrict(impl.features);
+
+	InitHashStrategy const strategy(impl.type);
+	hasher_t const hasher = Create(strategy);
+	multi_hasher_t const multi_hasher = CreateMulti(strategy);
+	bool passed = HashKnownAnswers(*hasher, strategy, *answers);
+	if (impl.multi)
+	{
+		passed = passed
+			and multi_hasher
+			and std::strcmp(multi_hasher->KernelName(), impl.kernel) == 0
+			and HashKnownAnswers(*multi_hasher, strategy, *answers);
+	}
+	else
+	{
+		passed = passed
+			and not multi_hasher
+			and std::strcmp(hasher->KernelName(), impl.kernel) == 0;
+	}
+
+	CpuFeatures::Restrict(visible_features);
+	return passed;
+}
+
+
+
+// static
+HasherImpl const&
+HasherFactory::SelectImpl(hash_type_e type, std::string_view name)
+{
+	impls_t const impls = Implementations(type);
+	HasherImpl const* selected = nullptr;
+	if (name.empty())
+	{
+		for (HasherImpl const* impl : impls)
+		{
+			if (not IsSupported(*impl)) { continue; }
+			if (SelfTest(*impl))
+			{
+				selected = impl;
+				break;
+			}
+			LOG_W("%s: the implementation [%s] of %s failed the self-test",
+			      __FUNCTION__, impl->name, ::toString(type));
+		}
+		if (not selected)
+		{
+			THROW_ERROR("%s: no implementation of %s passed the self-test",
+			            __FUNCTION__, ::toString(type));
+		}
+	}
+	else
+	{
+		auto const it = std::find_if(impls.begin(), impls.end(),
+			[name](HasherImpl const* impl) { return name == impl->name; });
+		if (it == impls.end())
+		{
+			THROW_ERROR("%s: unknown implementation [%.*s] of %s",
+			            __FUNCTION__, LOG_SV(name), ::toString(type));
+		}
+		selected = *it;
+		if (not IsSupported(*selected))
+		{
+			THROW_ERROR("%s: the implementation [%s] of %s is not supported by the CPU",
+			            __FUNCTION__, selected->name, ::toString(type));
+		}
+		if (not SelfTest(*selected))
+		{
+			THROW_ERROR("%s: the implementation [%s] of %s failed the self-test",
+			            __FUNCTION__, selected->name, ::toString(type));
+		}
+	}
+
+	CpuFeatures::Restrict(selected->features);
+	return *selected;
+}
+
+} // namespace algo
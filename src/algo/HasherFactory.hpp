@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include <cstdint>
 
@@ -9,6 +11,7 @@
 namespace algo {
 
 struct IHasher;
+struct IMultiHasher;
 
 
 
@@ -17,6 +20,11 @@ enum class hash_type_e
 	UNKNOWN,
 	MD5,
 	CRC32,
+	CRC32C,
+	XXH3,
+	XXH128,
+	BLAKE3,
+	SHA256,
 };
 
 
@@ -37,10 +45,42 @@ private:
 
 
 
+// An implementation of the algorithm: the kernel which is selected by
+// the hashers when only the `features` of the CPU are visible to them.
+struct HasherImpl
+{
+	hash_type_e type;
+	char const* name;     // the value of the `sign_impl` option
+	char const* kernel;   // KernelName() of the hasher
+	uint32_t    features; // CpuFeatures required by the kernel
+	bool        multi;    // the blocks are hashed by IMultiHasher
+};
+
+
+
 struct HasherFactory
 {
-	using hasher_t = std::unique_ptr<IHasher>;
+	using hasher_t       = std::unique_ptr<IHasher>;
+	using multi_hasher_t = std::unique_ptr<IMultiHasher>;
+	using impls_t        = std::vector<HasherImpl const*>;
+
 	static hasher_t Create(InitHashStrategy const&);
+
+	// Returns nullptr if there is no multi-buffer implementation of
+	// the algorithm for the current CPU.
+	static multi_hasher_t CreateMulti(InitHashStrategy const&);
+
+	// Returns all implementations of the algorithm from the fastest one
+	static impls_t Implementations(hash_type_e);
+	static bool IsSupported(HasherImpl const&) noexcept;
+	// Hashes the known-answer vectors by the implementation and checks that
+	// the hashers select its kernel
+	static bool SelfTest(HasherImpl const&);
+	// Selects the implementation `name` or (if it is empty) the fastest one
+	// which is supported by the CPU and passes the self-test. The hashers
+	// created since then use the kernel of the selected implementation.
+	//NOTE: throws if `name` is unknown, unsupported or fails the self-test
+	static HasherImpl const& SelectImpl(hash_type_e, std::string_view name = {});
 };
 
 } // namespace algo
@@ -1,6 +1,8 @@
 #include "HasherMd5.hpp"
 
 #include <array>
+#include <algorithm>
+#include <iterator>
 
 #include <cstring>
 
@@ -30,18 +32,14 @@ namespace {
 #define S43 15
 #define S44 21
 
-uint8_t PADDING[64] = {
-  0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
-
-/* F, G, H and I are basic MD5 functions.
+/* F, G, H and I are basic MD5 functions. F and G are written in the forms
+   with fewer dependent operations: the terms of G have no common bits, so
+   the compiler can add (c & ~d) to `a` before `b` is computed.
  */
-#define F(x, y, z) (((x) & (y)) | ((~x) & (z)))
-#define G(x, y, z) (((x) & (z)) | ((y) & (~z)))
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) (((x) & (z)) + ((y) & ~(z)))
 #define H(x, y, z) ((x) ^ (y) ^ (z))
-#define I(x, y, z) ((y) ^ ((x) | (~z)))
+#define I(x, y, z) ((y) ^ ((x) | ~(z)))
 
 /* ROTATE_LEFT rotates x left n bits.
  */
@@ -77,126 +75,224 @@ uint8_t PADDING[64] = {
 
 
 
-/* Encodes input into output. Assumes len is a multiple of 4. */
+inline uint32_t
+Load32(uint8_t const* p) noexcept
+{
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	return v;
+#else
+	return __builtin_bswap32(v);
+#endif
+}
+
+
+inline void
+Store32(uint8_t* p, uint32_t v) noexcept
+{
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	std::memcpy(p, &v, sizeof(v));
+}
+
+
+inline void
+Store64(uint8_t* p, uint64_t v) noexcept
+{
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	std::memcpy(p, &v, sizeof(v));
+}
+
+
+
+/* Zeroizes the memory, the stores are not removed by the optimizer. */
 void
-Encode(uint8_t* output, uint32_t const* input, uint32_t len)
+SecureWipe(void* p, std::size_t size) noexcept
 {
-	for (uint32_t i = 0, j = 0; j < len; i++, j += 4) {
-		output[j]   = static_cast<uint8_t>(input[i] & 0xff);
-		output[j+1] = static_cast<uint8_t>((input[i] >>  8) & 0xff);
-		output[j+2] = static_cast<uint8_t>((input[i] >> 16) & 0xff);
-		output[j+3] = static_cast<uint8_t>((input[i] >> 24) & 0xff);
-	}
+	auto* v = static_cast<uint8_t volatile*>(p);
+	while (size--) { *v++ = 0; }
 }
 
 
 
-/* Decodes input into output. Assumes len is a multiple of 4. */
+/* MD5 basic transformation of `blocks` consecutive blocks. The state stays
+   in the registers and the words are loaded from the input directly. */
 void
-Decode(uint32_t* output, uint8_t const* input, uint32_t len)
+MD5Transform(uint32_t state[4], uint8_t const* input, std::size_t blocks)
 {
-	for (uint32_t i = 0, j = 0; j < len; i++, j += 4)
+	uint32_t a = state[0],
+	         b = state[1],
+	         c = state[2],
+	         d = state[3];
+
+#define X(i) Load32(input + 4 * (i))
+	for (; blocks != 0; --blocks, input += 64)
 	{
-		output[i]  = static_cast<uint32_t>(input[j]);
-		output[i] |= static_cast<uint32_t>(input[j+1]) <<  8;
-		output[i] |= static_cast<uint32_t>(input[j+2]) << 16;
-		output[i] |= static_cast<uint32_t>(input[j+3]) << 24;
+		uint32_t const aa = a, bb = b, cc = c, dd = d;
+
+		/* Round 1 */
+		FF (a, b, c, d, X( 0), S11, 0xd76aa478); /* 1 */
+		FF (d, a, b, c, X( 1), S12, 0xe8c7b756); /* 2 */
+		FF (c, d, a, b, X( 2), S13, 0x242070db); /* 3 */
+		FF (b, c, d, a, X( 3), S14, 0xc1bdceee); /* 4 */
+		FF (a, b, c, d, X( 4), S11, 0xf57c0faf); /* 5 */
+		FF (d, a, b, c, X( 5), S12, 0x4787c62a); /* 6 */
+		FF (c, d, a, b, X( 6), S13, 0xa8304613); /* 7 */
+		FF (b, c, d, a, X( 7), S14, 0xfd469501); /* 8 */
+		FF (a, b, c, d, X( 8), S11, 0x698098d8); /* 9 */
+		FF (d, a, b, c, X( 9), S12, 0x8b44f7af); /* 10 */
+		FF (c, d, a, b, X(10), S13, 0xffff5bb1); /* 11 */
+		FF (b, c, d, a, X(11), S14, 0x895cd7be); /* 12 */
+		FF (a, b, c, d, X(12), S11, 0x6b901122); /* 13 */
+		FF (d, a, b, c, X(13), S12, 0xfd987193); /* 14 */
+		FF (c, d, a, b, X(14), S13, 0xa679438e); /* 15 */
+		FF (b, c, d, a, X(15), S14, 0x49b40821); /* 16 */
+
+		/* Round 2 */
+		GG (a, b, c, d, X( 1), S21, 0xf61e2562); /* 17 */
+		GG (d, a, b, c, X( 6), S22, 0xc040b340); /* 18 */
+		GG (c, d, a, b, X(11), S23, 0x265e5a51); /* 19 */
+		GG (b, c, d, a, X( 0), S24, 0xe9b6c7aa); /* 20 */
+		GG (a, b, c, d, X( 5), S21, 0xd62f105d); /* 21 */
+		GG (d, a, b, c, X(10), S22,  0x2441453); /* 22 */
+		GG (c, d, a, b, X(15), S23, 0xd8a1e681); /* 23 */
+		GG (b, c, d, a, X( 4), S24, 0xe7d3fbc8); /* 24 */
+		GG (a, b, c, d, X( 9), S21, 0x21e1cde6); /* 25 */
+		GG (d, a, b, c, X(14), S22, 0xc33707d6); /* 26 */
+		GG (c, d, a, b, X( 3), S23, 0xf4d50d87); /* 27 */
+		GG (b, c, d, a, X( 8), S24, 0x455a14ed); /* 28 */
+		GG (a, b, c, d, X(13), S21, 0xa9e3e905); /* 29 */
+		GG (d, a, b, c, X( 2), S22, 0xfcefa3f8); /* 30 */
+		GG (c, d, a, b, X( 7), S23, 0x676f02d9); /* 31 */
+		GG (b, c, d, a, X(12), S24, 0x8d2a4c8a); /* 32 */
+
+		/* Round 3 */
+		HH (a, b, c, d, X( 5), S31, 0xfffa3942); /* 33 */
+		HH (d, a, b, c, X( 8), S32, 0x8771f681); /* 34 */
+		HH (c, d, a, b, X(11), S33, 0x6d9d6122); /* 35 */
+		HH (b, c, d, a, X(14), S34, 0xfde5380c); /* 36 */
+		HH (a, b, c, d, X( 1), S31, 0xa4beea44); /* 37 */
+		HH (d, a, b, c, X( 4), S32, 0x4bdecfa9); /* 38 */
+		HH (c, d, a, b, X( 7), S33, 0xf6bb4b60); /* 39 */
+		HH (b, c, d, a, X(10), S34, 0xbebfbc70); /* 40 */
+		HH (a, b, c, d, X(13), S31, 0x289b7ec6); /* 41 */
+		HH (d, a, b, c, X( 0), S32, 0xeaa127fa); /* 42 */
+		HH (c, d, a, b, X( 3), S33, 0xd4ef3085); /* 43 */
+		HH (b, c, d, a, X( 6), S34,  0x4881d05); /* 44 */
+		HH (a, b, c, d, X( 9), S31, 0xd9d4d039); /* 45 */
+		HH (d, a, b, c, X(12), S32, 0xe6db99e5); /* 46 */
+		HH (c, d, a, b, X(15), S33, 0x1fa27cf8); /* 47 */
+		HH (b, c, d, a, X( 2), S34, 0xc4ac5665); /* 48 */
+
+		/* Round 4 */
+		II (a, b, c, d, X( 0), S41, 0xf4292244); /* 49 */
+		II (d, a, b, c, X( 7), S42, 0x432aff97); /* 50 */
+		II (c, d, a, b, X(14), S43, 0xab9423a7); /* 51 */
+		II (b, c, d, a, X( 5), S44, 0xfc93a039); /* 52 */
+		II (a, b, c, d, X(12), S41, 0x655b59c3); /* 53 */
+		II (d, a, b, c, X( 3), S42, 0x8f0ccc92); /* 54 */
+		II (c, d, a, b, X(10), S43, 0xffeff47d); /* 55 */
+		II (b, c, d, a, X( 1), S44, 0x85845dd1); /* 56 */
+		II (a, b, c, d, X( 8), S41, 0x6fa87e4f); /* 57 */
+		II (d, a, b, c, X(15), S42, 0xfe2ce6e0); /* 58 */
+		II (c, d, a, b, X( 6), S43, 0xa3014314); /* 59 */
+		II (b, c, d, a, X(13), S44, 0x4e0811a1); /* 60 */
+		II (a, b, c, d, X( 4), S41, 0xf7537e82); /* 61 */
+		II (d, a, b, c, X(11), S42, 0xbd3af235); /* 62 */
+		II (c, d, a, b, X( 2), S43, 0x2ad7d2bb); /* 63 */
+		II (b, c, d, a, X( 9), S44, 0xeb86d391); /* 64 */
+
+		a += aa;
+		b += bb;
+		c += cc;
+		d += dd;
 	}
+#undef X
+
+	state[0] = a;
+	state[1] = b;
+	state[2] = c;
+	state[3] = d;
 }
 
 
 
-/* MD5 basic transformation. Transforms state based on block. */
+/* The additive constants of the MD5 steps 1..64 (see MD5Transform) */
+constexpr uint32_t MD5_K[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+
+
+/* MD5 transformation of `blocks` blocks of the same byte `ch`. All words of
+   such block are equal, so the sums of a word and the additive constants
+   are computed once for all blocks. */
 void
-MD5Transform(uint32_t state[4], uint8_t const block[64])
+MD5TransformFill(uint32_t state[4], uint8_t ch, uint64_t blocks)
 {
-	std::array<uint32_t, 16> x;
+	uint32_t const x = 0x01010101u * ch;
+	std::array<uint32_t, 64> xk;
+	for (std::size_t i = 0; i < xk.size(); ++i)
+	{
+		xk[i] = x + MD5_K[i];
+	}
 
 	uint32_t a = state[0],
 	         b = state[1],
 	         c = state[2],
 	         d = state[3];
-	Decode(x.data(), block, 64);
-
-	/* Round 1 */
-	FF (a, b, c, d, x[ 0], S11, 0xd76aa478); /* 1 */
-	FF (d, a, b, c, x[ 1], S12, 0xe8c7b756); /* 2 */
-	FF (c, d, a, b, x[ 2], S13, 0x242070db); /* 3 */
-	FF (b, c, d, a, x[ 3], S14, 0xc1bdceee); /* 4 */
-	FF (a, b, c, d, x[ 4], S11, 0xf57c0faf); /* 5 */
-	FF (d, a, b, c, x[ 5], S12, 0x4787c62a); /* 6 */
-	FF (c, d, a, b, x[ 6], S13, 0xa8304613); /* 7 */
-	FF (b, c, d, a, x[ 7], S14, 0xfd469501); /* 8 */
-	FF (a, b, c, d, x[ 8], S11, 0x698098d8); /* 9 */
-	FF (d, a, b, c, x[ 9], S12, 0x8b44f7af); /* 10 */
-	FF (c, d, a, b, x[10], S13, 0xffff5bb1); /* 11 */
-	FF (b, c, d, a, x[11], S14, 0x895cd7be); /* 12 */
-	FF (a, b, c, d, x[12], S11, 0x6b901122); /* 13 */
-	FF (d, a, b, c, x[13], S12, 0xfd987193); /* 14 */
-	FF (c, d, a, b, x[14], S13, 0xa679438e); /* 15 */
-	FF (b, c, d, a, x[15], S14, 0x49b40821); /* 16 */
-
-	/* Round 2 */
-	GG (a, b, c, d, x[ 1], S21, 0xf61e2562); /* 17 */
-	GG (d, a, b, c, x[ 6], S22, 0xc040b340); /* 18 */
-	GG (c, d, a, b, x[11], S23, 0x265e5a51); /* 19 */
-	GG (b, c, d, a, x[ 0], S24, 0xe9b6c7aa); /* 20 */
-	GG (a, b, c, d, x[ 5], S21, 0xd62f105d); /* 21 */
-	GG (d, a, b, c, x[10], S22,  0x2441453); /* 22 */
-	GG (c, d, a, b, x[15], S23, 0xd8a1e681); /* 23 */
-	GG (b, c, d, a, x[ 4], S24, 0xe7d3fbc8); /* 24 */
-	GG (a, b, c, d, x[ 9], S21, 0x21e1cde6); /* 25 */
-	GG (d, a, b, c, x[14], S22, 0xc33707d6); /* 26 */
-	GG (c, d, a, b, x[ 3], S23, 0xf4d50d87); /* 27 */
-	GG (b, c, d, a, x[ 8], S24, 0x455a14ed); /* 28 */
-	GG (a, b, c, d, x[13], S21, 0xa9e3e905); /* 29 */
-	GG (d, a, b, c, x[ 2], S22, 0xfcefa3f8); /* 30 */
-	GG (c, d, a, b, x[ 7], S23, 0x676f02d9); /* 31 */
-	GG (b, c, d, a, x[12], S24, 0x8d2a4c8a); /* 32 */
-
-	/* Round 3 */
-	HH (a, b, c, d, x[ 5], S31, 0xfffa3942); /* 33 */
-	HH (d, a, b, c, x[ 8], S32, 0x8771f681); /* 34 */
-	HH (c, d, a, b, x[11], S33, 0x6d9d6122); /* 35 */
-	HH (b, c, d, a, x[14], S34, 0xfde5380c); /* 36 */
-	HH (a, b, c, d, x[ 1], S31, 0xa4beea44); /* 37 */
-	HH (d, a, b, c, x[ 4], S32, 0x4bdecfa9); /* 38 */
-	HH (c, d, a, b, x[ 7], S33, 0xf6bb4b60); /* 39 */
-	HH (b, c, d, a, x[10], S34, 0xbebfbc70); /* 40 */
-	HH (a, b, c, d, x[13], S31, 0x289b7ec6); /* 41 */
-	HH (d, a, b, c, x[ 0], S32, 0xeaa127fa); /* 42 */
-	HH (c, d, a, b, x[ 3], S33, 0xd4ef3085); /* 43 */
-	HH (b, c, d, a, x[ 6], S34,  0x4881d05); /* 44 */
-	HH (a, b, c, d, x[ 9], S31, 0xd9d4d039); /* 45 */
-	HH (d, a, b, c, x[12], S32, 0xe6db99e5); /* 46 */
-	HH (c, d, a, b, x[15], S33, 0x1fa27cf8); /* 47 */
-	HH (b, c, d, a, x[ 2], S34, 0xc4ac5665); /* 48 */
-
-	/* Round 4 */
-	II (a, b, c, d, x[ 0], S41, 0xf4292244); /* 49 */
-	II (d, a, b, c, x[ 7], S42, 0x432aff97); /* 50 */
-	II (c, d, a, b, x[14], S43, 0xab9423a7); /* 51 */
-	II (b, c, d, a, x[ 5], S44, 0xfc93a039); /* 52 */
-	II (a, b, c, d, x[12], S41, 0x655b59c3); /* 53 */
-	II (d, a, b, c, x[ 3], S42, 0x8f0ccc92); /* 54 */
-	II (c, d, a, b, x[10], S43, 0xffeff47d); /* 55 */
-	II (b, c, d, a, x[ 1], S44, 0x85845dd1); /* 56 */
-	II (a, b, c, d, x[ 8], S41, 0x6fa87e4f); /* 57 */
-	II (d, a, b, c, x[15], S42, 0xfe2ce6e0); /* 58 */
-	II (c, d, a, b, x[ 6], S43, 0xa3014314); /* 59 */
-	II (b, c, d, a, x[13], S44, 0x4e0811a1); /* 60 */
-	II (a, b, c, d, x[ 4], S41, 0xf7537e82); /* 61 */
-	II (d, a, b, c, x[11], S42, 0xbd3af235); /* 62 */
-	II (c, d, a, b, x[ 2], S43, 0x2ad7d2bb); /* 63 */
-	II (b, c, d, a, x[ 9], S44, 0xeb86d391); /* 64 */
-
-	state[0] += a;
-	state[1] += b;
-	state[2] += c;
-	state[3] += d;
-
-	/* Zeroize sensitive information.  */
-	x.fill(0);
+	for (; blocks != 0; --blocks)
+	{
+		uint32_t const aa = a, bb = b, cc = c, dd = d;
+		for (std::size_t i = 0; i < 16; i += 4)
+		{
+			FF (a, b, c, d, xk[i],     S11, 0);
+			FF (d, a, b, c, xk[i + 1], S12, 0);
+			FF (c, d, a, b, xk[i + 2], S13, 0);
+			FF (b, c, d, a, xk[i + 3], S14, 0);
+		}
+		for (std::size_t i = 16; i < 32; i += 4)
+		{
+			GG (a, b, c, d, xk[i],     S21, 0);
+			GG (d, a, b, c, xk[i + 1], S22, 0);
+			GG (c, d, a, b, xk[i + 2], S23, 0);
+			GG (b, c, d, a, xk[i + 3], S24, 0);
+		}
+		for (std::size_t i = 32; i < 48; i += 4)
+		{
+			HH (a, b, c, d, xk[i],     S31, 0);
+			HH (d, a, b, c, xk[i + 1], S32, 0);
+			HH (c, d, a, b, xk[i + 2], S33, 0);
+			HH (b, c, d, a, xk[i + 3], S34, 0);
+		}
+		for (std::size_t i = 48; i < 64; i += 4)
+		{
+			II (a, b, c, d, xk[i],     S41, 0);
+			II (d, a, b, c, xk[i + 1], S42, 0);
+			II (c, d, a, b, xk[i + 2], S43, 0);
+			II (b, c, d, a, xk[i + 3], S44, 0);
+		}
+		a += aa;
+		b += bb;
+		c += cc;
+		d += dd;
+	}
+
+	state[0] = a;
+	state[1] = b;
+	state[2] = c;
+	state[3] = d;
 }
 
 } // namespace
@@ -210,7 +306,7 @@ HasherMd5::Init()
 {
 	m_was_finished = false;
 
-	m_ctx.count[0] = m_ctx.count[1] = 0;
+	m_ctx.count = 0;
 
 	/* Load magic initialization constants. */
 	m_ctx.state[0] = 0x67452301;
@@ -240,40 +336,71 @@ HasherMd5::Update(uint8_t const* input, std::size_t inputLen)
 		            __FUNCTION__);
 	}
 
-	uint32_t i = 0;
-
 	/* Compute number of bytes mod 64 */
-	auto index = static_cast<uint32_t>((m_ctx.count[0] >> 3) & 0x3F);
+	auto const index = static_cast<std::size_t>(m_ctx.count % BLOCK_SIZE);
+	m_ctx.count += inputLen;
 
-	/* Update number of bits */
-	m_ctx.count[0] += static_cast<uint32_t>(inputLen) << 3;
-	if (m_ctx.count[0] < (static_cast<uint32_t>(inputLen) << 3))
+	/* Complete the buffered block */
+	if (index != 0)
 	{
-		++m_ctx.count[1];
-	}
-	m_ctx.count[1] += static_cast<uint32_t>(inputLen) >> 29;
+		std::size_t const partLen = std::min(BLOCK_SIZE - index, inputLen);
+		std::memcpy(&m_ctx.buffer[index], input, partLen);
+		if (index + partLen < BLOCK_SIZE) { return 0; }
 
-	uint32_t partLen = 64 - index;
+		MD5Transform(m_ctx.state, m_ctx.buffer, 1);
+		input    += partLen;
+		inputLen -= partLen;
+	}
 
-	/* Transform as many times as possible. */
-	if (inputLen >= partLen)
+	/* Transform the whole blocks in place */
+	std::size_t const blocks = inputLen / BLOCK_SIZE;
+	if (blocks != 0)
 	{
-		std::memcpy(&m_ctx.buffer[index], input, partLen);
-		MD5Transform(m_ctx.state, m_ctx.buffer);
-		for (i = partLen; i + 63 < inputLen; i += 64)
-		{
-			MD5Transform(m_ctx.state, &input[i]);
-		}
-		index = 0;
+		MD5Transform(m_ctx.state, input, blocks);
+		input    += blocks * BLOCK_SIZE;
+		inputLen -= blocks * BLOCK_SIZE;
 	}
-	/* Buffer remaining input */
-	std::memcpy(&m_ctx.buffer[index], &input[i], inputLen - i);
 
+	/* Buffer remaining input */
+	if (inputLen != 0) { std::memcpy(m_ctx.buffer, input, inputLen); }
 	return 0;
 }
 
 
 
+int
+HasherMd5::UpdateFill(uint8_t ch, std::uint64_t count)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherMd5::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	uint8_t block[BLOCK_SIZE];
+	std::memset(block, ch, sizeof(block));
+
+	/* Complete the buffered block */
+	auto const index = static_cast<std::size_t>(m_ctx.count % BLOCK_SIZE);
+	if (index != 0)
+	{
+		auto const partLen = static_cast<std::size_t>(std::min<std::uint64_t>(BLOCK_SIZE - index, count));
+		Update(block, partLen);
+		count -= partLen;
+	}
+
+	std::uint64_t const blocks = count / BLOCK_SIZE;
+	if (blocks != 0)
+	{
+		MD5TransformFill(m_ctx.state, ch, blocks);
+		m_ctx.count += blocks * BLOCK_SIZE;
+	}
+	return Update(block, static_cast<std::size_t>(count % BLOCK_SIZE));
+}
+
+
+
 std::size_t
 HasherMd5::ResultSize() const
 {
@@ -292,27 +419,45 @@ HasherMd5::Finish(uint8_t* buffer)
 		            __FUNCTION__);
 	}
 
-	std::array<uint8_t, 8> bits;
-
-	/* Save number of bits */
-	Encode(bits.data(), m_ctx.count, bits.size());
+	/* Pad out to 56 mod 64 */
+	auto const index = static_cast<std::size_t>(m_ctx.count % BLOCK_SIZE);
+	m_ctx.buffer[index] = 0x80;
+	std::memset(&m_ctx.buffer[index + 1], 0, BLOCK_SIZE - index - 1);
+	if (index >= BLOCK_SIZE - 8)
+	{
+		MD5Transform(m_ctx.state, m_ctx.buffer, 1);
+		std::memset(m_ctx.buffer, 0, BLOCK_SIZE - 8);
+	}
 
-	/* Pad out to 56 mod 64. */
-	auto index = static_cast<uint32_t>((m_ctx.count[0] >> 3) & 0x3f);
-	uint32_t padLen = (index < 56) ? (56 - index) : (120 - index);
-	Update(PADDING, padLen);
+	/* Append length (before padding) in bits, modulo 2^64 */
+	Store64(&m_ctx.buffer[BLOCK_SIZE - 8], m_ctx.count << 3);
+	MD5Transform(m_ctx.state, m_ctx.buffer, 1);
 
-	/* Append length (before padding) */
-	Update(bits.data(), bits.size());
 	/* Store state in digest */
-	Encode(buffer, m_ctx.state, ResultSize());
+	for (std::size_t i = 0; i < std::size(m_ctx.state); ++i)
+	{
+		Store32(buffer + 4 * i, m_ctx.state[i]);
+	}
 
-	/* Zeroize sensitive information. */
-	std::memset(&m_ctx, 0, sizeof(m_ctx));
+	/* Zeroize sensitive information */
+	if (m_secure) { SecureWipe(&m_ctx, sizeof(m_ctx)); }
 
 	m_was_finished = true;
 	return 0;
 }
 
-} // namespace algo
 
+
+int
+HasherMd5::HashBatch(InitHashStrategy const& s,
+                     uint8_t const* const* inputs, std::size_t size,
+                     uint8_t* const* results, std::size_t count)
+{
+	//NOTE: CreateMulti returns the multi-buffer kernel only if it is selected
+	// for the CPU (see HasherFactory::SelectImpl)
+	if (not m_batchHasher) { m_batchHasher = HasherFactory::CreateMulti(s); }
+	if (not m_batchHasher) { return IHasher::HashBatch(s, inputs, size, results, count); }
+	return HashBatchByLanes(*m_batchHasher, *this, s, inputs, size, results, count);
+}
+
+} // namespace algo
@@ -1,7 +1,10 @@
 #pragma once
 
 
+#include <memory>
+
 #include "IHasher.hpp"
+#include "IMultiHasher.hpp"
 
 
 namespace algo {
@@ -20,7 +23,7 @@ private:
 
 
 // Was taken from https://tools.ietf.org/html/rfc1321
-class HasherMd5 : public IHasher
+class HasherMd5 final : public IHasher
 {
 public:
 	HasherMd5(HasherMd5&&)                  = delete;
@@ -28,29 +31,43 @@ public:
 	HasherMd5& operator= (HasherMd5&&)      = delete;
 	HasherMd5& operator= (HasherMd5 const&) = delete;
 
-	HasherMd5()  { Init(); }
+	// In the secure mode the context is zeroized on Finish (it isn't needed
+	// for the signatures, so it is off by default)
+	explicit HasherMd5(bool secure = false)
+		: m_secure(secure)
+	{
+		Init();
+	}
 	~HasherMd5() = default;
 
 	// IHasher
 	int Init(InitHashStrategy const&) override;
 	int Update(uint8_t const*, std::size_t) override;
+	int UpdateFill(uint8_t, std::uint64_t) override;
 	int Finish(uint8_t*) override;
 	std::size_t ResultSize() const override;
+	int HashBatch(InitHashStrategy const&,
+	              uint8_t const* const*, std::size_t,
+	              uint8_t* const*, std::size_t) override;
 
 private:
+	static constexpr std::size_t BLOCK_SIZE = 64;
+
 	void Init();
 
 private:
 	/* MD5 context. See realisation in RFC1321*/
 	struct Context
 	{
-		uint32_t state[4];      // state (ABCD)
-		uint32_t count[2];      // number of bits, modulo 2^64 (lsb first)
-		uint8_t  buffer[64];    // input buffer
+		uint32_t state[4];           // state (ABCD)
+		uint64_t count;              // number of bytes
+		uint8_t  buffer[BLOCK_SIZE]; // input buffer
 	};
 
-	Context m_ctx;
-	bool    m_was_finished = false;
+	Context    m_ctx;
+	bool const m_secure;
+	bool       m_was_finished = false;
+	std::unique_ptr<IMultiHasher> m_batchHasher; // the lanes of HashBatch
 };
 
 } // namespace algo
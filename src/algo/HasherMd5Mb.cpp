@@ -0,0 +1,461 @@
+#include "HasherMd5Mb.hpp"
+
+#include <algorithm>
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+#include "SimdTranspose.hpp"
+
+
+
+namespace {
+
+#if defined(__x86_64__)
+
+using algo::simd::Transpose4x4;
+using algo::simd::Transpose8x8;
+using algo::simd::Transpose16x16;
+
+// The kernels below share the MD5 round list (see RFC1321 md5c.c) and differ
+// only by the vector type and its operations: V_ADD, V_ROTL, V_SET1 and the
+// F, G, H, I basic functions have to be defined before MD5_MB_ROUNDS is used.
+
+#define MD5_MB_STEP(f, a, b, c, d, x, s, ac) \
+	{ \
+		(a) = V_ADD((a), V_ADD(f((b), (c), (d)), V_ADD((x), V_SET1(ac)))); \
+		(a) = V_ADD(V_ROTL((a), (s)), (b)); \
+	}
+
+#define MD5_MB_ROUNDS(a, b, c, d, x) \
+	/* Round 1 */ \
+	MD5_MB_STEP(V_F, a, b, c, d, x[ 0],  7, 0xd76aa478) \
+	MD5_MB_STEP(V_F, d, a, b, c, x[ 1], 12, 0xe8c7b756) \
+	MD5_MB_STEP(V_F, c, d, a, b, x[ 2], 17, 0x242070db) \
+	MD5_MB_STEP(V_F, b, c, d, a, x[ 3], 22, 0xc1bdceee) \
+	MD5_MB_STEP(V_F, a, b, c, d, x[ 4],  7, 0xf57c0faf) \
+	MD5_MB_STEP(V_F, d, a, b, c, x[ 5], 12, 0x4787c62a) \
+	MD5_MB_STEP(V_F, c, d, a, b, x[ 6], 17, 0xa8304613) \
+	MD5_MB_STEP(V_F, b, c, d, a, x[ 7], 22, 0xfd469501) \
+	MD5_MB_STEP(V_F, a, b, c, d, x[ 8],  7, 0x698098d8) \
+	MD5_MB_STEP(V_F, d, a, b, c, x[ 9], 12, 0x8b44f7af) \
+	MD5_MB_STEP(V_F, c, d, a, b, x[10], 17, 0xffff5bb1) \
+	MD5_MB_STEP(V_F, b, c, d, a, x[11], 22, 0x895cd7be) \
+	MD5_MB_STEP(V_F, a, b, c, d, x[12],  7, 0x6b901122) \
+	MD5_MB_STEP(V_F, d, a, b, c, x[13], 12, 0xfd987193) \
+	MD5_MB_STEP(V_F, c, d, a, b, x[14], 17, 0xa679438e) \
+	MD5_MB_STEP(V_F, b, c, d, a, x[15], 22, 0x49b40821) \
+	/* Round 2 */ \
+	MD5_MB_STEP(V_G, a, b, c, d, x[ 1],  5, 0xf61e2562) \
+	MD5_MB_STEP(V_G, d, a, b, c, x[ 6],  9, 0xc040b340) \
+	MD5_MB_STEP(V_G, c, d, a, b, x[11], 14, 0x265e5a51) \
+	MD5_MB_STEP(V_G, b, c, d, a, x[ 0], 20, 0xe9b6c7aa) \
+	MD5_MB_STEP(V_G, a, b, c, d, x[ 5],  5, 0xd62f105d) \
+	MD5_MB_STEP(V_G, d, a, b, c, x[10],  9, 0x02441453) \
+	MD5_MB_STEP(V_G, c, d, a, b, x[15], 14, 0xd8a1e681) \
+	MD5_MB_STEP(V_G, b, c, d, a, x[ 4], 20, 0xe7d3fbc8) \
+	MD5_MB_STEP(V_G, a, b, c, d, x[ 9],  5, 0x21e1cde6) \
+	MD5_MB_STEP(V_G, d, a, b, c, x[14],  9, 0xc33707d6) \
+	MD5_MB_STEP(V_G, c, d, a, b, x[ 3], 14, 0xf4d50d87) \
+	MD5_MB_STEP(V_G, b, c, d, a, x[ 8], 20, 0x455a14ed) \
+	MD5_MB_STEP(V_G, a, b, c, d, x[13],  5, 0xa9e3e905) \
+	MD5_MB_STEP(V_G, d, a, b, c, x[ 2],  9, 0xfcefa3f8) \
+	MD5_MB_STEP(V_G, c, d, a, b, x[ 7], 14, 0x676f02d9) \
+	MD5_MB_STEP(V_G, b, c, d, a, x[12], 20, 0x8d2a4c8a) \
+	/* Round 3 */ \
+	MD5_MB_STEP(V_H, a, b, c, d, x[ 5],  4, 0xfffa3942) \
+	MD5_MB_STEP(V_H, d, a, b, c, x[ 8], 11, 0x8771f681) \
+	MD5_MB_STEP(V_H, c, d, a, b, x[11], 16, 0x6d9d6122) \
+	MD5_MB_STEP(V_H, b, c, d, a, x[14], 23, 0xfde5380c) \
+	MD5_MB_STEP(V_H, a, b, c, d, x[ 1],  4, 0xa4beea44) \
+	MD5_MB_STEP(V_H, d, a, b, c, x[ 4], 11, 0x4bdecfa9) \
+	MD5_MB_STEP(V_H, c, d, a, b, x[ 7], 16, 0xf6bb4b60) \
+	MD5_MB_STEP(V_H, b, c, d, a, x[10], 23, 0xbebfbc70) \
+	MD5_MB_STEP(V_H, a, b, c, d, x[13],  4, 0x289b7ec6) \
+	MD5_MB_STEP(V_H, d, a, b, c, x[ 0], 11, 0xeaa127fa) \
+	MD5_MB_STEP(V_H, c, d, a, b, x[ 3], 16, 0xd4ef3085) \
+	MD5_MB_STEP(V_H, b, c, d, a, x[ 6], 23, 0x04881d05) \
+	MD5_MB_STEP(V_H, a, b, c, d, x[ 9],  4, 0xd9d4d039) \
+	MD5_MB_STEP(V_H, d, a, b, c, x[12], 11, 0xe6db99e5) \
+	MD5_MB_STEP(V_H, c, d, a, b, x[15], 16, 0x1fa27cf8) \
+	MD5_MB_STEP(V_H, b, c, d, a, x[ 2], 23, 0xc4ac5665) \
+	/* Round 4 */ \
+	MD5_MB_STEP(V_I, a, b, c, d, x[ 0],  6, 0xf4292244) \
+	MD5_MB_STEP(V_I, d, a, b, c, x[ 7], 10, 0x432aff97) \
+	MD5_MB_STEP(V_I, c, d, a, b, x[14], 15, 0xab9423a7) \
+	MD5_MB_STEP(V_I, b, c, d, a, x[ 5], 21, 0xfc93a039) \
+	MD5_MB_STEP(V_I, a, b, c, d, x[12],  6, 0x655b59c3) \
+	MD5_MB_STEP(V_I, d, a, b, c, x[ 3], 10, 0x8f0ccc92) \
+	MD5_MB_STEP(V_I, c, d, a, b, x[10], 15, 0xffeff47d) \
+	MD5_MB_STEP(V_I, b, c, d, a, x[ 1], 21, 0x85845dd1) \
+	MD5_MB_STEP(V_I, a, b, c, d, x[ 8],  6, 0x6fa87e4f) \
+	MD5_MB_STEP(V_I, d, a, b, c, x[15], 10, 0xfe2ce6e0) \
+	MD5_MB_STEP(V_I, c, d, a, b, x[ 6], 15, 0xa3014314) \
+	MD5_MB_STEP(V_I, b, c, d, a, x[13], 21, 0x4e0811a1) \
+	MD5_MB_STEP(V_I, a, b, c, d, x[ 4],  6, 0xf7537e82) \
+	MD5_MB_STEP(V_I, d, a, b, c, x[11], 10, 0xbd3af235) \
+	MD5_MB_STEP(V_I, c, d, a, b, x[ 2], 15, 0x2ad7d2bb) \
+	MD5_MB_STEP(V_I, b, c, d, a, x[ 9], 21, 0xeb86d391)
+
+
+
+//
+// SSE2: 4 lanes
+//
+#define V_ADD(a, b)   _mm_add_epi32((a), (b))
+#define V_SET1(v)     _mm_set1_epi32(static_cast<int>(v))
+#define V_ROTL(a, s)  _mm_or_si128(_mm_slli_epi32((a), (s)), _mm_srli_epi32((a), 32 - (s)))
+#define V_F(x, y, z)  _mm_xor_si128((z), _mm_and_si128((x), _mm_xor_si128((y), (z))))
+#define V_G(x, y, z)  _mm_xor_si128((y), _mm_and_si128((z), _mm_xor_si128((x), (y))))
+#define V_H(x, y, z)  _mm_xor_si128(_mm_xor_si128((x), (y)), (z))
+#define V_I(x, y, z)  _mm_xor_si128((y), _mm_or_si128((x), _mm_xor_si128((z), _mm_set1_epi32(-1))))
+
+__attribute__((target("sse2")))
+void
+TransformSse2(algo::HasherMd5Mb::state_t& state, uint8_t const* const* lanes,
+              std::size_t offset, std::size_t blocks)
+{
+	constexpr std::size_t LANES = 4;
+	__m128i a = _mm_load_si128(reinterpret_cast<__m128i const*>(state[0]));
+	__m128i b = _mm_load_si128(reinterpret_cast<__m128i const*>(state[1]));
+	__m128i c = _mm_load_si128(reinterpret_cast<__m128i const*>(state[2]));
+	__m128i d = _mm_load_si128(reinterpret_cast<__m128i const*>(state[3]));
+
+	__m128i x[16];
+	for (; blocks != 0; --blocks, offset += algo::HasherMd5Mb::BLOCK_SIZE)
+	{
+		for (std::size_t w = 0; w < 16; w += 4)
+		{
+			for (std::size_t l = 0; l < LANES; ++l)
+			{
+				x[w + l] = _mm_loadu_si128(
+					reinterpret_cast<__m128i const*>(lanes[l] + offset + 4*w));
+			}
+			Transpose4x4(&x[w]);
+		}
+
+		__m128i const aa = a, bb = b, cc = c, dd = d;
+		MD5_MB_ROUNDS(a, b, c, d, x)
+		a = V_ADD(a, aa);
+		b = V_ADD(b, bb);
+		c = V_ADD(c, cc);
+		d = V_ADD(d, dd);
+	}
+
+	_mm_store_si128(reinterpret_cast<__m128i*>(state[0]), a);
+	_mm_store_si128(reinterpret_cast<__m128i*>(state[1]), b);
+	_mm_store_si128(reinterpret_cast<__m128i*>(state[2]), c);
+	_mm_store_si128(reinterpret_cast<__m128i*>(state[3]), d);
+}
+
+#undef V_ADD
+#undef V_SET1
+#undef V_ROTL
+#undef V_F
+#undef V_G
+#undef V_H
+#undef V_I
+
+
+
+//
+// AVX2: 8 lanes
+//
+#define V_ADD(a, b)   _mm256_add_epi32((a), (b))
+#define V_SET1(v)     _mm256_set1_epi32(static_cast<int>(v))
+#define V_ROTL(a, s)  _mm256_or_si256(_mm256_slli_epi32((a), (s)), _mm256_srli_epi32((a), 32 - (s)))
+#define V_F(x, y, z)  _mm256_xor_si256((z), _mm256_and_si256((x), _mm256_xor_si256((y), (z))))
+#define V_G(x, y, z)  _mm256_xor_si256((y), _mm256_and_si256((z), _mm256_xor_si256((x), (y))))
+#define V_H(x, y, z)  _mm256_xor_si256(_mm256_xor_si256((x), (y)), (z))
+#define V_I(x, y, z)  _mm256_xor_si256((y), _mm256_or_si256((x), _mm256_xor_si256((z), _mm256_set1_epi32(-1))))
+
+__attribute__((target("avx2")))
+void
+TransformAvx2(algo::HasherMd5Mb::state_t& state, uint8_t const* const* lanes,
+              std::size_t offset, std::size_t blocks)
+{
+	constexpr std::size_t LANES = 8;
+	__m256i a = _mm256_load_si256(reinterpret_cast<__m256i const*>(state[0]));
+	__m256i b = _mm256_load_si256(reinterpret_cast<__m256i const*>(state[1]));
+	__m256i c = _mm256_load_si256(reinterpret_cast<__m256i const*>(state[2]));
+	__m256i d = _mm256_load_si256(reinterpret_cast<__m256i const*>(state[3]));
+
+	__m256i x[16];
+	for (; blocks != 0; --blocks, offset += algo::HasherMd5Mb::BLOCK_SIZE)
+	{
+		for (std::size_t w = 0; w < 16; w += 8)
+		{
+			for (std::size_t l = 0; l < LANES; ++l)
+			{
+				x[w + l] = _mm256_loadu_si256(
+					reinterpret_cast<__m256i const*>(lanes[l] + offset + 4*w));
+			}
+			Transpose8x8(&x[w]);
+		}
+
+		__m256i const aa = a, bb = b, cc = c, dd = d;
+		MD5_MB_ROUNDS(a, b, c, d, x)
+		a = V_ADD(a, aa);
+		b = V_ADD(b, bb);
+		c = V_ADD(c, cc);
+		d = V_ADD(d, dd);
+	}
+
+	_mm256_store_si256(reinterpret_cast<__m256i*>(state[0]), a);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(state[1]), b);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(state[2]), c);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(state[3]), d);
+}
+
+#undef V_ADD
+#undef V_SET1
+#undef V_ROTL
+#undef V_F
+#undef V_G
+#undef V_H
+#undef V_I
+
+
+
+//
+// AVX-512: 16 lanes
+//
+#define V_ADD(a, b)   _mm512_add_epi32((a), (b))
+#define V_SET1(v)     _mm512_set1_epi32(static_cast<int>(v))
+#define V_ROTL(a, s)  _mm512_rol_epi32((a), (s))
+#define V_F(x, y, z)  _mm512_ternarylogic_epi32((x), (y), (z), 0xCA)
+#define V_G(x, y, z)  _mm512_ternarylogic_epi32((x), (y), (z), 0xE4)
+#define V_H(x, y, z)  _mm512_ternarylogic_epi32((x), (y), (z), 0x96)
+#define V_I(x, y, z)  _mm512_ternarylogic_epi32((x), (y), (z), 0x39)
+
+__attribute__((target("avx512f")))
+void
+TransformAvx512(algo::HasherMd5Mb::state_t& state, uint8_t const* const* lanes,
+                std::size_t offset, std::size_t blocks)
+{
+	constexpr std::size_t LANES = 16;
+	__m512i a = _mm512_load_si512(state[0]);
+	__m512i b = _mm512_load_si512(state[1]);
+	__m512i c = _mm512_load_si512(state[2]);
+	__m512i d = _mm512_load_si512(state[3]);
+
+	__m512i x[16];
+	for (; blocks != 0; --blocks, offset += algo::HasherMd5Mb::BLOCK_SIZE)
+	{
+		for (std::size_t l = 0; l < LANES; ++l)
+		{
+			x[l] = _mm512_loadu_si512(lanes[l] + offset);
+		}
+		Transpose16x16(x);
+
+		__m512i const aa = a, bb = b, cc = c, dd = d;
+		MD5_MB_ROUNDS(a, b, c, d, x)
+		a = V_ADD(a, aa);
+		b = V_ADD(b, bb);
+		c = V_ADD(c, cc);
+		d = V_ADD(d, dd);
+	}
+
+	_mm512_store_si512(state[0], a);
+	_mm512_store_si512(state[1], b);
+	_mm512_store_si512(state[2], c);
+	_mm512_store_si512(state[3], d);
+}
+
+#undef V_ADD
+#undef V_SET1
+#undef V_ROTL
+#undef V_F
+#undef V_G
+#undef V_H
+#undef V_I
+
+#undef MD5_MB_ROUNDS
+#undef MD5_MB_STEP
+
+#endif // __x86_64__
+
+
+struct Kernel
+{
+	algo::HasherMd5Mb::transform_t transform = nullptr;
+	std::size_t                    lanes     = 0;
+};
+
+
+Kernel
+SelectKernel() noexcept
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX512F)) { return {&TransformAvx512, 16}; }
+	if (CpuFeatures::Has(CpuFeatures::AVX2))    { return {&TransformAvx2,    8}; }
+	if (CpuFeatures::Has(CpuFeatures::SSE2))    { return {&TransformSse2,    4}; }
+#endif
+	return {};
+}
+
+} // namespace
+
+
+
+namespace algo {
+
+// static
+std::size_t
+HasherMd5Mb::SupportedLanes() noexcept
+{
+	return SelectKernel().lanes;
+}
+
+
+
+HasherMd5Mb::HasherMd5Mb()
+{
+	Kernel const kernel = SelectKernel();
+	if (not kernel.transform)
+	{
+		THROW_ERROR("HasherMd5Mb::%s: there is no SIMD kernel for the CPU", __FUNCTION__);
+	}
+	m_transform = kernel.transform;
+	m_lanes     = kernel.lanes;
+	for (std::size_t l = 0; l < MAX_LANES; ++l)
+	{
+		m_bufferPtrs[l] = m_buffer[l];
+	}
+	Init();
+}
+
+
+
+void
+HasherMd5Mb::Init()
+{
+	m_was_finished = false;
+	m_count = 0;
+	for (std::size_t l = 0; l < MAX_LANES; ++l)
+	{
+		m_state[0][l] = 0x67452301;
+		m_state[1][l] = 0xefcdab89;
+		m_state[2][l] = 0x98badcfe;
+		m_state[3][l] = 0x10325476;
+	}
+}
+
+
+
+int
+HasherMd5Mb::Init(InitHashStrategy const&)
+{
+	Init();
+	return 0;
+}
+
+
+
+int
+HasherMd5Mb::Update(uint8_t const* const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherMd5Mb::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	std::size_t index = m_count % BLOCK_SIZE;
+	std::size_t i = 0;
+	m_count += inputLen;
+
+	if (index != 0)
+	{
+		std::size_t const partLen = std::min(BLOCK_SIZE - index, inputLen);
+		for (std::size_t l = 0; l < m_lanes; ++l)
+		{
+			std::memcpy(&m_buffer[l][index], input[l], partLen);
+		}
+		if (index + partLen < BLOCK_SIZE) { return 0; }
+		m_transform(m_state, m_bufferPtrs, 0, 1);
+		i = partLen;
+	}
+
+	std::size_t const blocks = (inputLen - i) / BLOCK_SIZE;
+	if (blocks != 0)
+	{
+		m_transform(m_state, input, i, blocks);
+		i += blocks * BLOCK_SIZE;
+	}
+
+	if (i < inputLen)
+	{
+		for (std::size_t l = 0; l < m_lanes; ++l)
+		{
+			std::memcpy(m_buffer[l], input[l] + i, inputLen - i);
+		}
+	}
+	return 0;
+}
+
+
+
+std::size_t
+HasherMd5Mb::ResultSize() const
+{
+	return 16;
+}
+
+
+
+char const*
+HasherMd5Mb::KernelName() const
+{
+	switch (m_lanes)
+	{
+	case 16: return "avx512";
+	case 8:  return "avx2";
+	}
+	return "sse2";
+}
+
+
+
+int
+HasherMd5Mb::Finish(uint8_t* const* output)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherMd5Mb::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	// The padding is the same for all lanes because they have the same length
+	uint8_t padding[2 * BLOCK_SIZE] = { 0x80 };
+	uint64_t const bits = m_count << 3;
+	std::size_t const index  = m_count % BLOCK_SIZE;
+	std::size_t const padLen = (index < 56) ? (56 - index) : (120 - index);
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		padding[padLen + i] = static_cast<uint8_t>(bits >> (8 * i));
+	}
+	uint8_t const* paddingPtrs[MAX_LANES];
+	std::fill(std::begin(paddingPtrs), std::end(paddingPtrs), padding);
+	Update(paddingPtrs, padLen + 8);
+
+	for (std::size_t l = 0; l < m_lanes; ++l)
+	{
+		for (std::size_t w = 0; w < 4; ++w)
+		{
+			uint32_t const v = m_state[w][l];
+			output[l][4*w]     = static_cast<uint8_t>(v);
+			output[l][4*w + 1] = static_cast<uint8_t>(v >>  8);
+			output[l][4*w + 2] = static_cast<uint8_t>(v >> 16);
+			output[l][4*w + 3] = static_cast<uint8_t>(v >> 24);
+		}
+	}
+
+	m_was_finished = true;
+	return 0;
+}
+
+} // namespace algo
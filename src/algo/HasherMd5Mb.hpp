@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "IMultiHasher.hpp"
+
+
+namespace algo {
+
+// Multi-buffer MD5: 4 (SSE2), 8 (AVX2) or 16 (AVX-512) independent streams
+// are hashed by one SIMD kernel, a lane per 32-bit element of a vector. The
+// digests are byte-identical to HasherMd5.
+class HasherMd5Mb final : public IMultiHasher
+{
+public:
+	static constexpr std::size_t MAX_LANES  = 16;
+	static constexpr std::size_t BLOCK_SIZE = 64;
+
+	using state_t     = uint32_t[4][MAX_LANES];
+	using transform_t = void (*)(state_t&, uint8_t const* const*, std::size_t offset, std::size_t blocks);
+
+	// Returns the number of lanes of the best kernel for the current CPU or 0
+	// if there is no SIMD kernel.
+	static std::size_t SupportedLanes() noexcept;
+
+	HasherMd5Mb(HasherMd5Mb&&)                  = delete;
+	HasherMd5Mb(HasherMd5Mb const&)             = delete;
+	HasherMd5Mb& operator= (HasherMd5Mb&&)      = delete;
+	HasherMd5Mb& operator= (HasherMd5Mb const&) = delete;
+
+	HasherMd5Mb();
+	~HasherMd5Mb() = default;
+
+	// IMultiHasher
+	std::size_t Lanes() const override  { return m_lanes; }
+	int Init(InitHashStrategy const&) override;
+	int Update(uint8_t const* const*, std::size_t) override;
+	int Finish(uint8_t* const*) override;
+	std::size_t ResultSize() const override;
+	char const* KernelName() const override;
+
+private:
+	void Init();
+
+private:
+	alignas(64) state_t m_state;
+	uint8_t             m_buffer[MAX_LANES][BLOCK_SIZE];
+	uint8_t const*      m_bufferPtrs[MAX_LANES];
+	uint64_t            m_count        = 0; // number of bytes in each lane
+	transform_t         m_transform    = nullptr;
+	std::size_t         m_lanes        = 0;
+	bool                m_was_finished = false;
+};
+
+} // namespace algo
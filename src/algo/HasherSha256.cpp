@@ -0,0 +1,466 @@
+#include "HasherSha256.hpp"
+
+#include <algorithm>
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+
+
+
+namespace {
+
+using algo::HasherSha256;
+
+
+inline uint32_t
+LoadBe32(uint8_t const* p)
+{
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+	     | (static_cast<uint32_t>(p[2]) <<  8) |  static_cast<uint32_t>(p[3]);
+}
+
+
+inline void
+StoreBe32(uint8_t* p, uint32_t v)
+{
+	p[0] = static_cast<uint8_t>(v >> 24);
+	p[1] = static_cast<uint8_t>(v >> 16);
+	p[2] = static_cast<uint8_t>(v >>  8);
+	p[3] = static_cast<uint8_t>(v);
+}
+
+
+inline uint32_t
+Ror(uint32_t x, unsigned n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+
+
+#define SHA256_SUM0(x)       (Ror((x),  2) ^ Ror((x), 13) ^ Ror((x), 22))
+#define SHA256_SUM1(x)       (Ror((x),  6) ^ Ror((x), 11) ^ Ror((x), 25))
+#define SHA256_SIG0(x)       (Ror((x),  7) ^ Ror((x), 18) ^ ((x) >>  3))
+#define SHA256_SIG1(x)       (Ror((x), 17) ^ Ror((x), 19) ^ ((x) >> 10))
+#define SHA256_CH(x, y, z)   ((z) ^ ((x) & ((y) ^ (z))))
+#define SHA256_MAJ(x, y, z)  (((x) & (y)) | ((z) & ((x) | (y))))
+
+// `wk` is the sum of the round constant and the message schedule word
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, wk) \
+	{ \
+		uint32_t const t1 = (h) + SHA256_SUM1(e) + SHA256_CH((e), (f), (g)) + (wk); \
+		(d) += t1; \
+		(h)  = t1 + SHA256_SUM0(a) + SHA256_MAJ((a), (b), (c)); \
+	}
+
+#define SHA256_STEP(a, b, c, d, e, f, g, h, t) \
+	{ \
+		if ((t) >= 16) \
+		{ \
+			w[(t) & 15] += SHA256_SIG1(w[((t) + 14) & 15]) + w[((t) + 9) & 15] \
+			             + SHA256_SIG0(w[((t) + 1) & 15]); \
+		} \
+		SHA256_ROUND(a, b, c, d, e, f, g, h, HasherSha256::ROUND_K[t] + w[(t) & 15]) \
+	}
+
+void
+TransformPortable(uint32_t* state, uint8_t const* blocks, std::size_t count)
+{
+	uint32_t w[16];
+	for (; count != 0; --count, blocks += HasherSha256::BLOCK_SIZE)
+	{
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			w[i] = LoadBe32(blocks + 4*i);
+		}
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+		for (std::size_t t = 0; t < 64; t += 8)
+		{
+			SHA256_STEP(a, b, c, d, e, f, g, h, t)
+			SHA256_STEP(h, a, b, c, d, e, f, g, t + 1)
+			SHA256_STEP(g, h, a, b, c, d, e, f, t + 2)
+			SHA256_STEP(f, g, h, a, b, c, d, e, t + 3)
+			SHA256_STEP(e, f, g, h, a, b, c, d, t + 4)
+			SHA256_STEP(d, e, f, g, h, a, b, c, t + 5)
+			SHA256_STEP(c, d, e, f, g, h, a, b, t + 6)
+			SHA256_STEP(b, c, d, e, f, g, h, a, t + 7)
+		}
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+		state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+	}
+}
+
+
+
+// The message schedule of a block of the same byte `ch` plus the round
+// constants: it is the same for all such blocks.
+void
+MakeFillSchedule(uint8_t ch, uint32_t wk[64])
+{
+	uint32_t w[64];
+	for (std::size_t t = 0; t < 64; ++t)
+	{
+		w[t] = (t < 16)
+			? 0x01010101u * ch
+			: SHA256_SIG1(w[t - 2]) + w[t - 7] + SHA256_SIG0(w[t - 15]) + w[t - 16];
+		wk[t] = w[t] + HasherSha256::ROUND_K[t];
+	}
+}
+
+
+void
+FillPortable(uint32_t* state, uint32_t const* wk, uint64_t count)
+{
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+	for (; count != 0; --count)
+	{
+		uint32_t const aa = a, bb = b, cc = c, dd = d;
+		uint32_t const ee = e, ff = f, gg = g, hh = h;
+		for (std::size_t t = 0; t < 64; t += 8)
+		{
+			SHA256_ROUND(a, b, c, d, e, f, g, h, wk[t])
+			SHA256_ROUND(h, a, b, c, d, e, f, g, wk[t + 1])
+			SHA256_ROUND(g, h, a, b, c, d, e, f, wk[t + 2])
+			SHA256_ROUND(f, g, h, a, b, c, d, e, wk[t + 3])
+			SHA256_ROUND(e, f, g, h, a, b, c, d, wk[t + 4])
+			SHA256_ROUND(d, e, f, g, h, a, b, c, wk[t + 5])
+			SHA256_ROUND(c, d, e, f, g, h, a, b, wk[t + 6])
+			SHA256_ROUND(b, c, d, e, f, g, h, a, wk[t + 7])
+		}
+		a += aa; b += bb; c += cc; d += dd;
+		e += ee; f += ff; g += gg; h += hh;
+	}
+	state[0] = a; state[1] = b; state[2] = c; state[3] = d;
+	state[4] = e; state[5] = f; state[6] = g; state[7] = h;
+}
+
+#undef SHA256_STEP
+#undef SHA256_ROUND
+#undef SHA256_MAJ
+#undef SHA256_CH
+#undef SHA256_SIG1
+#undef SHA256_SIG0
+#undef SHA256_SUM1
+#undef SHA256_SUM0
+
+
+
+#if defined(__x86_64__)
+
+// `sha256rnds2` keeps the state as ABEF and CDGH halves and does two rounds
+// per instruction, `sha256msg1`/`sha256msg2` compute the message schedule
+// four words at a time (see Intel "SHA Extensions" white paper).
+__attribute__((target("sha,sse4.1,ssse3")))
+inline void
+LoadStateShaNi(uint32_t const* state, __m128i& state0, __m128i& state1)
+{
+	__m128i tmp = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&state[0]));
+	state1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&state[4]));
+	tmp    = _mm_shuffle_epi32(tmp, 0xB1);            // CDAB
+	state1 = _mm_shuffle_epi32(state1, 0x1B);         // EFGH
+	state0 = _mm_alignr_epi8(tmp, state1, 8);         // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);      // CDGH
+}
+
+
+__attribute__((target("sha,sse4.1,ssse3")))
+inline void
+StoreStateShaNi(uint32_t* state, __m128i state0, __m128i state1)
+{
+	__m128i const tmp = _mm_shuffle_epi32(state0, 0x1B); // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1);            // DCHG
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);         // DCBA
+	state1 = _mm_alignr_epi8(state1, tmp, 8);            // ABEF
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+
+__attribute__((target("sha,sse4.1,ssse3")))
+void
+TransformShaNi(uint32_t* state, uint8_t const* blocks, std::size_t count)
+{
+	__m128i const BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	__m128i state0;
+	__m128i state1;
+	LoadStateShaNi(state, state0, state1);
+
+	__m128i m[4];
+	for (; count != 0; --count, blocks += HasherSha256::BLOCK_SIZE)
+	{
+		__m128i const abef = state0;
+		__m128i const cdgh = state1;
+
+#pragma GCC unroll 16
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			if (i < 4)
+			{
+				m[i] = _mm_shuffle_epi8(
+					_mm_loadu_si128(reinterpret_cast<__m128i const*>(blocks + 16*i)), BSWAP);
+			}
+			__m128i msg = _mm_add_epi32(m[i % 4],
+				_mm_loadu_si128(reinterpret_cast<__m128i const*>(&HasherSha256::ROUND_K[4*i])));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+			if (i >= 3 and i <= 14)
+			{
+				__m128i& next = m[(i + 1) % 4];
+				next = _mm_add_epi32(next, _mm_alignr_epi8(m[i % 4], m[(i + 3) % 4], 4));
+				next = _mm_sha256msg2_epu32(next, m[i % 4]);
+			}
+			msg    = _mm_shuffle_epi32(msg, 0x0E);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+			if (i >= 1 and i <= 12)
+			{
+				m[(i + 3) % 4] = _mm_sha256msg1_epu32(m[(i + 3) % 4], m[i % 4]);
+			}
+		}
+
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	StoreStateShaNi(state, state0, state1);
+}
+
+
+__attribute__((target("sha,sse4.1,ssse3")))
+void
+FillShaNi(uint32_t* state, uint32_t const* wk, uint64_t count)
+{
+	__m128i state0;
+	__m128i state1;
+	LoadStateShaNi(state, state0, state1);
+
+	__m128i k[16];
+	for (std::size_t i = 0; i < 16; ++i)
+	{
+		k[i] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&wk[4*i]));
+	}
+	for (; count != 0; --count)
+	{
+		__m128i const abef = state0;
+		__m128i const cdgh = state1;
+#pragma GCC unroll 16
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			state1 = _mm_sha256rnds2_epu32(state1, state0, k[i]);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(k[i], 0x0E));
+		}
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	StoreStateShaNi(state, state0, state1);
+}
+
+#endif // __x86_64__
+
+
+struct Kernel
+{
+	HasherSha256::transform_t transform = &TransformPortable;
+	HasherSha256::fill_t      fill      = &FillPortable;
+};
+
+
+Kernel
+SelectKernel() noexcept
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::SHA | CpuFeatures::SSE41 | CpuFeatures::SSSE3))
+	{
+		return {&TransformShaNi, &FillShaNi};
+	}
+#endif
+	return {};
+}
+
+} // namespace
+
+
+
+namespace algo {
+
+// static
+bool
+HasherSha256::HasShaNi() noexcept
+{
+	return SelectKernel().transform != &TransformPortable;
+}
+
+
+
+HasherSha256::HasherSha256()
+{
+	Kernel const kernel = SelectKernel();
+	m_transform = kernel.transform;
+	m_fill      = kernel.fill;
+	Init();
+}
+
+
+
+void
+HasherSha256::Init()
+{
+	m_was_finished = false;
+	m_count = 0;
+	std::copy(std::begin(INIT_STATE), std::end(INIT_STATE), m_state);
+}
+
+
+
+int
+HasherSha256::Init(InitHashStrategy const&)
+{
+	Init();
+	return 0;
+}
+
+
+
+int
+HasherSha256::Update(uint8_t const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherSha256::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	std::size_t const index = m_count % BLOCK_SIZE;
+	std::size_t i = 0;
+	m_count += inputLen;
+
+	if (index != 0)
+	{
+		std::size_t const partLen = std::min(BLOCK_SIZE - index, inputLen);
+		std::memcpy(&m_buffer[index], input, partLen);
+		if (index + partLen < BLOCK_SIZE) { return 0; }
+		m_transform(m_state, m_buffer, 1);
+		i = partLen;
+	}
+
+	std::size_t const blocks = (inputLen - i) / BLOCK_SIZE;
+	if (blocks != 0)
+	{
+		m_transform(m_state, input + i, blocks);
+		i += blocks * BLOCK_SIZE;
+	}
+
+	if (i < inputLen)
+	{
+		std::memcpy(m_buffer, input + i, inputLen - i);
+	}
+	return 0;
+}
+
+
+
+int
+HasherSha256::UpdateFill(uint8_t ch, std::uint64_t count)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherSha256::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	uint8_t block[BLOCK_SIZE];
+	std::memset(block, ch, sizeof(block));
+
+	// Complete the buffered block
+	std::size_t const index = m_count % BLOCK_SIZE;
+	if (index != 0)
+	{
+		auto const partLen = static_cast<std::size_t>(std::min<std::uint64_t>(BLOCK_SIZE - index, count));
+		Update(block, partLen);
+		count -= partLen;
+	}
+
+	std::uint64_t const blocks = count / BLOCK_SIZE;
+	if (blocks != 0)
+	{
+		uint32_t wk[64];
+		MakeFillSchedule(ch, wk);
+		m_fill(m_state, wk, blocks);
+		m_count += blocks * BLOCK_SIZE;
+	}
+	return Update(block, static_cast<std::size_t>(count % BLOCK_SIZE));
+}
+
+
+
+std::size_t
+HasherSha256::ResultSize() const
+{
+	return OUT_LEN;
+}
+
+
+
+char const*
+HasherSha256::KernelName() const
+{
+	return (m_transform == &TransformPortable) ? "portable" : "sha-ni";
+}
+
+
+
+int
+HasherSha256::Finish(uint8_t* output)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherSha256::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	uint8_t padding[2 * BLOCK_SIZE] = { 0x80 };
+	uint64_t const bits = m_count << 3;
+	std::size_t const index  = m_count % BLOCK_SIZE;
+	std::size_t const padLen = (index < 56) ? (56 - index) : (120 - index);
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		padding[padLen + i] = static_cast<uint8_t>(bits >> (56 - 8*i));
+	}
+	Update(padding, padLen + 8);
+
+	for (std::size_t w = 0; w < 8; ++w)
+	{
+		StoreBe32(output + 4*w, m_state[w]);
+	}
+
+	m_was_finished = true;
+	return 0;
+}
+
+
+
+int
+HasherSha256::HashBatch(InitHashStrategy const& s,
+                        uint8_t const* const* inputs, std::size_t size,
+                        uint8_t* const* results, std::size_t count)
+{
+	//NOTE: CreateMulti returns the multi-buffer kernel only if it is selected
+	// for the CPU (see HasherFactory::SelectImpl)
+	if (not m_batchHasher) { m_batchHasher = HasherFactory::CreateMulti(s); }
+	if (not m_batchHasher) { return IHasher::HashBatch(s, inputs, size, results, count); }
+	return HashBatchByLanes(*m_batchHasher, *this, s, inputs, size, results, count);
+}
+
+} // namespace algo
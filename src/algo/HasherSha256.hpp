@@ -0,0 +1,89 @@
+#pragma once
+
+
+#include <memory>
+
+#include "IHasher.hpp"
+#include "IMultiHasher.hpp"
+
+
+
+namespace algo {
+
+class InitSha256HashStrategy : public InitHashStrategy
+{
+public:
+	InitSha256HashStrategy()
+		: InitHashStrategy(hash_type_e::SHA256)
+	{}
+
+private:
+};
+
+
+
+// SHA-256 (FIPS 180-4). The compression function is either the portable one
+// or the Intel SHA extensions (SHA-NI) kernel, selected once by CPUID.
+class HasherSha256 final : public IHasher
+{
+public:
+	static constexpr std::size_t BLOCK_SIZE = 64;
+	static constexpr std::size_t OUT_LEN    = 32;
+
+	// FIPS 180-4 constants, they are shared with HasherSha256Mb
+	static constexpr uint32_t INIT_STATE[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	static constexpr uint32_t ROUND_K[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+	};
+
+	using transform_t = void (*)(uint32_t* state, uint8_t const* blocks, std::size_t count);
+	// Compresses `count` equal blocks by their precomputed message schedule
+	// plus the round constants `wk[64]`
+	using fill_t      = void (*)(uint32_t* state, uint32_t const* wk, std::uint64_t count);
+
+	// Returns true if the SHA-NI kernel is used on the current CPU
+	static bool HasShaNi() noexcept;
+
+	HasherSha256(HasherSha256&&)                  = delete;
+	HasherSha256(HasherSha256 const&)             = delete;
+	HasherSha256& operator= (HasherSha256&&)      = delete;
+	HasherSha256& operator= (HasherSha256 const&) = delete;
+
+	HasherSha256();
+	~HasherSha256() = default;
+
+	// IHasher
+	int Init(InitHashStrategy const&) override;
+	int Update(uint8_t const*, std::size_t) override;
+	int UpdateFill(uint8_t, std::uint64_t) override;
+	int Finish(uint8_t*) override;
+	std::size_t ResultSize() const override;
+	int HashBatch(InitHashStrategy const&,
+	              uint8_t const* const*, std::size_t,
+	              uint8_t* const*, std::size_t) override;
+	char const* KernelName() const override;
+
+private:
+	void Init();
+
+private:
+	alignas(16) uint32_t m_state[8];
+	uint8_t              m_buffer[BLOCK_SIZE];
+	uint64_t             m_count        = 0; // number of hashed bytes
+	transform_t          m_transform    = nullptr;
+	fill_t               m_fill         = nullptr;
+	bool                 m_was_finished = false;
+	std::unique_ptr<IMultiHasher> m_batchHasher; // the lanes of HashBatch
+};
+
+} // namespace algo
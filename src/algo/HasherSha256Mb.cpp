@@ -0,0 +1,372 @@
+#include "HasherSha256Mb.hpp"
+
+#include <algorithm>
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+#include "HasherSha256.hpp"
+#include "SimdTranspose.hpp"
+
+
+
+namespace {
+
+#if defined(__x86_64__)
+
+using algo::simd::Transpose8x8;
+using algo::simd::Transpose16x16;
+
+// The kernels below share the SHA-256 round list (see FIPS 180-4) and differ
+// only by the vector type and its operations: V_ADD, V_SET1, V_ROR, V_SHR,
+// V_XOR3, V_CH and V_MAJ have to be defined before SHA256_MB_ROUNDS is used.
+// `w` is the ring of the last 16 words of the message schedule.
+
+#define SHA256_MB_STEP(a, b, c, d, e, f, g, h, w, t) \
+	{ \
+		if ((t) >= 16) \
+		{ \
+			(w)[(t) & 15] = V_ADD( \
+				V_ADD((w)[(t) & 15], \
+				      V_XOR3(V_ROR((w)[((t) + 1) & 15], 7), V_ROR((w)[((t) + 1) & 15], 18), \
+				             V_SHR((w)[((t) + 1) & 15], 3))), \
+				V_ADD((w)[((t) + 9) & 15], \
+				      V_XOR3(V_ROR((w)[((t) + 14) & 15], 17), V_ROR((w)[((t) + 14) & 15], 19), \
+				             V_SHR((w)[((t) + 14) & 15], 10)))); \
+		} \
+		auto const t1 = V_ADD( \
+			V_ADD((h), V_XOR3(V_ROR((e), 6), V_ROR((e), 11), V_ROR((e), 25))), \
+			V_ADD(V_CH((e), (f), (g)), \
+			      V_ADD(V_SET1(algo::HasherSha256::ROUND_K[t]), (w)[(t) & 15]))); \
+		(d) = V_ADD((d), t1); \
+		(h) = V_ADD(t1, V_ADD(V_XOR3(V_ROR((a), 2), V_ROR((a), 13), V_ROR((a), 22)), \
+		                      V_MAJ((a), (b), (c)))); \
+	}
+
+#define SHA256_MB_ROUNDS(s, w) \
+	for (std::size_t t = 0; t < 64; t += 8) \
+	{ \
+		SHA256_MB_STEP(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], w, t) \
+		SHA256_MB_STEP(s[7], s[0], s[1], s[2], s[3], s[4], s[5], s[6], w, t + 1) \
+		SHA256_MB_STEP(s[6], s[7], s[0], s[1], s[2], s[3], s[4], s[5], w, t + 2) \
+		SHA256_MB_STEP(s[5], s[6], s[7], s[0], s[1], s[2], s[3], s[4], w, t + 3) \
+		SHA256_MB_STEP(s[4], s[5], s[6], s[7], s[0], s[1], s[2], s[3], w, t + 4) \
+		SHA256_MB_STEP(s[3], s[4], s[5], s[6], s[7], s[0], s[1], s[2], w, t + 5) \
+		SHA256_MB_STEP(s[2], s[3], s[4], s[5], s[6], s[7], s[0], s[1], w, t + 6) \
+		SHA256_MB_STEP(s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[0], w, t + 7) \
+	}
+
+
+
+//
+// AVX2: 8 lanes
+//
+#define V_ADD(a, b)      _mm256_add_epi32((a), (b))
+#define V_SET1(v)        _mm256_set1_epi32(static_cast<int>(v))
+#define V_ROR(a, s)      _mm256_or_si256(_mm256_srli_epi32((a), (s)), _mm256_slli_epi32((a), 32 - (s)))
+#define V_SHR(a, s)      _mm256_srli_epi32((a), (s))
+#define V_XOR3(x, y, z)  _mm256_xor_si256(_mm256_xor_si256((x), (y)), (z))
+#define V_CH(x, y, z)    _mm256_xor_si256((z), _mm256_and_si256((x), _mm256_xor_si256((y), (z))))
+#define V_MAJ(x, y, z)   _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_and_si256((z), _mm256_or_si256((x), (y))))
+
+__attribute__((target("avx2")))
+void
+TransformAvx2(algo::HasherSha256Mb::state_t& state, uint8_t const* const* lanes,
+              std::size_t offset, std::size_t blocks)
+{
+	constexpr std::size_t LANES = 8;
+	__m256i const bswap = _mm256_set_epi64x(
+		0x0c0d0e0f08090a0bLL, 0x0405060700010203LL, 0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+	__m256i s[8];
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		s[i] = _mm256_load_si256(reinterpret_cast<__m256i const*>(state[i]));
+	}
+
+	__m256i w[16];
+	for (; blocks != 0; --blocks, offset += algo::HasherSha256Mb::BLOCK_SIZE)
+	{
+		for (std::size_t i = 0; i < 16; i += 8)
+		{
+			for (std::size_t l = 0; l < LANES; ++l)
+			{
+				w[i + l] = _mm256_loadu_si256(
+					reinterpret_cast<__m256i const*>(lanes[l] + offset + 4*i));
+			}
+			Transpose8x8(&w[i]);
+		}
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			w[i] = _mm256_shuffle_epi8(w[i], bswap);
+		}
+
+		__m256i saved[8];
+		std::copy(std::begin(s), std::end(s), saved);
+		SHA256_MB_ROUNDS(s, w)
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			s[i] = V_ADD(s[i], saved[i]);
+		}
+	}
+
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		_mm256_store_si256(reinterpret_cast<__m256i*>(state[i]), s[i]);
+	}
+}
+
+#undef V_ADD
+#undef V_SET1
+#undef V_ROR
+#undef V_SHR
+#undef V_XOR3
+#undef V_CH
+#undef V_MAJ
+
+
+
+//
+// AVX-512: 16 lanes
+//
+#define V_ADD(a, b)      _mm512_add_epi32((a), (b))
+#define V_SET1(v)        _mm512_set1_epi32(static_cast<int>(v))
+#define V_ROR(a, s)      _mm512_ror_epi32((a), (s))
+#define V_SHR(a, s)      _mm512_srli_epi32((a), (s))
+#define V_XOR3(x, y, z)  _mm512_ternarylogic_epi32((x), (y), (z), 0x96)
+#define V_CH(x, y, z)    _mm512_ternarylogic_epi32((x), (y), (z), 0xCA)
+#define V_MAJ(x, y, z)   _mm512_ternarylogic_epi32((x), (y), (z), 0xE8)
+
+__attribute__((target("avx512f")))
+void
+TransformAvx512(algo::HasherSha256Mb::state_t& state, uint8_t const* const* lanes,
+                std::size_t offset, std::size_t blocks)
+{
+	constexpr std::size_t LANES = 16;
+	// Byte swap without AVX512BW: select bytes 0 and 2 from rotl(x, 8) and
+	// bytes 1 and 3 from rotl(x, 24)
+	__m512i const mask = _mm512_set1_epi32(0x00FF00FF);
+
+	__m512i s[8];
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		s[i] = _mm512_load_si512(state[i]);
+	}
+
+	__m512i w[16];
+	for (; blocks != 0; --blocks, offset += algo::HasherSha256Mb::BLOCK_SIZE)
+	{
+		for (std::size_t l = 0; l < LANES; ++l)
+		{
+			w[l] = _mm512_loadu_si512(lanes[l] + offset);
+		}
+		Transpose16x16(w);
+		for (std::size_t i = 0; i < 16; ++i)
+		{
+			w[i] = _mm512_ternarylogic_epi32(
+				mask, _mm512_rol_epi32(w[i], 8), _mm512_rol_epi32(w[i], 24), 0xCA);
+		}
+
+		__m512i saved[8];
+		std::copy(std::begin(s), std::end(s), saved);
+		SHA256_MB_ROUNDS(s, w)
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			s[i] = V_ADD(s[i], saved[i]);
+		}
+	}
+
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		_mm512_store_si512(state[i], s[i]);
+	}
+}
+
+#undef V_ADD
+#undef V_SET1
+#undef V_ROR
+#undef V_SHR
+#undef V_XOR3
+#undef V_CH
+#undef V_MAJ
+
+#undef SHA256_MB_ROUNDS
+#undef SHA256_MB_STEP
+
+#endif // __x86_64__
+
+
+struct Kernel
+{
+	algo::HasherSha256Mb::transform_t transform = nullptr;
+	std::size_t                       lanes     = 0;
+};
+
+
+Kernel
+SelectKernel() noexcept
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX512F)) { return {&TransformAvx512, 16}; }
+	if (CpuFeatures::Has(CpuFeatures::AVX2))    { return {&TransformAvx2,    8}; }
+#endif
+	return {};
+}
+
+} // namespace
+
+
+
+namespace algo {
+
+// static
+std::size_t
+HasherSha256Mb::SupportedLanes() noexcept
+{
+	return SelectKernel().lanes;
+}
+
+
+
+HasherSha256Mb::HasherSha256Mb()
+{
+	Kernel const kernel = SelectKernel();
+	if (not kernel.transform)
+	{
+		THROW_ERROR("HasherSha256Mb::%s: there is no SIMD kernel for the CPU", __FUNCTION__);
+	}
+	m_transform = kernel.transform;
+	m_lanes     = kernel.lanes;
+	for (std::size_t l = 0; l < MAX_LANES; ++l)
+	{
+		m_bufferPtrs[l] = m_buffer[l];
+	}
+	Init();
+}
+
+
+
+void
+HasherSha256Mb::Init()
+{
+	m_was_finished = false;
+	m_count = 0;
+	for (std::size_t w = 0; w < 8; ++w)
+	{
+		std::fill(std::begin(m_state[w]), std::end(m_state[w]), HasherSha256::INIT_STATE[w]);
+	}
+}
+
+
+
+int
+HasherSha256Mb::Init(InitHashStrategy const&)
+{
+	Init();
+	return 0;
+}
+
+
+
+int
+HasherSha256Mb::Update(uint8_t const* const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherSha256Mb::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	std::size_t index = m_count % BLOCK_SIZE;
+	std::size_t i = 0;
+	m_count += inputLen;
+
+	if (index != 0)
+	{
+		std::size_t const partLen = std::min(BLOCK_SIZE - index, inputLen);
+		for (std::size_t l = 0; l < m_lanes; ++l)
+		{
+			std::memcpy(&m_buffer[l][index], input[l], partLen);
+		}
+		if (index + partLen < BLOCK_SIZE) { return 0; }
+		m_transform(m_state, m_bufferPtrs, 0, 1);
+		i = partLen;
+	}
+
+	std::size_t const blocks = (inputLen - i) / BLOCK_SIZE;
+	if (blocks != 0)
+	{
+		m_transform(m_state, input, i, blocks);
+		i += blocks * BLOCK_SIZE;
+	}
+
+	if (i < inputLen)
+	{
+		for (std::size_t l = 0; l < m_lanes; ++l)
+		{
+			std::memcpy(m_buffer[l], input[l] + i, inputLen - i);
+		}
+	}
+	return 0;
+}
+
+
+
+std::size_t
+HasherSha256Mb::ResultSize() const
+{
+	return HasherSha256::OUT_LEN;
+}
+
+
+
+char const*
+HasherSha256Mb::KernelName() const
+{
+	return (m_lanes == 16) ? "avx512" : "avx2";
+}
+
+
+
+int
+HasherSha256Mb::Finish(uint8_t* const* output)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherSha256Mb::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	// The padding is the same for all lanes because they have the same length
+	uint8_t padding[2 * BLOCK_SIZE] = { 0x80 };
+	uint64_t const bits = m_count << 3;
+	std::size_t const index  = m_count % BLOCK_SIZE;
+	std::size_t const padLen = (index < 56) ? (56 - index) : (120 - index);
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		padding[padLen + i] = static_cast<uint8_t>(bits >> (56 - 8*i));
+	}
+	uint8_t const* paddingPtrs[MAX_LANES];
+	std::fill(std::begin(paddingPtrs), std::end(paddingPtrs), padding);
+	Update(paddingPtrs, padLen + 8);
+
+	for (std::size_t l = 0; l < m_lanes; ++l)
+	{
+		for (std::size_t w = 0; w < 8; ++w)
+		{
+			uint32_t const v = m_state[w][l];
+			output[l][4*w]     = static_cast<uint8_t>(v >> 24);
+			output[l][4*w + 1] = static_cast<uint8_t>(v >> 16);
+			output[l][4*w + 2] = static_cast<uint8_t>(v >>  8);
+			output[l][4*w + 3] = static_cast<uint8_t>(v);
+		}
+	}
+
+	m_was_finished = true;
+	return 0;
+}
+
+} // namespace algo
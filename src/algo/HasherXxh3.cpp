@@ -0,0 +1,691 @@
+#include "HasherXxh3.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+
+#include <cstring>
+
+#include "common/Logger.hpp"
+#include "common/CpuFeatures.hpp"
+
+
+
+namespace {
+
+using algo::HasherXxh3;
+
+constexpr uint32_t PRIME32_1 = 0x9E3779B1U;
+constexpr uint32_t PRIME32_2 = 0x85EBCA77U;
+constexpr uint32_t PRIME32_3 = 0xC2B2AE3DU;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+constexpr std::size_t MIDSIZE_MAX         = 240;
+constexpr std::size_t MIDSIZE_STARTOFFSET = 3;
+constexpr std::size_t MIDSIZE_LASTOFFSET  = 17;
+constexpr std::size_t SECRET_SIZE_MIN     = 136;
+constexpr std::size_t SECRET_CONSUME_RATE = 8;
+constexpr std::size_t SECRET_MERGEACCS    = 11;
+constexpr std::size_t SECRET_LASTACC      = 7;
+constexpr std::size_t STRIPES_PER_BLOCK   =
+	(HasherXxh3::SECRET_SIZE - HasherXxh3::STRIPE_LEN) / SECRET_CONSUME_RATE;
+
+// The default secret of xxHash (taken from FARSH)
+alignas(64) constexpr uint8_t SECRET[HasherXxh3::SECRET_SIZE] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+
+__extension__ using uint128_t = unsigned __int128;
+
+
+struct hash128_t
+{
+	uint64_t low;
+	uint64_t high;
+};
+
+
+
+inline uint32_t
+Read32(uint8_t const* p) noexcept
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+#else
+	uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return __builtin_bswap32(v);
+#endif
+}
+
+
+inline uint64_t
+Read64(uint8_t const* p) noexcept
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+#else
+	uint64_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return __builtin_bswap64(v);
+#endif
+}
+
+
+inline void
+StoreBe64(uint8_t* p, uint64_t v) noexcept
+{
+	for (int i = 7; i >= 0; --i, v >>= 8)
+	{
+		p[i] = static_cast<uint8_t>(v);
+	}
+}
+
+
+inline uint64_t Rotl64(uint64_t v, int r) noexcept { return (v << r) | (v >> (64 - r)); }
+inline uint32_t Rotl32(uint32_t v, int r) noexcept { return (v << r) | (v >> (32 - r)); }
+
+
+inline hash128_t
+Mult64to128(uint64_t a, uint64_t b) noexcept
+{
+	uint128_t const r = static_cast<uint128_t>(a) * b;
+	return { static_cast<uint64_t>(r), static_cast<uint64_t>(r >> 64) };
+}
+
+
+inline uint64_t
+Mul128Fold64(uint64_t a, uint64_t b) noexcept
+{
+	hash128_t const r = Mult64to128(a, b);
+	return r.low ^ r.high;
+}
+
+
+inline uint64_t
+Xxh64Avalanche(uint64_t h) noexcept
+{
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+
+inline uint64_t
+Avalanche(uint64_t h) noexcept
+{
+	h ^= h >> 37;
+	h *= PRIME_MX1;
+	h ^= h >> 32;
+	return h;
+}
+
+
+inline uint64_t
+Rrmxmx(uint64_t h, uint64_t len) noexcept
+{
+	h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+	h *= PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= PRIME_MX2;
+	h ^= h >> 28;
+	return h;
+}
+
+
+inline uint64_t
+Mix16B(uint8_t const* input, uint8_t const* secret) noexcept
+{
+	return Mul128Fold64(Read64(input)     ^ Read64(secret),
+	                    Read64(input + 8) ^ Read64(secret + 8));
+}
+
+
+inline hash128_t
+Mix32B(hash128_t acc, uint8_t const* in1, uint8_t const* in2, uint8_t const* secret) noexcept
+{
+	acc.low  += Mix16B(in1, secret);
+	acc.low  ^= Read64(in2) + Read64(in2 + 8);
+	acc.high += Mix16B(in2, secret + 16);
+	acc.high ^= Read64(in1) + Read64(in1 + 8);
+	return acc;
+}
+
+
+
+//NOTE: the short input functions are specialized for zero seed
+
+
+
+uint64_t
+Hash64Short(uint8_t const* input, std::size_t len) noexcept
+{
+	if (len > 128)
+	{
+		uint64_t acc = len * PRIME64_1;
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			acc += Mix16B(input + 16 * i, SECRET + 16 * i);
+		}
+		acc = Avalanche(acc);
+		uint64_t acc_end = Mix16B(input + len - 16, SECRET + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET);
+		for (std::size_t i = 8; i < len / 16; ++i)
+		{
+			acc_end += Mix16B(input + 16 * i, SECRET + 16 * (i - 8) + MIDSIZE_STARTOFFSET);
+		}
+		return Avalanche(acc + acc_end);
+	}
+	if (len > 16)
+	{
+		uint64_t acc = len * PRIME64_1;
+		if (len > 32)
+		{
+			if (len > 64)
+			{
+				if (len > 96)
+				{
+					acc += Mix16B(input + 48, SECRET + 96);
+					acc += Mix16B(input + len - 64, SECRET + 112);
+				}
+				acc += Mix16B(input + 32, SECRET + 64);
+				acc += Mix16B(input + len - 48, SECRET + 80);
+			}
+			acc += Mix16B(input + 16, SECRET + 32);
+			acc += Mix16B(input + len - 32, SECRET + 48);
+		}
+		acc += Mix16B(input, SECRET);
+		acc += Mix16B(input + len - 16, SECRET + 16);
+		return Avalanche(acc);
+	}
+	if (len > 8)
+	{
+		uint64_t const lo  = Read64(input) ^ (Read64(SECRET + 24) ^ Read64(SECRET + 32));
+		uint64_t const hi  = Read64(input + len - 8) ^ (Read64(SECRET + 40) ^ Read64(SECRET + 48));
+		uint64_t const acc = len + __builtin_bswap64(lo) + hi + Mul128Fold64(lo, hi);
+		return Avalanche(acc);
+	}
+	if (len >= 4)
+	{
+		uint64_t const in1     = Read32(input);
+		uint64_t const in2     = Read32(input + len - 4);
+		uint64_t const bitflip = Read64(SECRET + 8) ^ Read64(SECRET + 16);
+		return Rrmxmx((in2 + (in1 << 32)) ^ bitflip, len);
+	}
+	if (len > 0)
+	{
+		uint32_t const combined = (static_cast<uint32_t>(input[0])        << 16)
+		                        | (static_cast<uint32_t>(input[len >> 1]) << 24)
+		                        | (static_cast<uint32_t>(input[len - 1]))
+		                        | (static_cast<uint32_t>(len)             <<  8);
+		uint64_t const bitflip  = Read32(SECRET) ^ Read32(SECRET + 4);
+		return Xxh64Avalanche(combined ^ bitflip);
+	}
+	return Xxh64Avalanche(Read64(SECRET + 56) ^ Read64(SECRET + 64));
+}
+
+
+
+hash128_t
+Hash128Short(uint8_t const* input, std::size_t len) noexcept
+{
+	if (len > 16)
+	{
+		hash128_t acc { len * PRIME64_1, 0 };
+		if (len > 128)
+		{
+			for (std::size_t i = 32; i < 160; i += 32)
+			{
+				acc = Mix32B(acc, input + i - 32, input + i - 16, SECRET + i - 32);
+			}
+			acc.low  = Avalanche(acc.low);
+			acc.high = Avalanche(acc.high);
+			for (std::size_t i = 160; i <= len; i += 32)
+			{
+				acc = Mix32B(acc, input + i - 32, input + i - 16,
+				             SECRET + MIDSIZE_STARTOFFSET + i - 160);
+			}
+			acc = Mix32B(acc, input + len - 16, input + len - 32,
+			             SECRET + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16);
+		}
+		else
+		{
+			if (len > 32)
+			{
+				if (len > 64)
+				{
+					if (len > 96)
+					{
+						acc = Mix32B(acc, input + 48, input + len - 64, SECRET + 96);
+					}
+					acc = Mix32B(acc, input + 32, input + len - 48, SECRET + 64);
+				}
+				acc = Mix32B(acc, input + 16, input + len - 32, SECRET + 32);
+			}
+			acc = Mix32B(acc, input, input + len - 16, SECRET);
+		}
+		hash128_t h;
+		h.low  = Avalanche(acc.low + acc.high);
+		h.high = 0 - Avalanche(acc.low * PRIME64_1 + acc.high * PRIME64_4 + len * PRIME64_2);
+		return h;
+	}
+	if (len > 8)
+	{
+		uint64_t const bitflipl = Read64(SECRET + 32) ^ Read64(SECRET + 40);
+		uint64_t const bitfliph = Read64(SECRET + 48) ^ Read64(SECRET + 56);
+		uint64_t const in_lo    = Read64(input);
+		uint64_t const in_hi    = Read64(input + len - 8) ^ bitfliph;
+		hash128_t m = Mult64to128(in_lo ^ Read64(input + len - 8) ^ bitflipl, PRIME64_1);
+		m.low  += static_cast<uint64_t>(len - 1) << 54;
+		m.high += in_hi + static_cast<uint64_t>(static_cast<uint32_t>(in_hi)) * (PRIME32_2 - 1);
+		m.low  ^= __builtin_bswap64(m.high);
+
+		hash128_t h = Mult64to128(m.low, PRIME64_2);
+		h.high += m.high * PRIME64_2;
+		h.low   = Avalanche(h.low);
+		h.high  = Avalanche(h.high);
+		return h;
+	}
+	if (len >= 4)
+	{
+		uint64_t const in_lo   = Read32(input);
+		uint64_t const in_hi   = Read32(input + len - 4);
+		uint64_t const bitflip = Read64(SECRET + 16) ^ Read64(SECRET + 24);
+		hash128_t m = Mult64to128((in_lo + (in_hi << 32)) ^ bitflip, PRIME64_1 + (len << 2));
+		m.high += m.low << 1;
+		m.low  ^= m.high >> 3;
+		m.low  ^= m.low >> 35;
+		m.low  *= PRIME_MX2;
+		m.low  ^= m.low >> 28;
+		m.high  = Avalanche(m.high);
+		return m;
+	}
+	if (len > 0)
+	{
+		uint32_t const combinedl = (static_cast<uint32_t>(input[0])        << 16)
+		                         | (static_cast<uint32_t>(input[len >> 1]) << 24)
+		                         | (static_cast<uint32_t>(input[len - 1]))
+		                         | (static_cast<uint32_t>(len)             <<  8);
+		uint32_t const combinedh = Rotl32(__builtin_bswap32(combinedl), 13);
+		uint64_t const bitflipl  = Read32(SECRET)     ^ Read32(SECRET + 4);
+		uint64_t const bitfliph  = Read32(SECRET + 8) ^ Read32(SECRET + 12);
+		return { Xxh64Avalanche(combinedl ^ bitflipl), Xxh64Avalanche(combinedh ^ bitfliph) };
+	}
+	return { Xxh64Avalanche(Read64(SECRET + 64) ^ Read64(SECRET + 72)),
+	         Xxh64Avalanche(Read64(SECRET + 80) ^ Read64(SECRET + 88)) };
+}
+
+
+
+uint64_t
+MergeAccs(uint64_t const* acc, uint8_t const* secret, uint64_t start) noexcept
+{
+	uint64_t result = start;
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		result += Mul128Fold64(acc[2 * i]     ^ Read64(secret + 16 * i),
+		                       acc[2 * i + 1] ^ Read64(secret + 16 * i + 8));
+	}
+	return Avalanche(result);
+}
+
+
+
+void
+AccumulatePortable(uint64_t* acc, uint8_t const* stripes, std::size_t count, uint8_t const* secret)
+{
+	for (; count != 0; --count)
+	{
+		for (std::size_t i = 0; i < HasherXxh3::ACC_NB; ++i)
+		{
+			uint64_t const data_val = Read64(stripes + 8 * i);
+			uint64_t const data_key = data_val ^ Read64(secret + 8 * i);
+			acc[i ^ 1] += data_val;
+			acc[i]     += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+		}
+		stripes += HasherXxh3::STRIPE_LEN;
+		secret  += SECRET_CONSUME_RATE;
+	}
+}
+
+
+void
+ScramblePortable(uint64_t* acc, uint8_t const* secret)
+{
+	for (std::size_t i = 0; i < HasherXxh3::ACC_NB; ++i)
+	{
+		uint64_t a = acc[i];
+		a ^= a >> 47;
+		a ^= Read64(secret + 8 * i);
+		a *= PRIME32_1;
+		acc[i] = a;
+	}
+}
+
+
+
+#if defined(__x86_64__)
+
+// The SIMD kernels follow the reference implementation: a 32x32->64 multiply
+// of the keyed data halves plus the data of the neighbour lane.
+
+void
+AccumulateSse2(uint64_t* acc, uint8_t const* stripes, std::size_t count, uint8_t const* secret)
+{
+	__m128i* const xacc = reinterpret_cast<__m128i*>(acc);
+	for (; count != 0; --count)
+	{
+		for (std::size_t i = 0; i < HasherXxh3::STRIPE_LEN / sizeof(__m128i); ++i)
+		{
+			__m128i const data_vec = _mm_loadu_si128(reinterpret_cast<__m128i const*>(stripes) + i);
+			__m128i const key_vec  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(secret) + i);
+			__m128i const data_key = _mm_xor_si128(data_vec, key_vec);
+			__m128i const key_hi   = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+			__m128i const product  = _mm_mul_epu32(data_key, key_hi);
+			__m128i const swapped  = _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+			xacc[i] = _mm_add_epi64(_mm_add_epi64(xacc[i], swapped), product);
+		}
+		stripes += HasherXxh3::STRIPE_LEN;
+		secret  += SECRET_CONSUME_RATE;
+	}
+}
+
+
+void
+ScrambleSse2(uint64_t* acc, uint8_t const* secret)
+{
+	__m128i* const xacc  = reinterpret_cast<__m128i*>(acc);
+	__m128i const  prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+	for (std::size_t i = 0; i < HasherXxh3::STRIPE_LEN / sizeof(__m128i); ++i)
+	{
+		__m128i const key_vec = _mm_loadu_si128(reinterpret_cast<__m128i const*>(secret) + i);
+		__m128i a = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+		a = _mm_xor_si128(a, key_vec);
+		__m128i const a_hi    = _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+		__m128i const prod_lo = _mm_mul_epu32(a, prime);
+		__m128i const prod_hi = _mm_mul_epu32(a_hi, prime);
+		xacc[i] = _mm_add_epi64(prod_lo, _mm_slli_epi64(prod_hi, 32));
+	}
+}
+
+
+__attribute__((target("avx2")))
+void
+AccumulateAvx2(uint64_t* acc, uint8_t const* stripes, std::size_t count, uint8_t const* secret)
+{
+	__m256i* const xacc = reinterpret_cast<__m256i*>(acc);
+	__m256i acc0 = _mm256_load_si256(xacc);
+	__m256i acc1 = _mm256_load_si256(xacc + 1);
+	for (; count != 0; --count)
+	{
+		__m256i const data0 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(stripes));
+		__m256i const data1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(stripes) + 1);
+		__m256i const dk0   = _mm256_xor_si256(data0, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(secret)));
+		__m256i const dk1   = _mm256_xor_si256(data1, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(secret) + 1));
+		__m256i const prod0 = _mm256_mul_epu32(dk0, _mm256_shuffle_epi32(dk0, _MM_SHUFFLE(0, 3, 0, 1)));
+		__m256i const prod1 = _mm256_mul_epu32(dk1, _mm256_shuffle_epi32(dk1, _MM_SHUFFLE(0, 3, 0, 1)));
+		acc0 = _mm256_add_epi64(_mm256_add_epi64(acc0, _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1, 0, 3, 2))), prod0);
+		acc1 = _mm256_add_epi64(_mm256_add_epi64(acc1, _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1, 0, 3, 2))), prod1);
+		stripes += HasherXxh3::STRIPE_LEN;
+		secret  += SECRET_CONSUME_RATE;
+	}
+	_mm256_store_si256(xacc, acc0);
+	_mm256_store_si256(xacc + 1, acc1);
+}
+
+
+__attribute__((target("avx2")))
+void
+ScrambleAvx2(uint64_t* acc, uint8_t const* secret)
+{
+	__m256i* const xacc  = reinterpret_cast<__m256i*>(acc);
+	__m256i const  prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+	for (std::size_t i = 0; i < HasherXxh3::STRIPE_LEN / sizeof(__m256i); ++i)
+	{
+		__m256i const key_vec = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(secret) + i);
+		__m256i a = _mm256_load_si256(xacc + i);
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, key_vec);
+		__m256i const a_hi    = _mm256_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1));
+		__m256i const prod_lo = _mm256_mul_epu32(a, prime);
+		__m256i const prod_hi = _mm256_mul_epu32(a_hi, prime);
+		_mm256_store_si256(xacc + i, _mm256_add_epi64(prod_lo, _mm256_slli_epi64(prod_hi, 32)));
+	}
+}
+
+#endif // __x86_64__
+
+
+HasherXxh3::accumulate_fn_t
+SelectAccumulate()
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX2)) { return &AccumulateAvx2; }
+	if (CpuFeatures::Has(CpuFeatures::SSE2)) { return &AccumulateSse2; }
+#endif
+	return &AccumulatePortable;
+}
+
+
+HasherXxh3::scramble_fn_t
+SelectScramble()
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX2)) { return &ScrambleAvx2; }
+	if (CpuFeatures::Has(CpuFeatures::SSE2)) { return &ScrambleSse2; }
+#endif
+	return &ScramblePortable;
+}
+
+} // namespace
+
+
+
+namespace algo {
+
+HasherXxh3::HasherXxh3(hash_type_e type)
+	: m_accumulate(SelectAccumulate())
+	, m_scramble(SelectScramble())
+	, m_is128(type == hash_type_e::XXH128)
+{
+	if (type != hash_type_e::XXH3 and type != hash_type_e::XXH128)
+	{
+		THROW_ERROR("HasherXxh3::%s: unsupported hash type %s",
+		            __FUNCTION__, toString(type));
+	}
+	Init(InitHashStrategy{type});
+}
+
+
+
+int
+HasherXxh3::Init(InitHashStrategy const&)
+{
+	m_acc[0] = PRIME32_3;
+	m_acc[1] = PRIME64_1;
+	m_acc[2] = PRIME64_2;
+	m_acc[3] = PRIME64_3;
+	m_acc[4] = PRIME64_4;
+	m_acc[5] = PRIME32_2;
+	m_acc[6] = PRIME64_5;
+	m_acc[7] = PRIME32_1;
+	m_totalLen       = 0;
+	m_bufferedSize   = 0;
+	m_stripesInBlock = 0;
+	m_was_finished   = false;
+	return 0;
+}
+
+
+
+void
+HasherXxh3::ConsumeStripes(uint8_t const* stripes, std::size_t count)
+{
+	while (count != 0)
+	{
+		std::size_t const n = std::min(count, STRIPES_PER_BLOCK - m_stripesInBlock);
+		m_accumulate(m_acc, stripes, n, SECRET + m_stripesInBlock * SECRET_CONSUME_RATE);
+		m_stripesInBlock += n;
+		if (m_stripesInBlock == STRIPES_PER_BLOCK)
+		{
+			m_scramble(m_acc, SECRET + SECRET_SIZE - STRIPE_LEN);
+			m_stripesInBlock = 0;
+		}
+		stripes += n * STRIPE_LEN;
+		count   -= n;
+	}
+}
+
+
+
+int
+HasherXxh3::Update(uint8_t const* input, std::size_t inputLen)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherXxh3::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+	m_totalLen += inputLen;
+	if (m_bufferedSize + inputLen <= BUFFER_SIZE)
+	{
+		std::memcpy(m_buffer + m_bufferedSize, input, inputLen);
+		m_bufferedSize += inputLen;
+		return 0;
+	}
+
+	//NOTE: the last stripe is always kept (in the buffer) because it is
+	// processed with the special secret in `Finish`.
+	if (m_bufferedSize != 0)
+	{
+		std::size_t const fill = BUFFER_SIZE - m_bufferedSize;
+		std::memcpy(m_buffer + m_bufferedSize, input, fill);
+		ConsumeStripes(m_buffer, BUFFER_SIZE / STRIPE_LEN);
+		input    += fill;
+		inputLen -= fill;
+		m_bufferedSize = 0;
+	}
+	if (inputLen > BUFFER_SIZE)
+	{
+		std::size_t const stripes = (inputLen - 1) / STRIPE_LEN;
+		ConsumeStripes(input, stripes);
+		input    += stripes * STRIPE_LEN;
+		inputLen -= stripes * STRIPE_LEN;
+		// `Finish` takes the tail of the last stripe from the buffer end
+		std::memcpy(m_buffer + BUFFER_SIZE - STRIPE_LEN, input - STRIPE_LEN, STRIPE_LEN);
+	}
+	std::memcpy(m_buffer, input, inputLen);
+	m_bufferedSize = inputLen;
+	return 0;
+}
+
+
+
+void
+HasherXxh3::DigestLong()
+{
+	alignas(64) uint8_t last_stripe[STRIPE_LEN];
+	uint8_t const* last_stripe_ptr = nullptr;
+	if (m_bufferedSize >= STRIPE_LEN)
+	{
+		ConsumeStripes(m_buffer, (m_bufferedSize - 1) / STRIPE_LEN);
+		last_stripe_ptr = m_buffer + m_bufferedSize - STRIPE_LEN;
+	}
+	else
+	{
+		std::size_t const catchup = STRIPE_LEN - m_bufferedSize;
+		std::memcpy(last_stripe, m_buffer + BUFFER_SIZE - catchup, catchup);
+		std::memcpy(last_stripe + catchup, m_buffer, m_bufferedSize);
+		last_stripe_ptr = last_stripe;
+	}
+	m_accumulate(m_acc, last_stripe_ptr, 1, SECRET + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC);
+}
+
+
+
+int
+HasherXxh3::Finish(uint8_t* buffer)
+{
+	if (m_was_finished)
+	{
+		THROW_ERROR("HasherXxh3::%s: hasher was finished "
+		            "and MUST BE initialized for reusing!",
+		            __FUNCTION__);
+	}
+
+	hash128_t h {0, 0};
+	if (m_totalLen <= MIDSIZE_MAX)
+	{
+		if (m_is128) { h = Hash128Short(m_buffer, m_bufferedSize); }
+		else         { h.low = Hash64Short(m_buffer, m_bufferedSize); }
+	}
+	else
+	{
+		DigestLong();
+		h.low = MergeAccs(m_acc, SECRET + SECRET_MERGEACCS, m_totalLen * PRIME64_1);
+		if (m_is128)
+		{
+			h.high = MergeAccs(m_acc, SECRET + SECRET_SIZE - sizeof(m_acc) - SECRET_MERGEACCS,
+			                   ~(m_totalLen * PRIME64_2));
+		}
+	}
+
+	if (m_is128)
+	{
+		StoreBe64(buffer,     h.high);
+		StoreBe64(buffer + 8, h.low);
+	}
+	else
+	{
+		StoreBe64(buffer, h.low);
+	}
+
+	m_was_finished = true;
+	return 0;
+}
+
+
+
+std::size_t
+HasherXxh3::ResultSize() const
+{
+	return m_is128 ? 16 : 8;
+}
+
+
+
+char const*
+HasherXxh3::KernelName() const
+{
+	if (m_accumulate == &AccumulatePortable) { return "portable"; }
+	return (m_accumulate == &AccumulateSse2) ? "sse2" : "avx2";
+}
+
+} // namespace algo
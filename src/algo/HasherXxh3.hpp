@@ -0,0 +1,82 @@
+#pragma once
+
+
+#include "IHasher.hpp"
+
+
+
+namespace algo {
+
+class InitXxh3HashStrategy : public InitHashStrategy
+{
+public:
+	InitXxh3HashStrategy()
+		: InitHashStrategy(hash_type_e::XXH3)
+	{}
+
+private:
+};
+
+
+
+class InitXxh128HashStrategy : public InitHashStrategy
+{
+public:
+	InitXxh128HashStrategy()
+		: InitHashStrategy(hash_type_e::XXH128)
+	{}
+
+private:
+};
+
+
+
+// XXH3 64 and 128 bits (xxHash v0.8) with the default secret and zero seed.
+// It is non-cryptographic: use it for change detection only. The digest is
+// stored in big-endian order, the same as `xxhsum` prints it.
+class HasherXxh3 final : public IHasher
+{
+public:
+	static constexpr std::size_t STRIPE_LEN  = 64;
+	static constexpr std::size_t ACC_NB      = STRIPE_LEN / sizeof(uint64_t);
+	static constexpr std::size_t SECRET_SIZE = 192;
+	static constexpr std::size_t BUFFER_SIZE = 256;
+
+	// Accumulates `count` stripes, the secret is shifted by 8 bytes per stripe
+	using accumulate_fn_t = void (*)(uint64_t* acc, uint8_t const* stripes,
+	                                 std::size_t count, uint8_t const* secret);
+	using scramble_fn_t   = void (*)(uint64_t* acc, uint8_t const* secret);
+
+	HasherXxh3(HasherXxh3&&)                 = delete;
+	HasherXxh3(HasherXxh3 const&)            = delete;
+	HasherXxh3& operator=(HasherXxh3&&)      = delete;
+	HasherXxh3& operator=(HasherXxh3 const&) = delete;
+
+	// `type` is either hash_type_e::XXH3 or hash_type_e::XXH128
+	explicit HasherXxh3(hash_type_e type = hash_type_e::XXH3);
+	~HasherXxh3() = default;
+
+	// IHasher
+	int Init(InitHashStrategy const&) override;
+	int Update(uint8_t const*, std::size_t) override;
+	int Finish(uint8_t*) override;
+	std::size_t ResultSize() const override;
+	char const* KernelName() const override;
+
+private:
+	void ConsumeStripes(uint8_t const* stripes, std::size_t count);
+	void DigestLong();
+
+private:
+	alignas(64) uint64_t m_acc[ACC_NB];
+	alignas(64) uint8_t  m_buffer[BUFFER_SIZE];
+	uint64_t             m_totalLen       = 0;
+	std::size_t          m_bufferedSize   = 0;
+	std::size_t          m_stripesInBlock = 0;
+	accumulate_fn_t      m_accumulate;
+	scramble_fn_t        m_scramble;
+	bool                 m_is128;
+	bool                 m_was_finished   = false;
+};
+
+} // namespace algo
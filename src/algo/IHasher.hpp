@@ -10,17 +10,45 @@ namespace algo {
 
 struct IHasher
 {
+	virtual ~IHasher() = default;
+
 	virtual int Init(InitHashStrategy const&)       = 0;
 	virtual int Update(uint8_t const*, std::size_t) = 0;
 	virtual int Finish(uint8_t*)                    = 0;
 	virtual std::size_t ResultSize() const          = 0;
+	// The name of the kernel selected for the current CPU (e.g. "avx2")
+	virtual char const* KernelName() const          { return "portable"; }
+
+	// A splittable hasher can compute a block by parts: each part is hashed
+	// independently (`InitPart`, `FinishPart`) and the results of all parts
+	// are merged into the block digest by `CombineParts`. All parts except
+	// the last one have the same size.
+	virtual bool IsSplittable() const               { return false; }
+	// Returns the part size (not greater than `part_size`) that is supported
+	// by `CombineParts`
+	virtual std::uint64_t AlignPartSize(std::uint64_t part_size) const { return part_size; }
+	// `offset` is the position of the part inside the block
+	virtual int InitPart(InitHashStrategy const& s, std::uint64_t /*offset*/) { return Init(s); }
+	virtual std::size_t PartResultSize() const      { return ResultSize(); }
+	virtual int FinishPart(uint8_t* part_result)    { return Finish(part_result); }
+	virtual int CombineParts(uint8_t const* /*parts_result*/,
+	                         std::size_t    /*parts_count*/,
+	                         std::uint64_t  /*part_size*/,
+	                         std::uint64_t  /*last_part_size*/,
+	                         uint8_t*       /*result*/)
+	{
+		return -1;
+	}
 
-	int Update(uint8_t ch, std::size_t num_repeats = 1)
+	// Hashes `count` copies of the byte `ch` (e.g. the filler of the last
+	// block). The digest is the same as for `Update` of such data, but the
+	// hashers can do it faster than byte by byte.
+	virtual int UpdateFill(uint8_t ch, std::uint64_t count)
 	{
-		std::array<uint8_t, 256> filler;
+		std::array<uint8_t, 4096> filler;
 		filler.fill(ch);
 
-		std::size_t remains = num_repeats;
+		std::uint64_t remains = count;
 		while (remains > filler.size())
 		{
 			Update(filler.data(), filler.size());
@@ -28,7 +56,25 @@ struct IHasher
 		}
 		if (remains > 0)
 		{
-			Update(filler.data(), remains);
+			Update(filler.data(), static_cast<std::size_t>(remains));
+		}
+		return 0;
+	}
+
+	int Update(uint8_t ch, std::size_t num_repeats = 1) { return UpdateFill(ch, num_repeats); }
+
+	// Hashes `count` independent messages of `size` bytes: the digest of
+	// `inputs[i]` is written to `results[i]`. The hashers can do it faster
+	// than one by one (e.g. by the multi-buffer kernels).
+	virtual int HashBatch(InitHashStrategy const& s,
+	                      uint8_t const* const* inputs, std::size_t size,
+	                      uint8_t* const* results, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Init(s);
+			Update(inputs[i], size);
+			Finish(results[i]);
 		}
 		return 0;
 	}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "HasherFactory.hpp"
+#include "IHasher.hpp"
+
+namespace algo {
+
+// Multi-buffer hasher: computes `Lanes()` independent digests at once. Every
+// lane receives the same number of bytes on each `Update`, so one SIMD kernel
+// can process the lanes in lockstep.
+struct IMultiHasher
+{
+	virtual ~IMultiHasher() = default;
+
+	virtual std::size_t Lanes() const                                 = 0;
+	virtual int Init(InitHashStrategy const&)                         = 0;
+	virtual int Update(uint8_t const* const* lanes_data, std::size_t) = 0;
+	virtual int Finish(uint8_t* const* lanes_result)                  = 0;
+	virtual std::size_t ResultSize() const                            = 0;
+	// The name of the SIMD kernel selected for the current CPU (e.g. "avx2")
+	virtual char const* KernelName() const                            = 0;
+};
+
+
+
+// Hashes the batch of messages (see IHasher::HashBatch) by the groups of
+// `multi.Lanes()` messages; the rest of them are hashed by `single`.
+inline int
+HashBatchByLanes(IMultiHasher& multi, IHasher& single, InitHashStrategy const& s,
+                 uint8_t const* const* inputs, std::size_t size,
+                 uint8_t* const* results, std::size_t count)
+{
+	std::size_t const lanes = multi.Lanes();
+	std::size_t i = 0;
+	for (; i + lanes <= count; i += lanes)
+	{
+		multi.Init(s);
+		multi.Update(inputs + i, size);
+		multi.Finish(results + i);
+	}
+	for (; i < count; ++i)
+	{
+		single.Init(s);
+		single.Update(inputs[i], size);
+		single.Finish(results[i]);
+	}
+	return 0;
+}
+
+} // namespace algo
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+namespace algo {
+
+// The weak rolling checksum of rsync (an Adler-32 variant):
+//   a = sum(x[i]), b = sum((n - i) * x[i]), digest = a | b << 16 (mod 2^16).
+// The window can be moved by one byte in O(1) (see Roll), so the checksum of
+// every offset of a file is cheap; the matches are confirmed by the strong
+// signature.
+class Rollsum
+{
+public:
+	void Reset() noexcept { m_a = 0; m_b = 0; m_count = 0; }
+
+	void Update(uint8_t const* data, std::size_t size) noexcept
+	{
+		uint32_t a = m_a;
+		uint32_t b = m_b;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			a += data[i];
+			b += a;
+		}
+		m_a = a;
+		m_b = b;
+		m_count += size;
+	}
+
+	// The same as Update by `count` bytes equal to `ch`
+	void UpdateFill(uint8_t ch, std::uint64_t count) noexcept
+	{
+		m_b += static_cast<uint32_t>(count * m_a + ch * (count * (count + 1) / 2));
+		m_a += static_cast<uint32_t>(count * ch);
+		m_count += count;
+	}
+
+	// Moves the window: `out` leaves it, `in` enters it
+	void Roll(uint8_t out, uint8_t in) noexcept
+	{
+		m_a += in - out;
+		m_b += m_a - static_cast<uint32_t>(m_count * out);
+	}
+
+	uint32_t Digest() const noexcept { return (m_a & 0xFFFF) | (m_b << 16); }
+
+private:
+	uint32_t      m_a     = 0;
+	uint32_t      m_b     = 0;
+	std::uint64_t m_count = 0; // the window size
+};
+
+} // namespace algo
@@ -0,0 +1,99 @@
+#pragma once
+
+#if defined(__x86_64__)
+
+//NOTE: GCC 12 reports false "(maybe-)uninitialized" for `_mm512_undefined_*`
+// inside AVX-512 intrinsics (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+#include <cstddef>
+
+
+
+// Transposes of 32-bit word matrices used by the multi-buffer kernels to turn
+// rows of the lanes' data into rows of the same word of all lanes.
+namespace algo::simd {
+
+// Transposes 4x4 matrix of 32-bit words: rows[lane] -> rows[word]
+__attribute__((target("sse2")))
+inline void
+Transpose4x4(__m128i r[4])
+{
+	__m128i const t0 = _mm_unpacklo_epi32(r[0], r[1]);
+	__m128i const t1 = _mm_unpackhi_epi32(r[0], r[1]);
+	__m128i const t2 = _mm_unpacklo_epi32(r[2], r[3]);
+	__m128i const t3 = _mm_unpackhi_epi32(r[2], r[3]);
+	r[0] = _mm_unpacklo_epi64(t0, t2);
+	r[1] = _mm_unpackhi_epi64(t0, t2);
+	r[2] = _mm_unpacklo_epi64(t1, t3);
+	r[3] = _mm_unpackhi_epi64(t1, t3);
+}
+
+
+// Transposes 8x8 matrix of 32-bit words: rows[lane] -> rows[word]
+__attribute__((target("avx2")))
+inline void
+Transpose8x8(__m256i r[8])
+{
+	__m256i t[8];
+	for (std::size_t i = 0; i < 8; i += 2)
+	{
+		t[i]     = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	__m256i u[8];
+	for (std::size_t i = 0; i < 8; i += 4)
+	{
+		u[i]     = _mm256_unpacklo_epi64(t[i],     t[i + 2]);
+		u[i + 1] = _mm256_unpackhi_epi64(t[i],     t[i + 2]);
+		u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	for (std::size_t j = 0; j < 4; ++j)
+	{
+		r[j]     = _mm256_permute2x128_si256(u[j], u[j + 4], 0x20);
+		r[j + 4] = _mm256_permute2x128_si256(u[j], u[j + 4], 0x31);
+	}
+}
+
+
+// Transposes 16x16 matrix of 32-bit words: rows[lane] -> rows[word]
+__attribute__((target("avx512f")))
+inline void
+Transpose16x16(__m512i r[16])
+{
+	__m512i t[16];
+	for (std::size_t i = 0; i < 16; i += 2)
+	{
+		t[i]     = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	// u[4*i + j] holds the words (4*k + j) of rows 4*i..4*i+3 in 128-bit lane k
+	__m512i u[16];
+	for (std::size_t i = 0; i < 16; i += 4)
+	{
+		u[i]     = _mm512_unpacklo_epi64(t[i],     t[i + 2]);
+		u[i + 1] = _mm512_unpackhi_epi64(t[i],     t[i + 2]);
+		u[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+		u[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	for (std::size_t j = 0; j < 4; ++j)
+	{
+		__m512i const v02_01 = _mm512_shuffle_i32x4(u[j],     u[j + 4],  0x88);
+		__m512i const v13_01 = _mm512_shuffle_i32x4(u[j],     u[j + 4],  0xDD);
+		__m512i const v02_23 = _mm512_shuffle_i32x4(u[j + 8], u[j + 12], 0x88);
+		__m512i const v13_23 = _mm512_shuffle_i32x4(u[j + 8], u[j + 12], 0xDD);
+		r[j]      = _mm512_shuffle_i32x4(v02_01, v02_23, 0x88);
+		r[j + 4]  = _mm512_shuffle_i32x4(v13_01, v13_23, 0x88);
+		r[j + 8]  = _mm512_shuffle_i32x4(v02_01, v02_23, 0xDD);
+		r[j + 12] = _mm512_shuffle_i32x4(v13_01, v13_23, 0xDD);
+	}
+}
+
+} // namespace algo::simd
+
+#endif // __x86_64__
@@ -0,0 +1,333 @@
+// Micro-benchmark of the hashers. Every algorithm of HasherFactory is measured
+// with every implementation that the runtime dispatch can select on this CPU
+// (see HasherFactory::Implementations): the kernels are reached by hiding the
+// CPU features (see CpuFeatures::Restrict). The data is hashed through the
+// real Init/Update/Finish interface by the chunks of the Worker's read buffer.
+//
+// Usage: signature_bench_hashers [-a ALGO]... [-t MIN_MS] [-s MAX_SIZE]
+//   -a ALGO      measure only the algorithm (e.g. md5, xxh3); can be repeated
+//   -t MIN_MS    the minimal duration of one measurement (default: 100)
+//   -s MAX_SIZE  the maximal buffer size in bytes (default: 64 MiB)
+
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "common/CpuFeatures.hpp"
+#include "algo/HasherFactory.hpp"
+#include "algo/IHasher.hpp"
+#include "algo/IMultiHasher.hpp"
+#include "Config.hpp"
+
+
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::size_t MIN_SIZE         = 64;
+constexpr std::size_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+constexpr unsigned    DEFAULT_MIN_MS   = 100;
+constexpr std::size_t CHUNK_SIZE       = Config::Default_s::READ_BUF_SIZE;
+
+constexpr algo::hash_type_e ALGORITHMS[] = {
+	algo::hash_type_e::MD5,
+	algo::hash_type_e::CRC32,
+	algo::hash_type_e::CRC32C,
+	algo::hash_type_e::XXH3,
+	algo::hash_type_e::XXH128,
+	algo::hash_type_e::BLAKE3,
+	algo::hash_type_e::SHA256,
+};
+
+struct Options
+{
+	std::vector<std::string> algos;
+	unsigned                 min_ms   = DEFAULT_MIN_MS;
+	std::size_t              max_size = DEFAULT_MAX_SIZE;
+};
+
+
+struct Variant
+{
+	algo::HasherImpl const* impl;
+	std::size_t             lanes;
+};
+
+
+struct Measure
+{
+	double seconds = 0;
+	double cycles  = 0;
+	uint64_t bytes = 0;
+};
+
+
+inline uint64_t
+ReadCycles()
+{
+#if defined(__x86_64__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+
+bool
+EqualNoCase(std::string_view a, std::string_view b)
+{
+	return a.size() == b.size()
+		and std::equal(a.begin(), a.end(), b.begin(),
+			[](char x, char y) { return std::tolower(x) == std::tolower(y); });
+}
+
+
+bool
+ParseArgs(int argc, char** argv, Options& opts)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view const key = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::fprintf(stderr, "missing value of the option %s\n", argv[i]);
+			return false;
+		}
+		std::string_view const val = argv[++i];
+		if (key == "-a")
+		{
+			opts.algos.emplace_back(val);
+			continue;
+		}
+
+		uint64_t num = 0;
+		auto const res = std::from_chars(val.data(), val.data() + val.size(), num);
+		if (res.ec != std::errc{} or res.ptr != val.data() + val.size() or num == 0)
+		{
+			std::fprintf(stderr, "invalid value of the option %s\n", argv[i - 1]);
+			return false;
+		}
+		if      (key == "-t") { opts.min_ms   = static_cast<unsigned>(num); }
+		else if (key == "-s") { opts.max_size = std::max<std::size_t>(num, MIN_SIZE); }
+		else
+		{
+			std::fprintf(stderr, "unknown option %s\n", argv[i - 1]);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool
+IsSelected(Options const& opts, algo::hash_type_e type)
+{
+	return opts.algos.empty()
+		or std::any_of(opts.algos.begin(), opts.algos.end(),
+			[type](std::string const& a) { return EqualNoCase(a, toString(type)); });
+}
+
+
+// Finds the implementations of the algorithm which are supported by the CPU
+// and pass the self-test
+void
+CollectVariants(algo::hash_type_e type, std::vector<Variant>& variants)
+{
+	algo::InitHashStrategy const strategy(type);
+	for (algo::HasherImpl const* impl : algo::HasherFactory::Implementations(type))
+	{
+		if (not algo::HasherFactory::IsSupported(*impl)) { continue; }
+		if (not algo::HasherFactory::SelfTest(*impl))
+		{
+			std::fprintf(stderr, "%s %s failed the self-test\n", toString(type), impl->name);
+			continue;
+		}
+
+		std::size_t lanes = 1;
+		if (impl->multi)
+		{
+			CpuFeatures::Restrict(impl->features);
+			lanes = algo::HasherFactory::CreateMulti(strategy)->Lanes();
+			CpuFeatures::Restrict(CpuFeatures::ALL);
+		}
+		variants.push_back({impl, lanes});
+	}
+}
+
+
+// Repeats the hashing of `size` bytes per lane until `min_ms` is passed
+template <typename HashOnce>
+Measure
+Run(HashOnce&& hash_once, uint64_t bytes_per_run, unsigned min_ms)
+{
+	auto const min_duration = std::chrono::milliseconds(min_ms);
+	hash_once(); // warm up the caches and the kernel
+
+	Measure m;
+	uint64_t runs = 1;
+	auto const start = clock_type::now();
+	uint64_t const start_cycles = ReadCycles();
+	for (;;)
+	{
+		for (uint64_t r = 0; r < runs; ++r) { hash_once(); }
+		m.bytes += runs * bytes_per_run;
+		if (clock_type::now() - start >= min_duration) { break; }
+		runs *= 2;
+	}
+	m.cycles  = static_cast<double>(ReadCycles() - start_cycles);
+	m.seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+	return m;
+}
+
+
+Measure
+MeasureSingle(Variant const& v, uint8_t const* data, std::size_t size, unsigned min_ms)
+{
+	algo::InitHashStrategy const strategy(v.impl->type);
+	CpuFeatures::Restrict(v.impl->features);
+	auto const hasher = algo::HasherFactory::Create(strategy);
+	CpuFeatures::Restrict(CpuFeatures::ALL);
+
+	std::vector<uint8_t> result(hasher->ResultSize());
+	return Run([&]()
+		{
+			hasher->Init(strategy);
+			for (std::size_t off = 0; off < size; off += CHUNK_SIZE)
+			{
+				hasher->Update(data + off, std::min(CHUNK_SIZE, size - off));
+			}
+			hasher->Finish(result.data());
+		},
+		size, min_ms);
+}
+
+
+//NOTE: the lanes read the same buffer shifted by CHUNK_SIZE bytes, so the
+// large sizes are measured on the data shared by all lanes
+Measure
+MeasureMulti(Variant const& v, uint8_t const* data, std::size_t size, unsigned min_ms)
+{
+	algo::InitHashStrategy const strategy(v.impl->type);
+	CpuFeatures::Restrict(v.impl->features);
+	auto const hasher = algo::HasherFactory::CreateMulti(strategy);
+	CpuFeatures::Restrict(CpuFeatures::ALL);
+
+	std::size_t const lanes = hasher->Lanes();
+	std::vector<uint8_t> result(lanes * hasher->ResultSize());
+	std::vector<uint8_t*> lanes_result;
+	std::vector<uint8_t const*> lanes_data(lanes);
+	for (std::size_t l = 0; l < lanes; ++l)
+	{
+		lanes_result.push_back(result.data() + l * hasher->ResultSize());
+	}
+	return Run([&]()
+		{
+			hasher->Init(strategy);
+			for (std::size_t off = 0; off < size; off += CHUNK_SIZE)
+			{
+				for (std::size_t l = 0; l < lanes; ++l)
+				{
+					lanes_data[l] = data + l * CHUNK_SIZE + off;
+				}
+				hasher->Update(lanes_data.data(), std::min(CHUNK_SIZE, size - off));
+			}
+			hasher->Finish(lanes_result.data());
+		},
+		lanes * size, min_ms);
+}
+
+
+void
+PrintFeatures()
+{
+	std::printf("CPU features:");
+	uint32_t const detected = CpuFeatures::Detected();
+	for (uint32_t bit = 1; bit != 0; bit <<= 1)
+	{
+		if (detected & bit)
+		{
+			std::printf(" %s", toString(static_cast<CpuFeatures::feature_e>(bit)));
+		}
+	}
+	std::printf("\n");
+}
+
+
+void
+PrintSize(std::size_t size)
+{
+	char buffer[32];
+	if      (size % (1024 * 1024) == 0) { std::snprintf(buffer, sizeof(buffer), "%zuM", size >> 20); }
+	else if (size % 1024 == 0)          { std::snprintf(buffer, sizeof(buffer), "%zuK", size >> 10); }
+	else                                { std::snprintf(buffer, sizeof(buffer), "%zu",  size); }
+	std::printf("%8s", buffer);
+}
+
+} // namespace
+
+
+
+int
+main(int argc, char** argv)
+{
+	Options opts;
+	if (not ParseArgs(argc, argv, opts))
+	{
+		std::fprintf(stderr, "Usage: %s [-a ALGO]... [-t MIN_MS] [-s MAX_SIZE]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<Variant> variants;
+	for (algo::hash_type_e type : ALGORITHMS)
+	{
+		if (IsSelected(opts, type)) { CollectVariants(type, variants); }
+	}
+	if (variants.empty())
+	{
+		std::fprintf(stderr, "there is no algorithm to measure\n");
+		return 1;
+	}
+
+	std::size_t max_lanes = 1;
+	for (Variant const& v : variants) { max_lanes = std::max(max_lanes, v.lanes); }
+	std::vector<uint8_t> data(opts.max_size + max_lanes * CHUNK_SIZE);
+	uint32_t seed = 0x9E3779B9;
+	for (uint8_t& b : data)
+	{
+		seed = seed * 1664525 + 1013904223;
+		b = static_cast<uint8_t>(seed >> 24);
+	}
+
+	PrintFeatures();
+	std::printf("%-8s %-9s %5s %8s %10s %9s\n",
+	            "ALGO", "IMPL", "LANES", "SIZE", "CYCLES/B", "GB/s");
+	for (Variant const& v : variants)
+	{
+		for (std::size_t size = MIN_SIZE; size <= opts.max_size; size *= 4)
+		{
+			Measure const m = v.impl->multi
+				? MeasureMulti(v, data.data(), size, opts.min_ms)
+				: MeasureSingle(v, data.data(), size, opts.min_ms);
+			std::printf("%-8s %-9s %5zu ", toString(v.impl->type), v.impl->name, v.lanes);
+			PrintSize(size);
+			std::printf(" %10.3f %9.3f\n",
+			            m.cycles / static_cast<double>(m.bytes),
+			            static_cast<double>(m.bytes) / m.seconds / 1e9);
+			std::fflush(stdout);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include "CpuFeatures.hpp"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+
+
+char const*
+toString(CpuFeatures::feature_e v)
+{
+	switch (v)
+	{
+	case CpuFeatures::NONE:     return "NONE";
+	case CpuFeatures::SSE2:     return "SSE2";
+	case CpuFeatures::SSSE3:    return "SSSE3";
+	case CpuFeatures::SSE41:    return "SSE4.1";
+	case CpuFeatures::SSE42:    return "SSE4.2";
+	case CpuFeatures::PCLMUL:   return "PCLMUL";
+	case CpuFeatures::AVX2:     return "AVX2";
+	case CpuFeatures::BMI2:     return "BMI2";
+	case CpuFeatures::AVX512F:  return "AVX512F";
+	case CpuFeatures::AVX512BW: return "AVX512BW";
+	case CpuFeatures::AVX512VL: return "AVX512VL";
+	case CpuFeatures::SHA:      return "SHA";
+	}
+	return "?";
+}
+
+
+
+namespace {
+
+std::atomic<uint32_t> g_restrict_mask {CpuFeatures::ALL};
+
+} // namespace
+
+
+
+// static
+uint32_t
+CpuFeatures::Get() noexcept
+{
+	return Detected() & g_restrict_mask.load(std::memory_order_relaxed);
+}
+
+
+
+// static
+uint32_t
+CpuFeatures::Detected() noexcept
+{
+	static uint32_t const features = Detect();
+	return features;
+}
+
+
+
+// static
+void
+CpuFeatures::Restrict(uint32_t mask) noexcept
+{
+	g_restrict_mask.store(mask, std::memory_order_relaxed);
+}
+
+
+
+// static
+uint32_t
+CpuFeatures::Detect() noexcept
+{
+	uint32_t res = NONE;
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (not __get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return res; }
+
+	if (edx & (1u << 26)) { res |= SSE2; }
+	if (ecx & (1u <<  9)) { res |= SSSE3; }
+	if (ecx & (1u << 19)) { res |= SSE41; }
+	if (ecx & (1u << 20)) { res |= SSE42; }
+	if (ecx & (1u <<  1)) { res |= PCLMUL; }
+
+	//NOTE: AVX* registers are usable only if OS saves them on context switch
+	bool const os_xsave = ecx & (1u << 27);
+	uint64_t xcr0 = 0;
+	if (os_xsave)
+	{
+		uint32_t xcr0_lo = 0, xcr0_hi = 0;
+		__asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+		xcr0 = (static_cast<uint64_t>(xcr0_hi) << 32) | xcr0_lo;
+	}
+	bool const os_avx    = (xcr0 & 0x06) == 0x06; // XMM | YMM
+	bool const os_avx512 = (xcr0 & 0xE6) == 0xE6; // XMM | YMM | OPMASK | ZMM
+
+	if (not __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) { return res; }
+
+	if (ebx & (1u <<  8)) { res |= BMI2; }
+	if (ebx & (1u << 29)) { res |= SHA; }
+	if (os_avx and (ebx & (1u << 5))) { res |= AVX2; }
+	if (os_avx512)
+	{
+		if (ebx & (1u << 16)) { res |= AVX512F; }
+		if (ebx & (1u << 30)) { res |= AVX512BW; }
+		if (ebx & (1u << 31)) { res |= AVX512VL; }
+	}
+#endif
+	return res;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+
+
+class CpuFeatures
+{
+public:
+	enum feature_e : uint32_t
+	{
+		NONE      = 0,
+		SSE2      = 1u << 0,
+		SSSE3     = 1u << 1,
+		SSE41     = 1u << 2,
+		SSE42     = 1u << 3,
+		PCLMUL    = 1u << 4,
+		AVX2      = 1u << 5,
+		BMI2      = 1u << 6,
+		AVX512F   = 1u << 7,
+		AVX512BW  = 1u << 8,
+		AVX512VL  = 1u << 9,
+		SHA       = 1u << 10,
+	};
+
+	CpuFeatures()                              = delete;
+
+	//NOTE: the detection is made once (on the first call) and is thread safe
+	static uint32_t Get() noexcept;
+	static bool Has(uint32_t features) noexcept { return (Get() & features) == features; }
+
+	// Hides the features that are not in `mask` (the hashers created later
+	// select the kernels without them). It is used to select an
+	// implementation of the algorithm (see HasherFactory::SelectImpl) and to
+	// measure each kernel on the same CPU; `Restrict(ALL)` cancels it.
+	static void Restrict(uint32_t mask) noexcept;
+	static uint32_t Detected() noexcept;
+
+	static constexpr uint32_t ALL = ~0u;
+
+private:
+	static uint32_t Detect() noexcept;
+};
+
+char const* toString(CpuFeatures::feature_e);
@@ -0,0 +1,121 @@
+#include "DirectFile.hpp"
+
+#include <algorithm>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Logger.hpp"
+
+
+
+namespace {
+
+constexpr std::size_t BUFFER_SIZE = DirectFile::MAX_VIEW + 2 * DirectFile::ALIGNMENT;
+
+
+
+constexpr std::uint64_t
+AlignDown(std::uint64_t v) noexcept
+{
+	return v - v % DirectFile::ALIGNMENT;
+}
+
+
+
+constexpr std::uint64_t
+AlignUp(std::uint64_t v) noexcept
+{
+	return AlignDown(v + DirectFile::ALIGNMENT - 1);
+}
+
+} // namespace
+
+
+
+DirectFile::DirectFile(char const* name)
+	: m_name(name)
+{
+	m_fd = ::open(m_name, O_RDONLY | O_CLOEXEC | O_DIRECT);
+	if (m_fd < 0 and errno == EINVAL)
+	{
+		LOG_W("%s: O_DIRECT isn't supported for [%s], the page cache is used",
+		      __FUNCTION__, m_name);
+		m_fd = ::open(m_name, O_RDONLY | O_CLOEXEC);
+	}
+	if (m_fd < 0)
+	{
+		THROW_ERROR("%s: can't open [%s]: %s", __FUNCTION__, m_name, std::strerror(errno));
+	}
+
+	struct stat st {};
+	if (::fstat(m_fd, &st) != 0)
+	{
+		int const err = errno;
+		::close(m_fd);
+		THROW_ERROR("%s: can't get the size of [%s]: %s", __FUNCTION__, m_name, std::strerror(err));
+	}
+	m_size = static_cast<std::uint64_t>(st.st_size);
+
+	m_buffer = static_cast<uint8_t*>(std::aligned_alloc(ALIGNMENT, BUFFER_SIZE));
+	if (not m_buffer)
+	{
+		::close(m_fd);
+		THROW_ERROR("%s: can't allocate %zu bytes", __FUNCTION__, BUFFER_SIZE);
+	}
+}
+
+
+DirectFile::~DirectFile()
+{
+	std::free(m_buffer);
+	::close(m_fd);
+}
+
+
+std::size_t
+DirectFile::View(uint8_t const*& data, std::uint64_t offset, std::size_t size)
+{
+	if (offset >= m_size) { return 0; }
+	std::uint64_t const end = std::min<std::uint64_t>(offset + size, m_size);
+	if (offset < m_begin or end > m_end) { Fill(offset, end); }
+	data = m_buffer + (offset - m_begin);
+	return static_cast<std::size_t>(end - offset);
+}
+
+
+// Reads the aligned range which covers [begin, end): the last read of the
+// file is short (the unaligned tail)
+void
+DirectFile::Fill(std::uint64_t begin, std::uint64_t end)
+{
+	m_begin = AlignDown(begin);
+	m_end   = m_begin;
+	std::size_t const length = static_cast<std::size_t>(AlignUp(end) - m_begin);
+	for (std::size_t done = 0; done < length; )
+	{
+		ssize_t const read_bytes = ::pread(m_fd, m_buffer + done, length - done,
+		                                   static_cast<off_t>(m_begin + done));
+		if (read_bytes < 0)
+		{
+			if (errno == EINTR) { continue; }
+			THROW_ERROR("%s: can't read [%s] at %ju: %s",
+				__FUNCTION__, m_name, m_begin + done, std::strerror(errno));
+		}
+		if (read_bytes == 0) { break; }
+		done  += static_cast<std::size_t>(read_bytes);
+		m_end += static_cast<std::uint64_t>(read_bytes);
+		//NOTE: an unaligned short read is the end of the file
+		if (done % ALIGNMENT != 0) { break; }
+	}
+	if (m_end < end)
+	{
+		THROW_ERROR("%s: unexpected end of [%s] at %ju (expected %ju)",
+			__FUNCTION__, m_name, m_end, end);
+	}
+}
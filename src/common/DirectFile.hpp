@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+// The reading of a file by O_DIRECT: the page cache is bypassed, so a huge
+// cold file doesn't evict the working set of the other processes. The
+// offsets and the lengths of the reads are aligned to ALIGNMENT, the bytes
+// are read to the own page-aligned buffer and are used in place (see View).
+// A file system without the support of O_DIRECT is read through the page
+// cache.
+class DirectFile
+{
+public:
+	static constexpr std::size_t ALIGNMENT = 4096;
+	static constexpr std::size_t MAX_VIEW  = 8 * 1024 * 1024;
+
+	DirectFile(DirectFile const&)             = delete;
+	DirectFile& operator= (DirectFile const&) = delete;
+	DirectFile(DirectFile&&)                  = delete;
+	DirectFile& operator= (DirectFile&&)      = delete;
+
+	explicit DirectFile(char const* name);
+	~DirectFile();
+
+	// Returns the number of the bytes [offset, offset + size) which `data`
+	// points to: fewer than `size` at the end of the file only. `size` must
+	// not exceed MAX_VIEW; the bytes are valid until the next call.
+	std::size_t View(uint8_t const*& data, std::uint64_t offset, std::size_t size);
+
+	std::uint64_t GetSize() const noexcept { return m_size; }
+	char const* GetName() const noexcept   { return m_name; }
+
+private:
+	void Fill(std::uint64_t begin, std::uint64_t end);
+
+private:
+	char const*   m_name;
+	int           m_fd     = -1;
+	std::uint64_t m_size   = 0;
+	uint8_t*      m_buffer = nullptr; // MAX_VIEW + 2 * ALIGNMENT bytes
+	std::uint64_t m_begin  = 0;       // the file offsets of m_buffer
+	std::uint64_t m_end    = 0;
+};
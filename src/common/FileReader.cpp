@@ -1,15 +1,61 @@
 #include "FileReader.hpp"
 
+#include <algorithm>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <limits>
 
+#include <cstring>
 
+#include "Logger.hpp"
 
-FileReader::FileReader(char const* name)
+
+
+namespace {
+
+// The mapped bytes which the kernel is asked to read ahead at once
+constexpr std::size_t WILLNEED_SIZE = 8 * 1024 * 1024;
+
+} // namespace
+
+
+
+FileReader::FileReader(char const* name, io_e io, std::size_t queue_depth, std::size_t view_size,
+                       std::size_t arena_size)
 	: m_name(name)
 {
 	if (not m_name) { m_name = DEFAULT_NAME.data(); }
+	if (io != io_e::STREAM and DEFAULT_NAME == m_name)
+	{
+		THROW_ERROR("%s: %s can't be read by io=%s", __FUNCTION__, m_name, ::toString(io));
+	}
+	if (io == io_e::MMAP)
+	{
+		m_map = std::make_unique<MappedFile>(m_name);
+		m_map->AdviseSequential();
+		m_map->AdviseHugePages();
+		return;
+	}
+	if (io == io_e::DIRECT)
+	{
+		m_direct = std::make_unique<DirectFile>(m_name);
+		return;
+	}
+	if (io == io_e::URING and UringFile::IsAvailable())
+	{
+		//NOTE: the ring and the registered file need the locked memory
+		// (RLIMIT_MEMLOCK) which can be exhausted by the other readers
+		try
+		{
+			m_uring = std::make_unique<UringFile>(m_name, queue_depth, view_size, arena_size);
+			return;
+		}
+		catch (std::exception const& ex)
+		{
+			LOG_W("%s: [%s] is read by io=stream: %s", __FUNCTION__, m_name, ex.what());
+		}
+	}
 	m_in.reset(DEFAULT_NAME == m_name
 	           ? &std::cin
 	           : new std::ifstream(m_name, std::ios::binary));
@@ -34,6 +80,35 @@ std::size_t
 FileReader::Read(char* buf_data, std::size_t buf_size)
 {
 	if (not buf_data or 0 == buf_size) { return 0; }
+	if (m_uring)
+	{
+		std::size_t read_bytes = 0;
+		while (read_bytes < buf_size)
+		{
+			uint8_t const* data = nullptr;
+			std::size_t const viewed = m_uring->View(data, m_pos,
+				std::min(buf_size - read_bytes, UringFile::MAX_VIEW));
+			if (viewed == 0) { break; }
+			std::memcpy(buf_data + read_bytes, data, viewed);
+			read_bytes += viewed;
+			m_pos      += viewed;
+		}
+		return read_bytes;
+	}
+	if (m_map or m_direct)
+	{
+		std::size_t read_bytes = 0;
+		while (read_bytes < buf_size)
+		{
+			uint8_t const* data = nullptr;
+			std::size_t const size = std::min(buf_size - read_bytes, GetMaxView());
+			std::size_t const viewed = Read(data, nullptr, size);
+			if (viewed != 0) { std::memcpy(buf_data + read_bytes, data, viewed); }
+			read_bytes += viewed;
+			if (viewed < size) { break; }
+		}
+		return read_bytes;
+	}
 	m_in->read(buf_data, buf_size); //NOTE: can throws exception
 	return m_in->gcount();
 }
@@ -46,10 +121,101 @@ FileReader::Read(uint8_t* buf_data, std::size_t buf_size)
 }
 
 
+std::size_t
+FileReader::Read(uint8_t const*& data, uint8_t* buf_data, std::size_t size)
+{
+	if (m_uring)
+	{
+		//NOTE: the view ends at the end of a read ahead: the rest is copied
+		std::size_t const read_bytes = m_uring->View(data, m_pos, size);
+		if (read_bytes == size or read_bytes == 0) { m_pos += read_bytes; return read_bytes; }
+		std::memcpy(buf_data, data, read_bytes);
+		m_pos += read_bytes;
+		data = buf_data;
+		return read_bytes + Read(buf_data + read_bytes, size - read_bytes);
+	}
+	if (m_direct and size <= DirectFile::MAX_VIEW)
+	{
+		std::size_t const read_bytes = m_direct->View(data, m_pos, size);
+		m_pos += read_bytes;
+		return read_bytes;
+	}
+	if (not m_map)
+	{
+		data = buf_data;
+		return Read(buf_data, size);
+	}
+
+	std::uintmax_t const file_size = m_map->GetSize();
+	if (m_pos >= file_size) { return 0; }
+	std::size_t const read_bytes = static_cast<std::size_t>(std::min<std::uintmax_t>(size, file_size - m_pos));
+	AdviseWillNeed(read_bytes);
+	data   = m_map->GetData() + m_pos;
+	m_pos += read_bytes;
+	return read_bytes;
+}
+
+
 void
 FileReader::SkipNextBytes(std::uintmax_t offset)
 {
 	if (offset == 0) { return; }
+	if (m_map or m_direct or m_uring)
+	{
+		m_pos += offset;
+		return;
+	}
 	m_in->seekg(offset, std::ios_base::cur);
 }
 
+
+void
+FileReader::SetPosition(std::uintmax_t offset)
+{
+	if (m_map or m_direct or m_uring)
+	{
+		m_pos = offset;
+		return;
+	}
+	m_in->clear(); // the previous reading could reach EOF
+	m_in->seekg(offset, std::ios_base::beg);
+}
+
+
+std::size_t
+FileReader::GetMaxView() const noexcept
+{
+	if (m_map)    { return std::numeric_limits<std::size_t>::max(); }
+	if (m_direct) { return DirectFile::MAX_VIEW; }
+	return 0;
+}
+
+
+// The Workers stride through the file, so the page faults of the mapping
+// would read it by small pieces: the pages are requested by big ranges
+// ahead of the current position.
+void
+FileReader::AdviseWillNeed(std::size_t size) noexcept
+{
+	std::uintmax_t const end = m_pos + size;
+	if (m_advisedBegin <= m_pos and end <= m_advisedEnd) { return; }
+	std::size_t const length = std::max(size, WILLNEED_SIZE);
+	m_map->AdviseWillNeed(static_cast<std::size_t>(m_pos), length);
+	m_advisedBegin = m_pos;
+	m_advisedEnd   = m_pos + length;
+}
+
+
+
+char const*
+toString(FileReader::io_e v)
+{
+	switch (v)
+	{
+	case FileReader::io_e::STREAM: return "stream";
+	case FileReader::io_e::MMAP:   return "mmap";
+	case FileReader::io_e::DIRECT: return "direct";
+	case FileReader::io_e::URING:  return "uring";
+	}
+	return "unknown";
+}
@@ -6,6 +6,10 @@
 
 #include <cstdint>
 
+#include "MappedFile.hpp"
+#include "DirectFile.hpp"
+#include "UringFile.hpp"
+
 
 
 class FileReader
@@ -13,25 +17,55 @@ class FileReader
 public:
 	static constexpr std::string_view DEFAULT_NAME {"stdin"};
 
+	enum class io_e : uint8_t
+	{
+		STREAM, // std::istream, the bytes are copied to the caller's buffer
+		MMAP,   // the file is mapped, the bytes are read without a copy
+		DIRECT, // O_DIRECT reads to the aligned buffer (see DirectFile)
+		URING,  // asynchronous reads ahead (see UringFile)
+	};
+
 	FileReader(FileReader const&)             = delete;
 	FileReader& operator= (FileReader const&) = delete;
 	FileReader(FileReader&&)                  = default;
 	FileReader& operator= (FileReader&&)      = default;
 
-	FileReader(char const* name);
+	// `queue_depth`, `view_size` and `arena_size` are the reads ahead of
+	// io_e::URING (see UringFile), io_e::STREAM is used when io_uring isn't
+	// available or can't be set up
+	FileReader(char const* name, io_e io = io_e::STREAM,
+	           std::size_t queue_depth = UringFile::DEFAULT_QUEUE_DEPTH, std::size_t view_size = 0,
+	           std::size_t arena_size = UringFile::MAX_ARENA_SIZE);
 	~FileReader();
 
 	std::size_t Read(char* buf_data, std::size_t buf_size);
 	std::size_t Read(uint8_t* buf_data, std::size_t buf_size);
+	// Reads up to `size` next bytes, `data` points to them: to the mapping
+	// (io_e::MMAP), to the buffer of DirectFile or UringFile or to `buf_data`
+	// where they were copied. `buf_data` must have `size` bytes when it
+	// exceeds GetMaxView(). The bytes are valid until the next reading.
+	std::size_t Read(uint8_t const*& data, uint8_t* buf_data, std::size_t size);
 	void SkipNextBytes(std::uintmax_t offset);
+	void SetPosition(std::uintmax_t offset);
 
 	char const* GetName() const noexcept { return m_name; }
+	bool IsMapped() const noexcept       { return static_cast<bool>(m_map); }
+	// The maximum size which Read reads without a copy
+	std::size_t GetMaxView() const noexcept;
 
 private:
 	void DetachStandardStreams() noexcept;
+	void AdviseWillNeed(std::size_t size) noexcept;
 
 private:
 	char const*                      m_name;
 	std::unique_ptr<std::istream>    m_in;
+	std::unique_ptr<MappedFile>      m_map;               // io_e::MMAP
+	std::unique_ptr<DirectFile>      m_direct;            // io_e::DIRECT
+	std::unique_ptr<UringFile>       m_uring;             // io_e::URING
+	std::uintmax_t                   m_pos = 0;           // in m_map, m_direct or m_uring
+	std::uintmax_t                   m_advisedBegin = 0;  // the last MADV_WILLNEED
+	std::uintmax_t                   m_advisedEnd   = 0;
 };
 
+char const* toString(FileReader::io_e);
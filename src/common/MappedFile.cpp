@@ -0,0 +1,81 @@
+#include "MappedFile.hpp"
+
+#include <algorithm>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Logger.hpp"
+
+
+
+MappedFile::MappedFile(char const* name)
+	: m_name(name)
+{
+	int const fd = ::open(m_name, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		THROW_ERROR("%s: can't open [%s]: %s", __FUNCTION__, m_name, std::strerror(errno));
+	}
+
+	struct stat st {};
+	if (::fstat(fd, &st) != 0)
+	{
+		int const err = errno;
+		::close(fd);
+		THROW_ERROR("%s: can't get the size of [%s]: %s", __FUNCTION__, m_name, std::strerror(err));
+	}
+	m_size = static_cast<std::size_t>(st.st_size);
+	if (m_size > 0)
+	{
+		void* const data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			int const err = errno;
+			::close(fd);
+			THROW_ERROR("%s: can't map [%s]: %s", __FUNCTION__, m_name, std::strerror(err));
+		}
+		m_data = static_cast<uint8_t const*>(data);
+	}
+	//NOTE: the mapping stays valid after closing the descriptor
+	::close(fd);
+}
+
+
+MappedFile::~MappedFile()
+{
+	if (m_data) { ::munmap(const_cast<uint8_t*>(m_data), m_size); }
+}
+
+
+void
+MappedFile::AdviseSequential() noexcept
+{
+	if (m_data) { ::madvise(const_cast<uint8_t*>(m_data), m_size, MADV_SEQUENTIAL); }
+}
+
+
+void
+MappedFile::AdviseWillNeed(std::size_t offset, std::size_t size) noexcept
+{
+	if (not m_data or offset >= m_size) { return; }
+	// the address must be aligned to the page
+	static std::size_t const page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+	std::size_t const begin = offset - offset % page_size;
+	std::size_t const end   = std::min(m_size, offset + size);
+	::madvise(const_cast<uint8_t*>(m_data) + begin, end - begin, MADV_WILLNEED);
+}
+
+
+void
+MappedFile::AdviseHugePages() noexcept
+{
+#if defined(MADV_HUGEPAGE)
+	if (m_data) { ::madvise(const_cast<uint8_t*>(m_data), m_size, MADV_HUGEPAGE); }
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+// A read-only mapping of the whole file
+class MappedFile
+{
+public:
+	MappedFile(MappedFile const&)             = delete;
+	MappedFile& operator= (MappedFile const&) = delete;
+	MappedFile(MappedFile&&)                  = delete;
+	MappedFile& operator= (MappedFile&&)      = delete;
+
+	explicit MappedFile(char const* name);
+	~MappedFile();
+
+	// The kernel reads ahead more aggressively and drops the read pages
+	// earlier (madvise)
+	void AdviseSequential() noexcept;
+	// The kernel starts reading the bytes [offset, offset + size) now
+	void AdviseWillNeed(std::size_t offset, std::size_t size) noexcept;
+	// The transparent huge pages for the mapping (when the kernel supports
+	// them for the page cache), fewer TLB misses
+	void AdviseHugePages() noexcept;
+
+	uint8_t const* GetData() const noexcept { return m_data; }
+	std::size_t GetSize() const noexcept    { return m_size; }
+	char const* GetName() const noexcept    { return m_name; }
+
+private:
+	char const*    m_name;
+	uint8_t const* m_data = nullptr; // nullptr for an empty file
+	std::size_t    m_size = 0;
+};
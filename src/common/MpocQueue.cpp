@@ -1,4 +1,7 @@
 #include "MpocQueue.hpp"
+
+#include <thread>
+
 #include "MpocQueueItem.hpp"
 #include "MpocQueueProducer.hpp"
 
@@ -38,7 +41,7 @@ MpocQueue::item_t* MpocQueue::pop(uint32_t timeout_ms /*= USE_DEFAULT_TIMEOUT*/)
 	item_t* act_tail = m_tail.load();
 	if (act_head != act_tail)
 	{
-		m_head.store(act_head->next());
+		m_head.store(WaitNext(*act_head));
 	}
 	else
 	{
@@ -55,7 +58,7 @@ MpocQueue::item_t* MpocQueue::pop(uint32_t timeout_ms /*= USE_DEFAULT_TIMEOUT*/)
 		{
 			// The tail forgetting is fail. It means that the tail was changed
 			// and someone add a new item to the head.
-			m_head.store(act_head->next());
+			m_head.store(WaitNext(*act_head));
 		}
 	}
 	act_head->next(nullptr);
@@ -63,6 +66,21 @@ MpocQueue::item_t* MpocQueue::pop(uint32_t timeout_ms /*= USE_DEFAULT_TIMEOUT*/)
 }
 
 
+// static
+MpocQueue::item_t* MpocQueue::WaitNext(item_t& item) noexcept
+{
+	//NOTE: the producer has already replaced the tail but hasn't linked the
+	// new item yet (see push): it is a matter of a few instructions.
+	item_t* next = item.next();
+	while (not next)
+	{
+		std::this_thread::yield();
+		next = item.next();
+	}
+	return next;
+}
+
+
 void MpocQueue::push(MpocQueue::item_t& item) noexcept
 {
 	// The `memory_order`s were taken from
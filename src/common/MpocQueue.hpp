@@ -63,6 +63,7 @@ private:
 	{}
 
 	void push(item_t&) noexcept;
+	static item_t* WaitNext(item_t&) noexcept;
 	void RegisterProducer(producer_t const&) noexcept;
 	void DeregisterProducer(producer_t const&) noexcept;
 
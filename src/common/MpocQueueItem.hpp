@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 
 
 class MpocQueue;
@@ -9,9 +11,9 @@ class MpocQueueItem
 private:
 	friend class MpocQueue;
 
-	void next(MpocQueueItem* item) noexcept { m_next = item; }
-	MpocQueueItem* next() noexcept          { return m_next; }
+	void next(MpocQueueItem* item) noexcept { m_next.store(item); }
+	MpocQueueItem* next() noexcept          { return m_next.load(); }
 
 private:
-	MpocQueueItem*   m_next {nullptr};
+	std::atomic<MpocQueueItem*>   m_next {nullptr};
 };
@@ -48,6 +48,7 @@ public:
 			std::size_t last_item = m_pool.size();
 			m_pool.resize(last_item + m_inc_size);
 			item = &m_pool[last_item];
+			m_next = last_item + 1;
 		}
 		static_cast<PoolItem*>(item)->Allocate();
 		return *item;
@@ -60,15 +61,29 @@ public:
 	bool IsFree() const      { return m_isFree; }
 
 private:
+	//NOTE: the search starts after the last allocated item and checks at most
+	// `m_inc_size` items (circularly). The items are released mostly in the
+	// order of allocation, so the free one is there if any; otherwise the pool
+	// grows instead of scanning all items on each allocation.
 	T* GetFree()
 	{
-		auto it = std::find_if(m_pool.begin(), m_pool.end(),
-		                       [](T const& item) { return item.IsFree(); });
-		return it == m_pool.end() ? nullptr : &*it;
+		std::size_t const size = m_pool.size();
+		std::size_t const attempts = std::min(size, m_inc_size);
+		for (std::size_t i = 0; i < attempts; ++i)
+		{
+			std::size_t const pos = (m_next + i) % size;
+			if (m_pool[pos].IsFree())
+			{
+				m_next = pos + 1;
+				return &m_pool[pos];
+			}
+		}
+		return nullptr;
 	}
 
 private:
 	std::size_t   m_inc_size;
+	std::size_t   m_next     = 0; // the position to start the search from
 	std::deque<T> m_pool;
 	bool          m_isFree   = true;
 };
@@ -0,0 +1,59 @@
+#include "SparseMap.hpp"
+
+#include <algorithm>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Logger.hpp"
+
+
+
+SparseMap::SparseMap(char const* name, std::uint64_t file_size)
+{
+	int const fd = ::open(name, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		THROW_ERROR("%s: can't open [%s]: %s", __FUNCTION__, name, std::strerror(errno));
+	}
+
+	for (std::uint64_t pos = 0; pos < file_size; )
+	{
+		off_t const data = ::lseek(fd, static_cast<off_t>(pos), SEEK_DATA);
+		if (data < 0)
+		{
+			//NOTE: ENXIO: no data after `pos`
+			if (errno != ENXIO) { m_data.assign({{pos, file_size}}); }
+			break;
+		}
+		off_t const hole = ::lseek(fd, data, SEEK_HOLE);
+		std::uint64_t const end = (hole < 0) ? file_size : std::min<std::uint64_t>(hole, file_size);
+		m_data.push_back({static_cast<std::uint64_t>(data), end});
+		pos = end;
+	}
+	::close(fd);
+}
+
+
+
+bool
+SparseMap::IsHole(std::uint64_t begin, std::uint64_t end) const noexcept
+{
+	// the first extent which ends after `begin`
+	auto const it = std::upper_bound(m_data.begin(), m_data.end(), begin,
+		[](std::uint64_t pos, Extent const& ext) { return pos < ext.end; });
+	return it == m_data.end() or it->begin >= end;
+}
+
+
+
+std::uint64_t
+SparseMap::GetDataSize() const noexcept
+{
+	std::uint64_t size = 0;
+	for (Extent const& ext : m_data) { size += ext.end - ext.begin; }
+	return size;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include <cstdint>
+
+
+
+// The data extents of a (sparse) file found by lseek(SEEK_DATA/SEEK_HOLE):
+// the holes are read as zeros without any I/O, so the reading of them can
+// be skipped. A file system without the support of SEEK_DATA reports the
+// whole file as data.
+class SparseMap
+{
+public:
+	SparseMap(SparseMap const&)             = delete;
+	SparseMap& operator= (SparseMap const&) = delete;
+	SparseMap(SparseMap&&)                  = default;
+	SparseMap& operator= (SparseMap&&)      = default;
+
+	SparseMap(char const* name, std::uint64_t file_size);
+	~SparseMap() = default;
+
+	// [begin, end) has no data
+	bool IsHole(std::uint64_t begin, std::uint64_t end) const noexcept;
+	std::uint64_t GetDataSize() const noexcept;
+
+private:
+	struct Extent
+	{
+		std::uint64_t begin;
+		std::uint64_t end;
+	};
+
+	std::vector<Extent> m_data; // ascending
+};
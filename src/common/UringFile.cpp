@@ -0,0 +1,459 @@
+#include "UringFile.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Logger.hpp"
+
+
+
+namespace {
+
+constexpr std::size_t ALIGNMENT = 4096;
+
+// The registered buffers of all readers (see UringFile::MAX_PINNED_SIZE)
+std::atomic<std::size_t> g_pinnedSize {0};
+
+
+
+int
+SysSetup(unsigned entries, io_uring_params& params) noexcept
+{
+	return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+
+
+int
+SysEnter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags) noexcept
+{
+	return static_cast<int>(::syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags, nullptr, 0));
+}
+
+
+
+int
+SysRegister(int ring, unsigned opcode, void const* arg, unsigned nr_args) noexcept
+{
+	return static_cast<int>(::syscall(__NR_io_uring_register, ring, opcode, arg, nr_args));
+}
+
+} // namespace
+
+
+
+// static
+bool
+UringFile::IsAvailable() noexcept
+{
+	static bool const available = []()
+	{
+		io_uring_params params {};
+		int const ring = SysSetup(1, params);
+		if (ring < 0)
+		{
+			LOG_W("%s: io_uring isn't available: %s", __FUNCTION__, std::strerror(errno));
+			return false;
+		}
+		::close(ring);
+		return true;
+	}();
+	return available;
+}
+
+
+
+UringFile::UringFile(char const* name, std::size_t queue_depth, std::size_t view_size,
+                     std::size_t arena_size)
+	: m_name(name)
+{
+	m_slotSize   = (view_size == 0) ? MAX_VIEW : std::min(view_size, MAX_VIEW);
+	m_slotStride = (m_slotSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	queue_depth  = std::clamp<std::size_t>(
+		std::min(queue_depth, arena_size / m_slotStride), 1, MAX_QUEUE_DEPTH);
+
+	m_fd = ::open(m_name, O_RDONLY | O_CLOEXEC);
+	if (m_fd < 0)
+	{
+		THROW_ERROR("%s: can't open [%s]: %s", __FUNCTION__, m_name, std::strerror(errno));
+	}
+	struct stat st {};
+	if (::fstat(m_fd, &st) != 0)
+	{
+		int const err = errno;
+		::close(m_fd);
+		THROW_ERROR("%s: can't get the size of [%s]: %s", __FUNCTION__, m_name, std::strerror(err));
+	}
+	m_size = static_cast<std::uint64_t>(st.st_size);
+
+	m_arena = static_cast<uint8_t*>(std::aligned_alloc(ALIGNMENT, m_slotStride * queue_depth));
+	if (not m_arena)
+	{
+		::close(m_fd);
+		THROW_ERROR("%s: can't allocate %zu bytes", __FUNCTION__, m_slotStride * queue_depth);
+	}
+	m_slots.resize(queue_depth);
+	for (std::size_t i = 0; i < queue_depth; ++i)
+	{
+		m_slots[i] = {m_arena + i * m_slotStride, 0, 0, 0, 0, true};
+		m_free.push_back(queue_depth - 1 - i);
+	}
+
+	try
+	{
+		SetupRing(static_cast<unsigned>(queue_depth));
+		RegisterResources();
+	}
+	catch (...)
+	{
+		if (m_ringData) { ::munmap(m_ringData, m_ringDataSize); }
+		if (m_sqes) { ::munmap(m_sqes, m_sqesSize); }
+		if (m_ring >= 0) { ::close(m_ring); }
+		std::free(m_arena);
+		::close(m_fd);
+		throw;
+	}
+}
+
+
+
+UringFile::~UringFile()
+{
+	//NOTE: the kernel writes to the buffers until the reads are completed
+	Drain();
+	if (m_fixedBuffers) { g_pinnedSize -= m_slots.size() * m_slotStride; }
+	::munmap(m_sqes, m_sqesSize);
+	::munmap(m_ringData, m_ringDataSize);
+	::close(m_ring);
+	std::free(m_arena);
+	::close(m_fd);
+}
+
+
+
+void
+UringFile::SetupRing(unsigned entries)
+{
+	io_uring_params params {};
+	m_ring = SysSetup(entries, params);
+	if (m_ring < 0)
+	{
+		THROW_ERROR("%s: io_uring_setup failed: %s", __FUNCTION__, std::strerror(errno));
+	}
+	if (not (params.features & IORING_FEAT_SINGLE_MMAP))
+	{
+		THROW_ERROR("%s: the kernel is too old for io_uring (no IORING_FEAT_SINGLE_MMAP)", __FUNCTION__);
+	}
+
+	// the SQ and CQ rings are mapped together
+	m_ringDataSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+	                          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+	m_ringData = ::mmap(nullptr, m_ringDataSize, PROT_READ | PROT_WRITE,
+	                    MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+	if (m_ringData == MAP_FAILED)
+	{
+		m_ringData = nullptr;
+		THROW_ERROR("%s: can't map the rings: %s", __FUNCTION__, std::strerror(errno));
+	}
+	m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* const sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+	                          MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		THROW_ERROR("%s: can't map the SQEs: %s", __FUNCTION__, std::strerror(errno));
+	}
+	m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+	auto* const base = static_cast<uint8_t*>(m_ringData);
+	m_sqTail  = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+	m_sqMask  = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+	m_sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+	m_cqHead  = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+	m_cqTail  = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+	m_cqMask  = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+	m_cqes    = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+}
+
+
+
+// The registered file and buffers save the lookups and the page pinning per
+// read. The buffers are pinned memory (RLIMIT_MEMLOCK, MAX_PINNED_SIZE of all
+// readers): without them the plain IORING_OP_READ is used.
+void
+UringFile::RegisterResources()
+{
+	if (SysRegister(m_ring, IORING_REGISTER_FILES, &m_fd, 1) < 0)
+	{
+		THROW_ERROR("%s: can't register [%s]: %s", __FUNCTION__, m_name, std::strerror(errno));
+	}
+
+	std::size_t const arena_size = m_slots.size() * m_slotStride;
+	std::size_t pinned = g_pinnedSize.load();
+	do
+	{
+		if (pinned + arena_size > MAX_PINNED_SIZE)
+		{
+			LOG_D("%s: %zu bytes are pinned already, IORING_OP_READ is used",
+			      __FUNCTION__, pinned);
+			return;
+		}
+	}
+	while (not g_pinnedSize.compare_exchange_weak(pinned, pinned + arena_size));
+
+	std::vector<iovec> buffers(m_slots.size());
+	for (std::size_t i = 0; i < m_slots.size(); ++i)
+	{
+		buffers[i] = {m_slots[i].data, m_slotSize};
+	}
+	m_fixedBuffers = SysRegister(m_ring, IORING_REGISTER_BUFFERS, buffers.data(),
+	                             static_cast<unsigned>(buffers.size())) == 0;
+	if (not m_fixedBuffers)
+	{
+		LOG_D("%s: can't register the buffers (%s), IORING_OP_READ is used",
+		      __FUNCTION__, std::strerror(errno));
+		g_pinnedSize -= arena_size;
+	}
+}
+
+
+
+std::size_t
+UringFile::View(uint8_t const*& data, std::uint64_t offset, std::size_t size)
+{
+	if (offset >= m_size or size == 0) { return 0; }
+	std::uint64_t const end = std::min<std::uint64_t>(offset + std::min(size, m_slotSize), m_size);
+
+	// the reads before `offset` were skipped (e.g. the holes)
+	while (not m_queue.empty() and m_slots[m_queue.front()].end <= offset)
+	{
+		Wait(m_queue.front());
+		m_free.push_back(m_queue.front());
+		m_queue.pop_front();
+	}
+	if (m_queue.empty() or m_slots[m_queue.front()].begin > offset)
+	{
+		Drain();
+		Read(offset, end);
+	}
+
+	std::size_t const idx = m_queue.front();
+	Slot const& slot = m_slots[idx];
+	Wait(idx);
+	if (slot.error != 0)
+	{
+		THROW_ERROR("%s: can't read [%s] at %ju: %s",
+			__FUNCTION__, m_name, slot.begin + slot.ready, std::strerror(slot.error));
+	}
+	if (slot.end <= offset)
+	{
+		THROW_ERROR("%s: unexpected end of [%s] at %ju (expected %ju)",
+			__FUNCTION__, m_name, slot.end, end);
+	}
+
+	std::uint64_t const view_end = std::min(end, slot.end);
+	data = slot.data + (offset - slot.begin);
+	Learn(offset, view_end);
+	Prefetch();
+	return static_cast<std::size_t>(view_end - offset);
+}
+
+
+
+void
+UringFile::Submit(std::size_t idx)
+{
+	Slot const& slot = m_slots[idx];
+	unsigned const tail = *m_sqTail;
+	io_uring_sqe& sqe = m_sqes[tail & m_sqMask];
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode    = m_fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	sqe.flags     = IOSQE_FIXED_FILE;
+	sqe.fd        = 0; // the index of the registered file
+	sqe.addr      = reinterpret_cast<std::uintptr_t>(slot.data + slot.ready);
+	sqe.len       = static_cast<uint32_t>(slot.end - slot.begin - slot.ready);
+	sqe.off       = slot.begin + slot.ready;
+	sqe.buf_index = m_fixedBuffers ? static_cast<uint16_t>(idx) : 0;
+	sqe.user_data = idx;
+	m_sqArray[tail & m_sqMask] = tail & m_sqMask;
+	__atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+	++m_toSubmit;
+}
+
+
+
+// Submits the queued reads and waits for `wait_count` completions
+void
+UringFile::Enter(unsigned wait_count)
+{
+	unsigned const flags = (wait_count != 0) ? IORING_ENTER_GETEVENTS : 0;
+	while (m_toSubmit != 0 or wait_count != 0)
+	{
+		int const res = SysEnter(m_ring, m_toSubmit, wait_count, flags);
+		if (res < 0)
+		{
+			if (errno == EINTR) { continue; }
+			if (errno == EAGAIN or errno == EBUSY)
+			{
+				Reap();
+				continue;
+			}
+			THROW_ERROR("%s: io_uring_enter failed: %s", __FUNCTION__, std::strerror(errno));
+		}
+		m_toSubmit -= static_cast<unsigned>(res);
+		wait_count = 0;
+	}
+}
+
+
+
+void
+UringFile::Reap()
+{
+	unsigned head = *m_cqHead;
+	unsigned const tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+	for (; head != tail; ++head)
+	{
+		io_uring_cqe const& cqe = m_cqes[head & m_cqMask];
+		Slot& slot = m_slots[static_cast<std::size_t>(cqe.user_data)];
+		if (cqe.res == -EAGAIN or cqe.res == -EINTR)
+		{
+			Submit(static_cast<std::size_t>(cqe.user_data));
+			continue;
+		}
+		if (cqe.res < 0)
+		{
+			slot.error = -cqe.res;
+			slot.done  = true;
+			continue;
+		}
+		if (cqe.res == 0)
+		{
+			slot.end  = slot.begin + slot.ready; // the file was truncated
+			slot.done = true;
+			continue;
+		}
+		slot.ready += static_cast<std::uint64_t>(cqe.res);
+		slot.done   = (slot.begin + slot.ready == slot.end);
+		//NOTE: a short read: the rest is read again
+		if (not slot.done) { Submit(static_cast<std::size_t>(cqe.user_data)); }
+	}
+	__atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+}
+
+
+
+void
+UringFile::Wait(std::size_t idx)
+{
+	for (Reap(); not m_slots[idx].done; Reap())
+	{
+		Enter(1);
+	}
+}
+
+
+
+// Waits for the reads in flight and drops the read ones
+void
+UringFile::Drain() noexcept
+{
+	try
+	{
+		for (std::size_t idx : m_queue)
+		{
+			Wait(idx);
+			m_free.push_back(idx);
+		}
+	}
+	catch (std::exception const& ex)
+	{
+		LOG_E("%s: %s", __FUNCTION__, ex.what());
+	}
+	m_queue.clear();
+	m_isPredicting = false;
+}
+
+
+
+void
+UringFile::Read(std::uint64_t begin, std::uint64_t end)
+{
+	std::size_t const idx = m_free.back();
+	m_free.pop_back();
+	m_slots[idx] = {m_slots[idx].data, begin, end, 0, 0, false};
+	m_queue.push_back(idx);
+	Submit(idx);
+}
+
+
+
+void
+UringFile::Learn(std::uint64_t offset, std::uint64_t end) noexcept
+{
+	if (offset == m_lastEnd)
+	{
+		m_isSequential = true;
+	}
+	else
+	{
+		// a new run: the previous one gives its length and the stride
+		if (m_lastEnd != UINT64_MAX and offset > m_lastEnd)
+		{
+			std::uint64_t const length = m_lastEnd - m_runStart;
+			std::uint64_t const stride = offset - m_runStart;
+			m_isConfident = (length == m_runLength and stride == m_runStride);
+			m_runLength   = length;
+			m_runStride   = stride;
+		}
+		else
+		{
+			m_isConfident = false;
+			m_runLength   = 0;
+		}
+		m_runStart     = offset;
+		m_isSequential = false;
+	}
+	m_lastEnd = end;
+}
+
+
+
+// Fills the free slots by the predicted reads
+void
+UringFile::Prefetch()
+{
+	if (not m_isConfident and not m_isSequential) { return; }
+	if (not m_isPredicting)
+	{
+		m_isPredicting = true;
+		m_nextBegin    = m_lastEnd;
+		m_nextRunEnd   = (m_runLength != 0) ? m_runStart + m_runLength : m_size;
+		if (m_nextRunEnd < m_nextBegin) { m_nextRunEnd = m_size; }
+	}
+
+	while (not m_free.empty())
+	{
+		if (m_nextBegin >= m_nextRunEnd and m_runLength != 0)
+		{
+			m_nextBegin  = m_nextRunEnd - m_runLength + m_runStride;
+			m_nextRunEnd = m_nextBegin + m_runLength;
+		}
+		if (m_nextBegin >= m_size or m_nextBegin >= m_nextRunEnd) { break; }
+		std::uint64_t const end = std::min({m_nextBegin + m_slotSize, m_nextRunEnd, m_size});
+		Read(m_nextBegin, end);
+		m_nextBegin = end;
+	}
+	if (m_toSubmit != 0) { Enter(0); }
+}
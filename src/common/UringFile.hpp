@@ -0,0 +1,119 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+
+
+// The asynchronous reading by io_uring (the syscalls, a registered file and
+// registered buffers): up to `queue_depth` reads are in flight. The reads
+// ahead are predicted by the stride of the previous ones: a Worker reads the
+// runs of the same length (its blocks) with the same step, or the file
+// sequentially. A read which isn't predicted waits for the ones in flight
+// and is made synchronously.
+class UringFile
+{
+public:
+	static constexpr std::size_t MAX_VIEW            = 1024 * 1024;
+	static constexpr std::size_t MAX_QUEUE_DEPTH     = 4096;
+	static constexpr std::size_t DEFAULT_QUEUE_DEPTH = 32;
+	// The buffers of all readers: the callers split it (see `arena_size`)
+	static constexpr std::size_t MAX_ARENA_SIZE      = 256 * 1024 * 1024;
+	// The registered (pinned) buffers of all readers, the others use the
+	// plain IORING_OP_READ
+	static constexpr std::size_t MAX_PINNED_SIZE     = 64 * 1024 * 1024;
+
+	// io_uring can be disabled by the kernel (sysctl, seccomp, old kernel)
+	static bool IsAvailable() noexcept;
+
+	UringFile(UringFile const&)             = delete;
+	UringFile& operator= (UringFile const&) = delete;
+	UringFile(UringFile&&)                  = delete;
+	UringFile& operator= (UringFile&&)      = delete;
+
+	// `view_size` is the size of the reads ahead (a block, a batch of them):
+	// up to MAX_VIEW, 0 = MAX_VIEW. `arena_size` bounds the buffers of the
+	// reads in flight: a slot is kept at least, `queue_depth` at most.
+	UringFile(char const* name, std::size_t queue_depth, std::size_t view_size,
+	          std::size_t arena_size = MAX_ARENA_SIZE);
+	~UringFile();
+
+	// Returns the number of the bytes [offset, offset + size) which `data`
+	// points to: fewer than `size` at the end of a read ahead or the file.
+	// `size` must not exceed MAX_VIEW; the bytes are valid until the next
+	// call.
+	std::size_t View(uint8_t const*& data, std::uint64_t offset, std::size_t size);
+
+	std::uint64_t GetSize() const noexcept { return m_size; }
+	char const* GetName() const noexcept   { return m_name; }
+
+private:
+	struct Slot
+	{
+		uint8_t*      data;
+		std::uint64_t begin; // [begin, end) of the file
+		std::uint64_t end;   // is decreased at the end of the file
+		std::uint64_t ready; // the read bytes
+		int           error;
+		bool          done;
+	};
+
+	void SetupRing(unsigned entries);
+	void RegisterResources();
+	void Submit(std::size_t slot);
+	void Enter(unsigned wait_count);
+	void Reap();
+	void Wait(std::size_t slot);
+	void Drain() noexcept;
+	void Read(std::uint64_t begin, std::uint64_t end);
+	void Learn(std::uint64_t offset, std::uint64_t end) noexcept;
+	void Prefetch();
+
+private:
+	char const*        m_name;
+	int                m_fd   = -1;
+	int                m_ring = -1;
+	std::uint64_t      m_size = 0;
+
+	// the rings shared with the kernel
+	void*              m_ringData     = nullptr;
+	std::size_t        m_ringDataSize = 0;
+	io_uring_sqe*      m_sqes         = nullptr;
+	std::size_t        m_sqesSize     = 0;
+	unsigned*          m_sqTail  = nullptr;
+	unsigned           m_sqMask  = 0;
+	unsigned*          m_sqArray = nullptr;
+	unsigned*          m_cqHead  = nullptr;
+	unsigned*          m_cqTail  = nullptr;
+	unsigned           m_cqMask  = 0;
+	io_uring_cqe*      m_cqes    = nullptr;
+	unsigned           m_toSubmit = 0;
+	bool               m_fixedBuffers = false; // IORING_OP_READ_FIXED
+
+	uint8_t*                 m_arena    = nullptr; // the buffers of the slots
+	std::size_t              m_slotSize = 0;
+	std::size_t              m_slotStride = 0; // m_slotSize aligned
+	std::vector<Slot>        m_slots;
+	std::deque<std::size_t>  m_queue; // the slots in flight or read, by the offset
+	std::vector<std::size_t> m_free;
+
+	// The stride of the reads: the runs of m_runLength bytes each
+	// m_runStride bytes (0 = unknown)
+	std::uint64_t      m_lastEnd      = UINT64_MAX;
+	std::uint64_t      m_runStart     = 0;
+	std::uint64_t      m_runLength    = 0;
+	std::uint64_t      m_runStride    = 0;
+	bool               m_isConfident  = false; // two runs have the stride
+	bool               m_isSequential = false; // the run has two reads at least
+	bool               m_isPredicting = false;
+	std::uint64_t      m_nextBegin    = 0;     // the next read ahead
+	std::uint64_t      m_nextRunEnd   = 0;
+};
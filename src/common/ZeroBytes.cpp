@@ -0,0 +1,83 @@
+#include "ZeroBytes.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "CpuFeatures.hpp"
+
+
+
+namespace {
+
+bool
+AreZeroBytesPortable(uint8_t const* data, std::size_t size) noexcept
+{
+	std::size_t i = 0;
+	for (; i + 4 * sizeof(uint64_t) <= size; i += 4 * sizeof(uint64_t))
+	{
+		uint64_t v[4];
+		std::memcpy(v, data + i, sizeof(v));
+		if ((v[0] | v[1] | v[2] | v[3]) != 0) { return false; }
+	}
+	for (; i < size; ++i)
+	{
+		if (data[i] != 0) { return false; }
+	}
+	return true;
+}
+
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+bool
+AreZeroBytesAvx2(uint8_t const* data, std::size_t size) noexcept
+{
+	auto const* p = reinterpret_cast<__m256i const*>(data);
+	std::size_t i = 0;
+	for (; i + 256 <= size; i += 256, p += 8)
+	{
+		__m256i const v = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_loadu_si256(p + 0), _mm256_loadu_si256(p + 1)),
+				_mm256_or_si256(_mm256_loadu_si256(p + 2), _mm256_loadu_si256(p + 3))),
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_loadu_si256(p + 4), _mm256_loadu_si256(p + 5)),
+				_mm256_or_si256(_mm256_loadu_si256(p + 6), _mm256_loadu_si256(p + 7))));
+		if (not _mm256_testz_si256(v, v)) { return false; }
+	}
+	return AreZeroBytesPortable(data + i, size - i);
+}
+
+
+__attribute__((target("avx512f")))
+bool
+AreZeroBytesAvx512(uint8_t const* data, std::size_t size) noexcept
+{
+	std::size_t i = 0;
+	for (; i + 256 <= size; i += 256)
+	{
+		__m512i const v = _mm512_or_si512(
+			_mm512_or_si512(_mm512_loadu_si512(data + i),       _mm512_loadu_si512(data + i + 64)),
+			_mm512_or_si512(_mm512_loadu_si512(data + i + 128), _mm512_loadu_si512(data + i + 192)));
+		if (_mm512_test_epi64_mask(v, v) != 0) { return false; }
+	}
+	return AreZeroBytesPortable(data + i, size - i);
+}
+#endif // __x86_64__
+
+} // namespace
+
+
+
+bool
+AreZeroBytes(uint8_t const* data, std::size_t size) noexcept
+{
+#if defined(__x86_64__)
+	if (CpuFeatures::Has(CpuFeatures::AVX512F)) { return AreZeroBytesAvx512(data, size); }
+	if (CpuFeatures::Has(CpuFeatures::AVX2))    { return AreZeroBytesAvx2(data, size); }
+#endif
+	return AreZeroBytesPortable(data, size);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+
+// Returns true when all `size` bytes are zeros. It stops at the first
+// 256-byte stride with a non-zero byte, so the data costs almost nothing.
+bool AreZeroBytes(uint8_t const* data, std::size_t size) noexcept;
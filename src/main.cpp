@@ -1,10 +1,13 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <memory>
 
 #include "Config.hpp"
 #include "LoggerManager.hpp"
 #include "WorkerManager.hpp"
+#include "DeltaMaker.hpp"
+#include "SignatureComparer.hpp"
 
 
 
@@ -16,6 +19,9 @@ enum exit_codes_e : int
 	CONFIG_PARSE_ERROR,
 	WORKERS_START_ERROR,
 	WORKERS_RUNTIME_ERROR,
+	DELTA_ERROR,
+	SIGNATURES_DIFFER,
+	COMPARE_ERROR,
 };
 } // namespace
 
@@ -36,9 +42,38 @@ main(int argc, char** argv)
 	log_mgr.NotThreadSafe_SetLogfile(config.GetLogfile());
 	log_mgr.StartHandleMessagesInSeparateThread();
 
-	WorkerManager wrk_mgr(config);
-	if (not wrk_mgr.Start()) { return exit_codes_e::WORKERS_START_ERROR; }
-	return (wrk_mgr.DoWork())
+	if (config.GetCommand() == Config::command_e::DELTA)
+	{
+		DeltaMaker delta(config);
+		return (delta.Run())
+			? exit_codes_e::SUCCESS
+			: exit_codes_e::DELTA_ERROR;
+	}
+
+	if (config.GetCommand() == Config::command_e::COMPARE)
+	{
+		SignatureComparer comparer(config);
+		switch (comparer.Run())
+		{
+		case SignatureComparer::result_e::SAME:      return exit_codes_e::SUCCESS;
+		case SignatureComparer::result_e::DIFFERENT: return exit_codes_e::SIGNATURES_DIFFER;
+		case SignatureComparer::result_e::FAILED:    return exit_codes_e::COMPARE_ERROR;
+		}
+	}
+
+	//NOTE: the preparation reads the base signature (see Config::IsIncremental)
+	std::unique_ptr<WorkerManager> wrk_mgr;
+	try
+	{
+		wrk_mgr = std::make_unique<WorkerManager>(config);
+	}
+	catch (std::exception const& ex)
+	{
+		LOG_E("can't prepare the Workers: %s", ex.what());
+		return exit_codes_e::WORKERS_START_ERROR;
+	}
+	if (not wrk_mgr->Start()) { return exit_codes_e::WORKERS_START_ERROR; }
+	return (wrk_mgr->DoWork())
 		? exit_codes_e::SUCCESS
 		: exit_codes_e::WORKERS_RUNTIME_ERROR;
 }